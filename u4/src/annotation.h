@@ -71,6 +71,7 @@ public:
     void             remove(Annotation&);
     void             remove(Annotation::List);
     int              size();
+    const Annotation::List &getAll() const { return annotations; }
 
 private:        
     Annotation::List  annotations;
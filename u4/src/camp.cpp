@@ -214,7 +214,7 @@ void InnController::maybeMeetIsaac()
             for (ObjectDeque::iterator i = c->location->map->objects.begin();
                  i != c->location->map->objects.end();
                  i++) {
-                Person *p = dynamic_cast<Person*>(*i);
+                Person *p = toPerson(*i);
                 if (p && p->getName() == "Isaac") {
                     p->setCoords(coords);
                     return;
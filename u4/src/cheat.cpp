@@ -10,10 +10,14 @@
 #include "context.h"
 #include "game.h"
 #include "mapmgr.h"
+#include "memstats.h"
 #include "moongate.h"
 #include "portal.h"
 #include "player.h"
+#include "profile.h"
 #include "screen.h"
+#include "settings.h"
+#include "snapshot.h"
 #include "stats.h"
 #include "tileset.h"
 #include "utils.h"
@@ -63,6 +67,11 @@ bool CheatMenuController::keyPressed(int key) {
         screenMessage("Collision detection %s!\n", collisionOverride ? "off" : "on");
         break;
 
+    case 'd':
+        profiler.setOverlayShown(!profiler.isOverlayShown());
+        screenMessage("Profiler %s!\n", profiler.isOverlayShown() ? "on" : "off");
+        break;
+
     case 'e':
         screenMessage("Equipment!\n");
         for (i = ARMR_NONE + 1; i < ARMR_MAX; i++)
@@ -127,6 +136,7 @@ bool CheatMenuController::keyPressed(int key) {
                       "F1-F8 - +Virtue\n"
                       "a - Adv. Moons\n"
                       "c - Collision\n"
+                      "d - Profiler\n"
                       "e - Equipment\n"
                       "f - Full Stats\n"
                       "g - Goto\n"
@@ -142,21 +152,23 @@ bool CheatMenuController::keyPressed(int key) {
         screenMessage("\n"
                       "l - Location\n"
                       "m - Mixtures\n"
+                      "n - Snapshot\n"
                       "o - Opacity\n"
                       "p - Peer\n"
                       "r - Reagents\n"
                       "s - Summon\n"
                       "t - Transports\n"
+                      "u - Mem. Usage\n"
                       "v - Full Virtues\n"
                       "w - Change Wind\n"
-                      "x - Exit Map\n"
-                      "y - Y-up\n"
                       "(more)");
 
         eventHandler->pushController(&pauseController);
         pauseController.waitFor();
 
         screenMessage("\n"
+                      "x - Exit Map\n"
+                      "y - Y-up\n"
                       "z - Z-down\n"
                   );
         break;
@@ -214,6 +226,47 @@ bool CheatMenuController::keyPressed(int key) {
             c->saveGame->mixtures[i] = 99;
         break;
 
+    case 'n': {
+        static Snapshot snapshot;
+        string filename = settings.getUserPath() + "snapshot.sav";
+
+        screenMessage("Snapshot!\nTake, Restore,\nWrite or Load? ");
+        char choice = ReadChoiceController::get("trwl \033\015");
+
+        switch (choice) {
+        case 't':
+            if (snapshot.capture())
+                screenMessage("Taken\n%u bytes\n", snapshot.getSize());
+            else
+                screenMessage("Not here!\n");
+            break;
+        case 'r':
+            if (snapshot.restore(game)) {
+                screenMessage("Restored\n");
+                musicMgr->play();
+            }
+            else
+                screenMessage("None!\n");
+            break;
+        case 'w':
+            if (snapshot.write(filename))
+                screenMessage("Written\n");
+            else
+                screenMessage("Failed!\n");
+            break;
+        case 'l':
+            if (snapshot.read(filename))
+                screenMessage("Loaded\n%u bytes\n", snapshot.getSize());
+            else
+                screenMessage("Failed!\n");
+            break;
+        default:
+            screenMessage("\n");
+            break;
+        }
+        break;
+    }
+
     case 'o':
         c->opacity = !c->opacity;
         screenMessage("Opacity %s!\n", c->opacity ? "on" : "off");
@@ -301,6 +354,12 @@ bool CheatMenuController::keyPressed(int key) {
         }
         break;
 
+    case 'u':
+        screenMessage("Memory usage!\n");
+        memstats.show();
+        memstats.log();
+        break;
+
     case 'v':
         screenMessage("\nFull Virtues!\n");
         for (i = 0; i < 8; i++)
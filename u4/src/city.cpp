@@ -51,7 +51,7 @@ Person *City::addPerson(Person *person) {
     p->setMap(this);
     p->goToStartLocation();
 
-    objects.push_back(p);    
+    appendObject(p);
     return p;
 }
 
@@ -95,7 +95,7 @@ Person *City::personAt(const Coords &coords) {
 
     obj = objectAt(coords);
     if (isPerson(obj))
-        return dynamic_cast<Person*>(obj);    
+        return toPerson(obj);    
     else
         return NULL;
 }
@@ -4,6 +4,7 @@
 
 #include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
 
+#include <algorithm>
 #include <ctime>
 #include "u4.h"
 
@@ -404,20 +405,14 @@ int  CombatController::initialNumberOfCreatures(const Creature *creature) const
  * Returns true if the player has won.
  */
 bool CombatController::isWon() const {
-    CreatureVector creatures = map->getCreatures();    
-    if (creatures.size())
-        return false;    
-    return true;
+    return map->getCreatures().empty();
 }
 
 /**
  * Returns true if the player has lost.
  */
 bool CombatController::isLost() const {
-    PartyMemberVector party = map->getPartyMembers();
-    if (party.size())
-        return false;
-    return true;
+    return map->getPartyMembers().empty();
 }
 
 /**
@@ -425,16 +420,17 @@ bool CombatController::isLost() const {
  */
 void CombatController::moveCreatures() {
     Creature *m;
+    const CreatureVector &creatures = map->getCreatures();
 
     // XXX: this iterator is rather complex; but the vector::iterator can
     // break and crash if we delete elements while iterating it, which we do
     // if a jinxed monster kills another
-    for (unsigned int i = 0; i < map->getCreatures().size(); i++) {
-        m = map->getCreatures().at(i);
+    for (unsigned int i = 0; i < creatures.size(); i++) {
+        m = creatures[i];
         //GameController::doScreenAnimationsWhilePausing(1);
         m->act(this);
 
-        if (i < map->getCreatures().size() && map->getCreatures().at(i) != m) {
+        if (i < creatures.size() && creatures[i] != m) {
             // don't skip a later creature when an earlier one flees
             i--;
         }
@@ -471,7 +467,7 @@ void CombatController::placePartyMembers() {
             /* add the party member to the map */
             p->setCoords(map->player_start[i]);
             p->setMap(map);
-            map->objects.push_back(p);
+            map->addPartyMember(p);
             party[i] = p;
         }
     }
@@ -1145,28 +1141,19 @@ void CombatController::update(Party *party, PartyEvent &event) {
 CombatMap::CombatMap() : Map(), dungeonRoom(false), altarRoom(VIRT_NONE), contextual(false) {}
 
 /**
- * Returns a vector containing all of the creatures on the map
+ * Returns the creatures on the map, in the order they act.  The
+ * roster is kept up to date as creatures are added and removed, so a
+ * reference held while iterating sees creatures that are killed,
+ * flee or divide along the way.
  */ 
-CreatureVector CombatMap::getCreatures() {
-    ObjectDeque::iterator i;
-    CreatureVector creatures;
-    for (i = objects.begin(); i != objects.end(); i++) {
-        if (isCreature(*i) && !isPartyMember(*i))
-            creatures.push_back(dynamic_cast<Creature*>(*i));
-    }
+const CreatureVector &CombatMap::getCreatures() const {
     return creatures;
 }
 
 /**
- * Returns a vector containing all of the party members on the map
+ * Returns the party members on the map
  */ 
-PartyMemberVector CombatMap::getPartyMembers() {
-    ObjectDeque::iterator i;
-    PartyMemberVector party;
-    for (i = objects.begin(); i != objects.end(); i++) {
-        if (isPartyMember(*i))
-            party.push_back(dynamic_cast<PartyMember*>(*i));
-    }
+const PartyMemberVector &CombatMap::getPartyMembers() const {
     return party;
 }
 
@@ -1175,14 +1162,10 @@ PartyMemberVector CombatMap::getPartyMembers() {
  * NULL if otherwise.
  */ 
 PartyMember *CombatMap::partyMemberAt(Coords coords) {
-    PartyMemberVector party = getPartyMembers();
-    PartyMemberVector::iterator i;
+    std::vector<Object *> here;
     
-    for (i = party.begin(); i != party.end(); i++) {
-        if ((*i)->getCoords() == coords)
-            return *i;
-    }
-    return NULL;
+    getObjectsWithin(coords, 0, FILTER_PARTY, false, here);
+    return here.empty() ? NULL : toPartyMember(here.front());
 }
 
 /**
@@ -1190,14 +1173,45 @@ PartyMember *CombatMap::partyMemberAt(Coords coords) {
  * NULL if otherwise.
  */ 
 Creature *CombatMap::creatureAt(Coords coords) {
-    CreatureVector creatures = getCreatures();
-    CreatureVector::iterator i;
+    std::vector<Object *> here;
+
+    getObjectsWithin(coords, 0, FILTER_NON_PARTY, false, here);
+    return here.empty() ? NULL : toCreature(here.front());
+}
 
-    for (i = creatures.begin(); i != creatures.end(); i++) {
-        if ((*i)->getCoords() == coords)            
-            return *i;
+/**
+ * Places a party member on the map, after everything already on it.
+ */ 
+void CombatMap::addPartyMember(PartyMember *pm) {
+    appendObject(pm);
+}
+
+void CombatMap::objectAdded(Object *obj, bool atFront) {
+    if (isPartyMember(obj)) {
+        PartyMember *pm = toPartyMember(obj);
+        party.insert(atFront ? party.begin() : party.end(), pm);
+    }
+    else if (isCreature(obj)) {
+        Creature *m = toCreature(obj);
+        creatures.insert(atFront ? creatures.begin() : creatures.end(), m);
+    }
+}
+
+void CombatMap::objectRemoved(Object *obj) {
+    CreatureVector::iterator m = std::find(creatures.begin(), creatures.end(), obj);
+    if (m != creatures.end()) {
+        creatures.erase(m);
+        return;
     }
-    return NULL;
+
+    PartyMemberVector::iterator pm = std::find(party.begin(), party.end(), obj);
+    if (pm != party.end())
+        party.erase(pm);
+}
+
+void CombatMap::objectsCleared() {
+    creatures.clear();
+    party.clear();
 }
 
 /**
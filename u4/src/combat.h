@@ -131,10 +131,11 @@ class CombatMap : public Map {
 public:
     CombatMap();
         
-    CreatureVector getCreatures();
-    PartyMemberVector getPartyMembers();
+    const CreatureVector &getCreatures() const;
+    const PartyMemberVector &getPartyMembers() const;
     PartyMember* partyMemberAt(Coords coords);    
     Creature* creatureAt(Coords coords);    
+    void addPartyMember(PartyMember *pm);
     
     static MapId mapForTile(const Tile *ground, const Tile *transport, Object *obj);
 
@@ -151,10 +152,18 @@ public:
     
     // Properties
 protected:
+    virtual void objectAdded(Object *obj, bool atFront);
+    virtual void objectRemoved(Object *obj);
+    virtual void objectsCleared();
+
     bool dungeonRoom;
     BaseVirtue altarRoom;
     bool contextual;
 
+    /* rosters of the objects on the map, kept in the same order */
+    CreatureVector creatures;
+    PartyMemberVector party;
+
 public:
     Coords creature_start[AREA_CREATURES];
     Coords player_start[AREA_PLAYERS];
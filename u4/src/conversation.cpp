@@ -5,8 +5,10 @@
 #include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
 
 #include <cstring>
+#include <set>
 #include "conversation.h"
 #include "debug.h"
+#include "memstats.h"
 #include "person.h"
 #include "script.h"
 #ifdef IOS
@@ -41,6 +43,16 @@ const vector<ResponsePart> &Response::getParts() const {
     return parts;
 }
 
+/**
+ * Returns the bytes held by the response and its parts.
+ */
+size_t Response::getMemBytes() const {
+    size_t bytes = sizeof(Response) + (parts.capacity() - parts.size()) * sizeof(ResponsePart);
+    for (vector<ResponsePart>::const_iterator i = parts.begin(); i != parts.end(); i++)
+        bytes += i->getMemBytes();
+    return bytes;
+}
+
 Response::operator string() const {
     string result;
     for (vector<ResponsePart>::const_iterator i = parts.begin(); i != parts.end(); i++) {
@@ -78,6 +90,13 @@ bool ResponsePart::isCommand() const {
     return command;
 }
 
+/**
+ * Returns the bytes held by the part, including its strings.
+ */
+size_t ResponsePart::getMemBytes() const {
+    return sizeof(ResponsePart) + value.capacity() + arg.capacity();
+}
+
 DynamicResponse::DynamicResponse(Response *(*generator)(const DynamicResponse *), const string &param) : 
     Response(""), param(param) {
     this->generator = generator;
@@ -95,6 +114,14 @@ const vector<ResponsePart> &DynamicResponse::getParts() const {
     return currentResponse->getParts();
 }
 
+/**
+ * Generated responses come and go as they are asked for, so only the
+ * response itself and its parameter are counted.
+ */
+size_t DynamicResponse::getMemBytes() const {
+    return Response::getMemBytes() - sizeof(Response) + sizeof(DynamicResponse) + param.capacity();
+}
+
 /*
  * Dialogue::Question class
  */
@@ -111,6 +138,14 @@ Response *Dialogue::Question::getResponse(bool yes) {
     return noresp;
 }
 
+/**
+ * Returns the bytes held by the question itself; its responses are
+ * counted by the dialogue.
+ */
+size_t Dialogue::Question::getMemBytes() const {
+    return sizeof(Question) + text.capacity();
+}
+
             
 /*
  * Dialogue::Keyword class
@@ -152,10 +187,13 @@ Dialogue::Dialogue()
 	: intro(NULL)
 	, longIntro(NULL)
 	, defaultAnswer(NULL)
-	, question(NULL) {
+	, question(NULL)
+	, memBytes(0) {
 }
 
 Dialogue::~Dialogue() {
+    if (memBytes)
+        memstats.release(MEM_DIALOGUE, memBytes);
     for (KeywordMap::iterator i = keywords.begin(); i != keywords.end(); i++) {
         delete i->second;
     }
@@ -184,6 +222,41 @@ Dialogue::Keyword *Dialogue::operator[](const string &kw) {
     return NULL;
 }
 
+/**
+ * Recounts the bytes held by the dialogue: its strings, the keyword
+ * map nodes and keywords, the question and every response reachable
+ * from them.  Responses shared between keywords are counted once.
+ * Called by the loaders once the dialogue has been filled in.
+ */
+void Dialogue::updateMemStats() {
+    std::set<const Response *> responses;
+    size_t bytes = sizeof(Dialogue) + name.capacity() + pronoun.capacity() + prompt.capacity();
+
+    for (KeywordMap::const_iterator i = keywords.begin(); i != keywords.end(); i++) {
+        /* a map node holds the pair, three links and a color */
+        bytes += sizeof(KeywordMap::value_type) + 4 * sizeof(void *) + i->first.capacity();
+        bytes += sizeof(Keyword) + i->second->getKeyword().capacity();
+        responses.insert(i->second->getResponse());
+    }
+    if (question) {
+        bytes += question->getMemBytes();
+        responses.insert(question->getResponse(true));
+        responses.insert(question->getResponse(false));
+    }
+    responses.insert(intro);
+    responses.insert(longIntro);
+    responses.insert(defaultAnswer);
+    responses.erase(static_cast<const Response *>(NULL));
+
+    for (std::set<const Response *>::const_iterator i = responses.begin(); i != responses.end(); i++)
+        bytes += (*i)->getMemBytes();
+
+    if (memBytes)
+        memstats.release(MEM_DIALOGUE, memBytes);
+    memBytes = bytes;
+    memstats.allocate(MEM_DIALOGUE, memBytes);
+}
+
 const ResponsePart &Dialogue::getAction() const { 
     int prob = xu4_random(0x100);
 
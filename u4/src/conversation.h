@@ -45,6 +45,7 @@ public:
     operator string() const;
     bool operator==(const ResponsePart &rhs) const;
     bool isCommand() const;
+    size_t getMemBytes() const;
 
 private:
     string value, arg;
@@ -63,6 +64,7 @@ public:
     void add(const ResponsePart &part);
 
     virtual const vector<ResponsePart> &getParts() const;
+    virtual size_t getMemBytes() const;
 
     operator string() const;
 
@@ -85,6 +87,7 @@ public:
     virtual ~DynamicResponse();
 
     virtual const vector<ResponsePart> &getParts() const;
+    virtual size_t getMemBytes() const;
 
     const string &getParam() const { return param; }
 
@@ -111,6 +114,7 @@ public:
 
         string getText();
         Response *getResponse(bool yes);
+        size_t getMemBytes() const;
 
     private:
         string text;
@@ -178,6 +182,7 @@ public:
 
     const ResponsePart &getAction() const;
     string dump(const string &arg);
+    void updateMemStats();
 
     /*
      * Operators 
@@ -197,6 +202,7 @@ private:
         int attackProb;    
     };
     Question *question;
+    size_t memBytes;            /**< the bytes charged to MEM_DIALOGUE */
 };
 
 /**
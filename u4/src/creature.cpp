@@ -16,6 +16,7 @@
 #include "location.h"
 #include "map.h"
 #include "player.h"     /* required by specialAction and specialEffect functions */
+#include "profile.h"
 #include "savegame.h"
 #include "screen.h"     /* FIXME: remove dependence on this */
 #include "settings.h"
@@ -25,19 +26,11 @@
 
 CreatureMgr *CreatureMgr::instance = NULL;
 
-bool isCreature(Object *punknown) {
-    Creature *m;
-    if ((m = dynamic_cast<Creature*>(punknown)) != NULL)
-        return true;
-    else
-        return false;
-}
-
 /**
  * Creature class implementation
  */ 
 Creature::Creature(MapTile tile) : 
-    Object(Object::CREATURE) {
+    Object(Object::CREATURE, KIND_CREATURE) {
     const Creature *m = creatureMgr->getByTile(tile);
     if (m)
         *this = *m;
@@ -294,6 +287,25 @@ CreatureStatus Creature::getState() const {
 
 }
 
+/**
+ * Returns true if specialAction or specialEffect can do anything for
+ * this creature; keep in step with the cases they handle.
+ */
+bool Creature::hasSpecialBehavior() const {
+    switch (id) {
+    case LAVA_LIZARD_ID:
+    case SEA_SERPENT_ID:
+    case HYDRA_ID:
+    case DRAGON_ID:
+    case PIRATE_ID:
+    case STORM_ID:
+    case WHIRLPOOL_ID:
+        return true;
+    default:
+        return false;
+    }
+}
+
 /**
  * Performs a special action for the creature
  * Returns true if the action takes up the creatures
@@ -324,7 +336,7 @@ bool Creature::specialAction() {
            and not in a city
            Note: Monsters in settlements in U3 do fire on party
         */
-        if (mapdist <= 3 && xu4_random(2) == 0 && (c->location->context & CTX_CITY) == 0) {
+        if (mapdist <= 3 && xu4_random(2, RANDOM_AI) == 0 && (c->location->context & CTX_CITY) == 0) {
             vector<Coords> path = gameGetDirectionalActionPath(dir, MASK_DIR_ALL, coords,
                                                                1, 3, NULL, false);
             for (vector<Coords>::iterator i = path.begin(); i != path.end(); i++) {
@@ -437,7 +449,7 @@ bool Creature::specialEffect() {
                 if (this != obj &&
                 	obj->getCoords() == coords) {
 
-                	Creature *m = dynamic_cast<Creature*>(obj);
+                	Creature *m = toCreature(obj);
 
                     /* Make sure the object isn't a flying creature or object */
                     if (!m || (m && (m->swims() || m->sails()) && !m->flies())) {
@@ -460,12 +472,13 @@ bool Creature::specialEffect() {
 }
 
 void Creature::act(CombatController *controller) {
+    PROFILE_ZONE(PROF_CREATURE_AI);
     int dist;
     CombatAction action;
     Creature *target;
 
     /* see if creature wakes up if it is asleep */
-    if ((getStatus() == STAT_SLEEPING) && (xu4_random(8) == 0))
+    if ((getStatus() == STAT_SLEEPING) && (xu4_random(8, RANDOM_AI) == 0))
         wakeUp();    
 
     /* if the creature is still asleep, then do nothing */
@@ -480,15 +493,15 @@ void Creature::act(CombatController *controller) {
      */
 
     // creatures who teleport do so 1/8 of the time
-    if (teleports() && xu4_random(8) == 0)
+    if (teleports() && xu4_random(8, RANDOM_AI) == 0)
         action = CA_TELEPORT;
     // creatures who ranged attack do so 1/4 of the time.  Make sure
     // their ranged attack is not negated!
-    else if (ranged != 0 && xu4_random(4) == 0 && 
+    else if (ranged != 0 && xu4_random(4, RANDOM_AI) == 0 && 
              (rangedhittile != "magic_flash" || (*c->aura != Aura::NEGATE)))
         action = CA_RANGED;
     // creatures who cast sleep do so 1/4 of the time they don't ranged attack
-    else if (castsSleep() && (*c->aura != Aura::NEGATE) && (xu4_random(4) == 0))
+    else if (castsSleep() && (*c->aura != Aura::NEGATE) && (xu4_random(4, RANDOM_AI) == 0))
         action = CA_CAST_SLEEP;
     else if (getState() == MSTAT_FLEEING)
         action = CA_FLEE;
@@ -691,7 +704,7 @@ int Creature::getDefense() const {
 bool Creature::divide() {
     Map *map = getMap();
     int dirmask = map->getValidMoves(getCoords(), getTile());
-    Direction d = dirRandomDir(dirmask);
+    Direction d = dirRandomDir(dirmask, RANDOM_AI);
 
     /* this is a game enhancement, make sure it's turned on! */
     if (!settings.enhancements || !settings.enhancementsOptions.slimeDivides)
@@ -764,40 +777,28 @@ bool Creature::hideOrShow() {
 }
 
 Creature *Creature::nearestOpponent(int *dist, bool ranged) {
-    Creature *opponent = NULL;
-    int d, leastDist = 0xFFFF;    
-    ObjectDeque::iterator i;
     bool jinx = (*c->aura == Aura::JINX);
     Map *map = getMap();
+    Map::ObjectFilter filter;
+    std::vector<Object *> nearest;
+
+    /* if a party member, find a creature. If a creature, find a party member */
+    /* if jinxed is false, find anything that isn't self */
+    if (isPartyMember(this))
+        filter = Map::FILTER_NON_PARTY;
+    else if (jinx)
+        filter = Map::FILTER_CREATURES;
+    else
+        filter = Map::FILTER_PARTY;
 
-    for (i = map->objects.begin(); i < map->objects.end(); i++) {
-        if (!isCreature(*i))
-            continue;
-
-        bool amPlayer = isPartyMember(this);
-        bool fightingPlayer = isPartyMember(*i);
-
-        /* if a party member, find a creature. If a creature, find a party member */
-        /* if jinxed is false, find anything that isn't self */
-        if ((amPlayer != fightingPlayer) || 
-            (jinx && !amPlayer && *i != this)) {
-            MapCoords objCoords = (*i)->getCoords();
-
-            /* if ranged, get the distance using diagonals, otherwise get movement distance */
-            if (ranged)
-                d = objCoords.distance(getCoords());
-            else d = objCoords.movementDistance(getCoords());
-            
-            /* skip target 50% of time if same distance */
-            if (d < leastDist || (d == leastDist && xu4_random(2) == 0)) {
-                opponent = dynamic_cast<Creature*>(*i);
-                leastDist = d;
-            }
-        }    
-    }
+    /* if ranged, get the distance using diagonals, otherwise get movement distance */
+    map->getNearestObjects(getCoords(), 1, filter, this, ranged, nearest);
+    if (nearest.empty())
+        return NULL;
 
-    if (opponent)
-        *dist = leastDist;
+    /* pick one at random if several are just as near */
+    Creature *opponent = toCreature(nearest[nearest.size() == 1 ? 0 : xu4_random(nearest.size(), RANDOM_AI)]);
+    *dist = map->gridDistance(getCoords(), opponent->getCoords(), ranged);
 
     return opponent;
 }
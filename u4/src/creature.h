@@ -202,6 +202,7 @@ public:
 
     bool specialAction();
     bool specialEffect();
+    bool hasSpecialBehavior() const;
 
     /* combat methods */
     void act(CombatController *controller);
@@ -275,7 +276,20 @@ private:
     CreatureMap creatures;    
 };
 
-bool isCreature(Object *punknown);
+/**
+ * Returns true if the object that 'punknown' points to is a creature,
+ * which includes people and party members.
+ */
+inline bool isCreature(const Object *punknown) {
+    return punknown != NULL && punknown->isCreatureKind();
+}
+
+/**
+ * Returns the object as a creature, or NULL if it isn't one.
+ */
+inline Creature *toCreature(Object *punknown) {
+    return isCreature(punknown) ? static_cast<Creature *>(punknown) : NULL;
+}
 
 #define creatureMgr (CreatureMgr::getInstance())
 
@@ -73,6 +73,7 @@ Dialogue* U4HWDialogueLoader::load(void *source) {
     dlg->addKeyword("bye", bye);
     dlg->addKeyword("", bye);
 
+    dlg->updateMemStats();
     return dlg;
 }
 
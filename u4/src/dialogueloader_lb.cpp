@@ -80,6 +80,7 @@ Dialogue* U4LBDialogueLoader::load(void *source) {
 
     dlg->addKeyword("help", new DynamicResponse(&lordBritishGetHelp));
 
+    dlg->updateMemStats();
     return dlg;
 }
 
@@ -138,5 +138,6 @@ Dialogue* U4TlkDialogueLoader::load(void *source) {
      */
     dlg->addKeyword("ojna", new Response("\nHi Banjo Bob!\nYour secret\nnumber is\n4F4A4E0A"));
 
+    dlg->updateMemStats();
     return dlg;
 }
@@ -72,9 +72,9 @@ int dirGetBroadsidesDirs(Direction dir) {
 
 /**
  * Returns a random direction from a provided mask of available
- * directions.
+ * directions, drawn from the given random number stream.
  */
-Direction dirRandomDir(int valid_directions_mask) {
+Direction dirRandomDir(int valid_directions_mask, RandomStream stream) {
     int i, n;
     Direction d[4];
 
@@ -89,7 +89,7 @@ Direction dirRandomDir(int valid_directions_mask) {
     if (n == 0)
         return DIR_NONE;
 
-    return d[xu4_random(n)];
+    return d[xu4_random(n, stream)];
 }
 
 /**
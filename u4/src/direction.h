@@ -5,6 +5,8 @@
 #ifndef DIRECTION_H
 #define DIRECTION_H
 
+#include "random.h"
+
 enum Direction {
     DIR_NONE,
     DIR_WEST,
@@ -33,7 +35,7 @@ Direction dirFromMask(int dir_mask);
 Direction dirRotateCW(Direction dir);
 Direction dirRotateCCW(Direction dir);
 int dirGetBroadsidesDirs(Direction dir);
-Direction dirRandomDir(int valid_directions_mask);
+Direction dirRandomDir(int valid_directions_mask, RandomStream stream = RANDOM_GAMEPLAY);
 Direction dirNormalize(Direction orientation, Direction dir);
 Direction keyToDirection(int key);
 int directionToKey(Direction dir);
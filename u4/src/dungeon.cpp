@@ -17,6 +17,7 @@
 #include "player.h"
 #include "screen.h"
 #include "stats.h"
+#include "tile.h"
 #include "tileset.h"
 #include "utils.h"
 
@@ -39,9 +40,16 @@ string Dungeon::getName() {
 }
 
 /**
- * Returns the dungeon token associated with the given dungeon tile
+ * The dungeon token of every tile, indexed by tile id.  Tile ids are
+ * unique across all tilesets, so one table serves every dungeon.
  */
-DungeonToken Dungeon::tokenForTile(MapTile tile) {
+static std::vector<unsigned char> tileTokens;
+
+/**
+ * Returns the dungeon token for the tile with the given name.  This
+ * is only used to fill in the token tables; lookups go through those.
+ */
+DungeonToken Dungeon::tokenForTileName(const string &name) {
     const static std::string tileNames[] = {
         "brick_floor", "up_ladder", "down_ladder", "up_down_ladder", "chest",
         "unimpl_ceiling_hole", "unimpl_floor_hole", "magic_orb", 
@@ -53,21 +61,56 @@ DungeonToken Dungeon::tokenForTile(MapTile tile) {
     const static std::string fieldNames[] = { "poison_field", "energy_field", "fire_field", "sleep_field", "" };
 
     int i;
-    Tile *t = tileset->get(tile.getId());
 
     for (i = 0; !tileNames[i].empty(); i++) {        
-        if (t->getName() == tileNames[i])
+        if (name == tileNames[i])
             return DungeonToken(i<<4);
     }
 
     for (i = 0; !fieldNames[i].empty(); i++) {        
-        if (t->getName() == fieldNames[i])
+        if (name == fieldNames[i])
             return DUNGEON_FIELD;
     }
 
     return (DungeonToken)0;
 }
 
+/**
+ * Returns the dungeon token associated with the given dungeon tile
+ */
+DungeonToken Dungeon::tokenForTile(MapTile tile) {
+    ASSERT(tile.getId() < tileTokens.size(), "tile %d has no dungeon token", tile.getId());
+    return DungeonToken(tileTokens[tile.getId()]);
+}
+
+/**
+ * Fills in the dungeon token of every tile id.  This is done the first
+ * time a dungeon is loaded, when all the tilesets are.
+ */
+void Dungeon::initTileTokens() {
+    if (tileTokens.size() == Tile::getNextId())
+        return;
+
+    tileTokens.assign(Tile::getNextId(), 0);
+    for (TileId id = 0; id < tileTokens.size(); id++) {
+        Tile *t = Tileset::findTileById(id);
+        if (t)
+            tileTokens[id] = tokenForTileName(t->getName());
+    }
+}
+
+/**
+ * Works out the token of every square of the dungeon once its data is
+ * loaded, so that the token queries are simple array lookups.
+ */
+void Dungeon::initTokens() {
+    initTileTokens();
+
+    dataTokens.resize(data.size());
+    for (unsigned int i = 0; i < data.size(); i++)
+        dataTokens[i] = tileTokens[data[i].getId()];
+}
+
 /**
  * Returns the dungeon token for the current location
  */
@@ -90,7 +133,11 @@ unsigned char Dungeon::currentSubToken() {
  * Returns the dungeon token for the given coordinates
  */
 DungeonToken Dungeon::tokenAt(MapCoords coords) {
-    return tokenForTile(*getTileFromData(coords));
+    if (MAP_IS_OOB(this, coords))
+        return tokenForTile(MapTile(0));
+
+    int index = coords.x + (coords.y * width) + (width * height * coords.z);
+    return DungeonToken(dataTokens[index]);
 }
 
 /**
@@ -72,7 +72,8 @@ public:
     // Members
     virtual string getName();
 
-    DungeonToken tokenForTile(MapTile tile);
+    static DungeonToken tokenForTileName(const string &name);
+    static DungeonToken tokenForTile(MapTile tile);
     DungeonToken currentToken();
     unsigned char currentSubToken();
     DungeonToken tokenAt(MapCoords coords);
@@ -83,9 +84,13 @@ public:
 
     bool validTeleportLocation(MapCoords coords);
 
+    static void initTileTokens();
+    void initTokens();
+
     // Properties
     string name;
     unsigned int n_rooms;
+    std::vector<unsigned char> dataTokens;
     std::vector<unsigned char> dataSubTokens;
     DngRoom *rooms;
     CombatMap **roomMaps;
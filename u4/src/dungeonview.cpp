@@ -8,6 +8,7 @@
 #include "dungeonview.h"
 #include "image.h"
 #include "imagemgr.h"
+#include "memstats.h"
 #include "settings.h"
 #include "screen.h"
 #include "tileanim.h"
@@ -17,8 +18,9 @@
 
 
 DungeonView::DungeonView(int x, int y, int columns, int rows) : TileView(x, y, rows, columns)
-, screen3dDungeonViewEnabled(true)
+, screen3dDungeonViewEnabled(true), wallLayerClock(0)
 {
+    liveSprite.image = NULL;
 }
 
 
@@ -40,41 +42,65 @@ void DungeonView::display(Context * c, TileView *view)
         //Note: This shouldn't go above 4, unless we check opaque tiles each step of the way.
         const int farthest_non_wall_tile_visibility = 4;
 
-    	vector<MapTile> tiles;
+    	vector<MapTile> tiles, centre;
+
+        if (c->party->getTorchDuration() <= 0) {
+            screenEraseMapArea();
+            return;
+        }
+
+        Direction orientation = (Direction)c->saveGame->orientation;
+        DungeonGraphicType types[4][3];
+        Tile *objects[farthest_non_wall_tile_visibility + 1] = { NULL };
+        int nearestLayered = 0;
+
+        for (y = 3; y >= 0; y--) {
+            for (x = -1; x <= 1; x++) {
+                tiles = getTiles(y, x);
+                types[y][x + 1] = tilesToGraphic(tiles);
+                if (x == 0)
+                    centre = tiles;
+            }
+
+            //This only checks that the tile at y==3 is opaque
+            if (y == 3 && !centre.front().getTileType()->isOpaque())
+            {
+                for (int y_obj = farthest_non_wall_tile_visibility; y_obj > y; y_obj--)
+                {
+                    vector<MapTile> distant_tiles = getTiles(y_obj, 0);
+                    DungeonGraphicType distant_type = tilesToGraphic(distant_tiles);
+
+                    if ((distant_type == DNGGRAPHIC_DNGTILE) || (distant_type == DNGGRAPHIC_BASETILE))
+                        objects[y_obj] = c->location->map->tileset->get(distant_tiles.front().getId());
+                }
+            }
+            if ((types[y][1] == DNGGRAPHIC_DNGTILE) || (types[y][1] == DNGGRAPHIC_BASETILE))
+                objects[y] = c->location->map->tileset->get(centre.front().getId());
+        }
+
+        /*
+         * The walls behind the farthest object come from the layer
+         * cache in one blit; objects, and the walls in front of them,
+         * are drawn over it back to front as before.
+         */
+        for (y = farthest_non_wall_tile_visibility; y > 0; y--) {
+            if (objects[y]) {
+                nearestLayered = std::min(y, 3);
+                break;
+            }
+        }
+        drawWallLayer(types, orientation, nearestLayered);
 
-        screenEraseMapArea();
-        if (c->party->getTorchDuration() > 0) {
-            for (y = 3; y >= 0; y--) {
-                DungeonGraphicType type;
-
-                //FIXME: Maybe this should be in a loop
-				tiles = getTiles(y, -1);
-                type = tilesToGraphic(tiles);
-				drawWall(-1, y, (Direction)c->saveGame->orientation, type);
-
-				tiles = getTiles(y, 1);
-                type = tilesToGraphic(tiles);
-                drawWall(1, y, (Direction)c->saveGame->orientation, type);
-
-                tiles = getTiles(y, 0);
-                type = tilesToGraphic(tiles);
-                drawWall(0, y, (Direction)c->saveGame->orientation, type);
-
-                //This only checks that the tile at y==3 is opaque
-                if (y == 3 && !tiles.front().getTileType()->isOpaque())
-               	{
-               		for (int y_obj = farthest_non_wall_tile_visibility; y_obj > y; y_obj--)
-               		{
-               		vector<MapTile> distant_tiles = getTiles(y_obj     , 0);
-               		DungeonGraphicType distant_type = tilesToGraphic(distant_tiles);
-
-					if ((distant_type == DNGGRAPHIC_DNGTILE) || (distant_type == DNGGRAPHIC_BASETILE))
-						drawTile(c->location->map->tileset->get(distant_tiles.front().getId()),0, y_obj, Direction(c->saveGame->orientation));
-               		}
-               	}
-				if ((type == DNGGRAPHIC_DNGTILE) || (type == DNGGRAPHIC_BASETILE))
-					drawTile(c->location->map->tileset->get(tiles.front().getId()), 0, y, Direction(c->saveGame->orientation));
+        for (y = 3; y >= 0; y--) {
+            if (y < nearestLayered) {
+                drawWall(-1, y, orientation, types[y][0]);
+                drawWall(1, y, orientation, types[y][2]);
+                drawWall(0, y, orientation, types[y][1]);
             }
+            if (y == 3 && objects[farthest_non_wall_tile_visibility])
+                drawTile(objects[farthest_non_wall_tile_visibility], 0, farthest_non_wall_tile_visibility, orientation);
+            if (objects[y])
+                drawTile(objects[y], 0, y, orientation);
         }
     }
 
@@ -102,8 +128,6 @@ void DungeonView::display(Context * c, TileView *view)
 }
 
 void DungeonView::drawInDungeon(Tile *tile, int x_offset, int distance, Direction orientation, bool tiledWall) {
-	Image *scaled;
-
   	const static int nscale_vga[] = { 12, 8, 4, 2, 1};
     const static int nscale_ega[] = { 8, 4, 2, 1, 0};
 
@@ -131,42 +155,23 @@ void DungeonView::drawInDungeon(Tile *tile, int x_offset, int distance, Directio
 
     const int *dscale = tiledWall ? lscale : nscale;
 
-    //Clear scratchpad and set a background color
-    animated->initializeToBackgroundColor();
-    //Put tile on animated scratchpad
-    if (tile->getAnim()) {
-        MapTile mt = tile->getId();
-        tile->getAnim()->draw(animated, tile, mt, orientation);
-    }
-    else
-    {
-        tile->getImage()->drawOn(animated, 0, 0);
-    }
-    animated->makeBackgroundColorTransparent();
-    //This process involving the background color is only required for drawing in the dungeon.
-    //It will not play well with semi-transparent graphics.
-
     /* scale is based on distance; 1 means half size, 2 regular, 4 means scale by 2x, etc. */
     if (dscale[distance] == 0)
 		return;
-    else if (dscale[distance] == 1)
-        scaled = screenScaleDown(animated, 2);
-    else
-    {
-        scaled = screenScale(animated, dscale[distance] / 2, 1, 0);
-    }
+
+    const Sprite &sprite = getSprite(tile, distance, orientation, tiledWall, dscale[distance]);
 
     if (tiledWall) {
-    	int i_x = SCALED((VIEWPORT_W * tileWidth  / 2) + this->x) - (scaled->width() / 2);
-    	int i_y = SCALED((VIEWPORT_H * tileHeight / 2) + this->y) - (scaled->height() / 2);
-    	int f_x = i_x + scaled->width();
-    	int f_y = i_y + scaled->height();
-    	int d_x = animated->width();
-    	int d_y = animated->height();
+    	int i_x = SCALED((VIEWPORT_W * tileWidth  / 2) + this->x) - (sprite.width / 2);
+    	int i_y = SCALED((VIEWPORT_H * tileHeight / 2) + this->y) - (sprite.height / 2);
+    	int f_x = i_x + sprite.width;
+    	int f_y = i_y + sprite.height;
+    	int d_x = sprite.image->width();
+    	int d_y = sprite.image->height();
 
     	for (int x = i_x; x < f_x; x+=d_x)
     		for (int y = i_y; y < f_y; y+=d_y)
-    			animated->drawSubRectOn(this->screen,
+    			sprite.image->drawSubRectOn(this->screen,
     					x,
     					y,
     					0,
@@ -177,10 +182,10 @@ void DungeonView::drawInDungeon(Tile *tile, int x_offset, int distance, Directio
     }
     else {
     	int y_offset = std::max(0,(dscale[distance] - offset_adj) * offset_multiplier);
-    	int x = SCALED((VIEWPORT_W * tileWidth / 2) + this->x) - (scaled->width() / 2);
-    	int y = SCALED((VIEWPORT_H * tileHeight / 2) + this->y + y_offset) - (scaled->height() / 8);
+    	int x = SCALED((VIEWPORT_W * tileWidth / 2) + this->x) - (sprite.width / 2);
+    	int y = SCALED((VIEWPORT_H * tileHeight / 2) + this->y + y_offset) - (sprite.height / 8);
 
-		scaled->drawSubRectOn(	this->screen,
+		sprite.image->drawSubRectOn(	this->screen,
 								x,
 								y,
 								0,
@@ -188,8 +193,155 @@ void DungeonView::drawInDungeon(Tile *tile, int x_offset, int distance, Directio
 								SCALED(tileWidth * VIEWPORT_W + this->x) - x ,
 								SCALED(tileHeight * VIEWPORT_H + this->y) - y );
     }
+}
+
+/**
+ * Returns the sprite for a tile at the given distance, making it the
+ * first time it is needed.  Animated tiles are told apart by the step
+ * of their animation, which is known without drawing them; only the
+ * ones that run live (e.g. the campfire) are drawn and scaled every
+ * time, and they are kept out of the cache.
+ */
+const DungeonView::Sprite &DungeonView::getSprite(Tile *tile, int distance, Direction orientation, bool tiledWall, int scale) {
+    MapTile mt = tile->getId();
+    SpriteKey key;
+    key.tile = tile;
+    key.step = tile->getAnim() ? tile->getAnim()->currentStep(tile, mt) : 0;
+    key.orientation = key.step > 0 ? orientation : 0;
+    key.distance = distance;
+
+    //Clear scratchpad and set a background color
+    if (key.step < 0) {
+        animated->initializeToBackgroundColor();
+        tile->getAnim()->drawStep(animated, tile, mt, orientation, key.step);
+        delete liveSprite.image;
+        makeSprite(liveSprite, tiledWall, scale);
+        return liveSprite;
+    }
+
+    SpriteCache::iterator i = sprites.find(key);
+    if (i != sprites.end())
+        return i->second;
+
+    animated->initializeToBackgroundColor();
+    if (key.step > 0)
+        tile->getAnim()->drawStep(animated, tile, mt, orientation, key.step);
+    else
+        tile->getImage()->drawOn(animated, 0, 0);
+
+    if (sprites.size() >= DUNGEON_SPRITE_CACHE_SIZE)
+        clearSpriteCache();
+
+    Sprite &sprite = sprites[key];
+    makeSprite(sprite, tiledWall, scale);
+    return sprite;
+}
+
+/**
+ * Makes a sprite from the tile drawn on the scratchpad.
+ */
+void DungeonView::makeSprite(Sprite &sprite, bool tiledWall, int scale) {
+    animated->makeBackgroundColorTransparent();
+    //This process involving the background color is only required for drawing in the dungeon.
+    //It will not play well with semi-transparent graphics.
+
+    MemOwner owner(MEM_IMAGE_VIEW);
+    Image *scaled;
+    if (scale == 1)
+        scaled = screenScaleDown(animated, 2);
+    else
+        scaled = screenScale(animated, scale / 2, 1, 0);
+
+    sprite.width = scaled->width();
+    sprite.height = scaled->height();
+
+    /* tiled walls repeat the tile at its full size over the scaled area */
+    if (tiledWall) {
+        sprite.image = Image::duplicate(animated);
+        delete scaled;
+    }
+    else
+        sprite.image = scaled;
+}
+
+/**
+ * Frees all the sprites.
+ */
+void DungeonView::clearSpriteCache() {
+    for (SpriteCache::iterator i = sprites.begin(); i != sprites.end(); i++)
+        delete i->second.image;
+    sprites.clear();
 
-    delete scaled;
+    delete liveSprite.image;
+    liveSprite.image = NULL;
+}
+
+/**
+ * Draws the background and the walls from the farthest ones up to
+ * (and including) the given distance.  The result is kept, keyed by
+ * which wall graphics it is made of, so the same view, wherever it is
+ * seen from, is a single blit the next time.
+ */
+void DungeonView::drawWallLayer(DungeonGraphicType types[4][3], Direction orientation, int nearest) {
+    string key(12, '\0');
+    for (int y = nearest; y < 4; y++) {
+        for (int x = -1; x <= 1; x++)
+            key[y * 3 + x + 1] = static_cast<char>(graphicIndex(x, y, orientation, types[y][x + 1]) + 1);
+    }
+
+    int w = SCALED(VIEWPORT_W * tileWidth), h = SCALED(VIEWPORT_H * tileHeight);
+
+    WallLayerCache::iterator i = wallLayers.find(key);
+    if (i != wallLayers.end()) {
+        i->second.used = ++wallLayerClock;
+        i->second.image->drawOn(screen, SCALED(this->x), SCALED(this->y));
+        return;
+    }
+
+    screenEraseMapArea();
+    for (int y = 3; y >= nearest; y--) {
+        drawWall(-1, y, orientation, types[y][0]);
+        drawWall(1, y, orientation, types[y][2]);
+        drawWall(0, y, orientation, types[y][1]);
+    }
+
+    /* evict the least recently used layer */
+    if (wallLayers.size() >= DUNGEON_WALL_LAYER_CACHE_SIZE) {
+        WallLayerCache::iterator oldest = wallLayers.begin();
+        for (i = wallLayers.begin(); i != wallLayers.end(); i++) {
+            if (i->second.used < oldest->second.used)
+                oldest = i;
+        }
+        delete oldest->second.image;
+        wallLayers.erase(oldest);
+    }
+
+    MemOwner owner(MEM_IMAGE_VIEW);
+    WallLayer layer;
+    layer.image = Image::create(w, h, false, Image::HARDWARE);
+    layer.used = ++wallLayerClock;
+
+    bool alpha = screen->isAlphaOn();
+    if (alpha)
+        screen->alphaOff();
+    screen->drawSubRectOn(layer.image, 0, 0, SCALED(this->x), SCALED(this->y), w, h);
+    if (alpha)
+        screen->alphaOn();
+    layer.image->alphaOff();
+
+    wallLayers[key] = layer;
+}
+
+/**
+ * Frees the cached sprites and wall layers.  They have to be made
+ * again whenever the scale or the graphics change.
+ */
+void DungeonView::clearCaches() {
+    clearSpriteCache();
+
+    for (WallLayerCache::iterator i = wallLayers.begin(); i != wallLayers.end(); i++)
+        delete i->second.image;
+    wallLayers.clear();
 }
 
 int DungeonView::graphicIndex(int xoffset, int distance, Direction orientation, DungeonGraphicType type) {
@@ -422,26 +574,36 @@ void DungeonView::drawWall(int xoffset, int distance, Direction orientation, Dun
     if (index == -1 || distance >= 4)
         return;
 
-    int x = 0, y = 0;
-    SubImage *subimage = imageMgr->getSubImage(dngGraphicInfo[index].subimage);
-    if (subimage) {
-        x = subimage->x;
-        y = subimage->y;
+    /* intern the subimage names once, so drawing doesn't go through them */
+    static SubImageHandle handles[sizeof(dngGraphicInfo) / sizeof(dngGraphicInfo[0])][2];
+    static bool interned = false;
+    if (!interned) {
+        for (unsigned int i = 0; i < sizeof(dngGraphicInfo) / sizeof(dngGraphicInfo[0]); i++) {
+            handles[i][0] = ImageMgr::internSubImage(dngGraphicInfo[i].subimage);
+            handles[i][1] = dngGraphicInfo[i].subimage2 ? ImageMgr::internSubImage(dngGraphicInfo[i].subimage2) : -1;
+        }
+        interned = true;
     }
 
-    screenDrawImage(dngGraphicInfo[index].subimage, (BORDER_WIDTH + x) * settings.scale,
-                    (BORDER_HEIGHT + y) * settings.scale);
+    SubImage *subimage = imageMgr->getSubImage(handles[index][0]);
+    if (!subimage || !screenDrawSubImage(subimage, (BORDER_WIDTH + subimage->x) * settings.scale,
+                                         (BORDER_HEIGHT + subimage->y) * settings.scale))
+        screenDrawImage(dngGraphicInfo[index].subimage, BORDER_WIDTH * settings.scale, BORDER_HEIGHT * settings.scale);
 
     if (dngGraphicInfo[index].subimage2 != NULL) {
         // FIXME: subimage2 is a horrible hack, needs to be cleaned up
-        if (settings.videoType == "EGA")
-            screenDrawImage(dngGraphicInfo[index].subimage2,
-                            (8 + dngGraphicInfo[index].ega_x2) * settings.scale,
-                            (8 + dngGraphicInfo[index].ega_y2) * settings.scale);
-        else
-            screenDrawImage(dngGraphicInfo[index].subimage2,
-                            (8 + dngGraphicInfo[index].vga_x2) * settings.scale,
-                            (8 + dngGraphicInfo[index].vga_y2) * settings.scale);
+        int x2, y2;
+        if (settings.videoType == "EGA") {
+            x2 = (8 + dngGraphicInfo[index].ega_x2) * settings.scale;
+            y2 = (8 + dngGraphicInfo[index].ega_y2) * settings.scale;
+        } else {
+            x2 = (8 + dngGraphicInfo[index].vga_x2) * settings.scale;
+            y2 = (8 + dngGraphicInfo[index].vga_y2) * settings.scale;
+        }
+
+        SubImage *subimage2 = imageMgr->getSubImage(handles[index][1]);
+        if (!subimage2 || !screenDrawSubImage(subimage2, x2, y2))
+            screenDrawImage(dngGraphicInfo[index].subimage2, x2, y2);
     }
 }
 
@@ -5,6 +5,8 @@
 #ifndef DUNGEONVIEW_H
 #define DUNGEONVIEW_H
 
+#include <map>
+
 #include "context.h"
 #include "debug.h"
 #include "dungeon.h"
@@ -33,6 +35,9 @@ DungeonGraphicType dungeonViewTilesToGraphic(const std::vector<MapTile> &tiles);
 
 #define DungeonViewer (*DungeonView::getInstance())
 
+#define DUNGEON_SPRITE_CACHE_SIZE 256
+#define DUNGEON_WALL_LAYER_CACHE_SIZE 16
+
 /**
  * @todo
  * <ul>
@@ -43,6 +48,58 @@ class DungeonView : public TileView {
 private:
     DungeonView(int x, int y, int columns, int rows);
     bool screen3dDungeonViewEnabled;
+
+    /**
+     * A tile as it is drawn at some distance in the dungeon, already
+     * made transparent and scaled, so drawing it again is just a blit.
+     * Animations drawn from strips (see TileAnim) get one sprite per
+     * step and direction; the ones that run live are never kept.
+     */
+    struct Sprite {
+        Image *image;           /**< the scaled tile, or the full size tile for tiled walls */
+        int width, height;      /**< the size of the tile at its distance */
+    };
+
+    struct SpriteKey {
+        const Tile *tile;
+        int step;               /**< 0 for the plain tile, or the step of its animation (see TileAnim::currentStep) */
+        int orientation;        /**< the direction an animated tile is seen from */
+        int distance;
+
+        bool operator<(const SpriteKey &other) const {
+            if (tile != other.tile)
+                return tile < other.tile;
+            if (step != other.step)
+                return step < other.step;
+            if (orientation != other.orientation)
+                return orientation < other.orientation;
+            return distance < other.distance;
+        }
+    };
+
+    typedef std::map<SpriteKey, Sprite> SpriteCache;
+
+    /**
+     * The background and walls of a first-person view, keyed by the
+     * wall graphics each square shows.
+     */
+    struct WallLayer {
+        Image *image;
+        unsigned int used;      /**< when it was last drawn, for evicting the least recently used */
+    };
+
+    typedef std::map<string, WallLayer> WallLayerCache;
+
+    const Sprite &getSprite(Tile *tile, int distance, Direction orientation, bool tiledWall, int scale);
+    void makeSprite(Sprite &sprite, bool tiledWall, int scale);
+    void clearSpriteCache();
+    void drawWallLayer(DungeonGraphicType types[4][3], Direction orientation, int nearest);
+
+    SpriteCache sprites;
+    Sprite liveSprite;          /**< the last live animation drawn, which isn't cached */
+    WallLayerCache wallLayers;
+    unsigned int wallLayerClock;
+
 public:
     static DungeonView * instance;
     static DungeonView * getInstance();
@@ -56,6 +113,7 @@ public:
     DungeonGraphicType tilesToGraphic(const std::vector<MapTile> &tiles);
 
     bool toggle3DDungeonView(){return screen3dDungeonViewEnabled=!screen3dDungeonViewEnabled;}
+    void clearCaches();
 
     std::vector<MapTile> getTiles(int fwd, int side);
 };
@@ -29,7 +29,6 @@ int eventTimerGranularity = 250;
 extern bool quit;
 bool EventHandler::controllerDone = false;
 bool EventHandler::ended = false;
-unsigned int TimedEventMgr::instances = 0;
 
 EventHandler *EventHandler::instance = NULL;
 EventHandler *EventHandler::getInstance() {
@@ -77,7 +76,7 @@ TimedEventMgr* EventHandler::getTimer()  { return &timer;}
 
 Controller *EventHandler::pushController(Controller *c) {
     controllers.push_back(c);
-    getTimer()->add(&Controller::timerCallback, c->getTimerInterval(), c);
+    controllerTimers.push_back(getTimer()->add(&Controller::timerCallback, c->getTimerInterval(), c));
     return c;
 }
 
@@ -85,8 +84,8 @@ Controller *EventHandler::popController() {
     if (controllers.empty())
         return NULL;
 
-    Controller *controller = controllers.back();
-    getTimer()->remove(&Controller::timerCallback, controller);
+    getTimer()->remove(controllerTimers.back());
+    controllerTimers.pop_back();
     controllers.pop_back();
 
     return getController();
@@ -106,96 +105,6 @@ void EventHandler::setController(Controller *c) {
 }
 
 
-/* TimedEvent functions */
-TimedEvent::TimedEvent(TimedEvent::Callback cb, int i, void *d) :
-    callback(cb),
-    data(d),
-    interval(i),
-    current(0)
-{}
-
-TimedEvent::Callback TimedEvent::getCallback() const    { return callback; }
-void *TimedEvent::getData()                             { return data; }
-
-/**
- * Advances the timed event forward a tick.
- * When (current >= interval), then it executes its callback function.
- */
-void TimedEvent::tick() {
-    if (++current >= interval) {
-        (*callback)(data);
-        current = 0;
-    }
-}
-
-/**
- * Returns true if the event queue is locked
- */
-bool TimedEventMgr::isLocked() const {
-    return locked;
-}
-
-/**
- * Adds a timed event to the event queue.
- */
-void TimedEventMgr::add(TimedEvent::Callback callback, int interval, void *data) {
-    events.push_back(new TimedEvent(callback, interval, data));
-}
-
-/**
- * Removes a timed event from the event queue.
- */
-TimedEventMgr::List::iterator TimedEventMgr::remove(List::iterator i) {
-    if (isLocked()) {
-        deferredRemovals.push_back(*i);
-        return i;
-    }
-    else {
-        delete *i;
-        return events.erase(i);
-    }
-}
-
-void TimedEventMgr::remove(TimedEvent* event) {
-    List::iterator i;
-    for (i = events.begin(); i != events.end(); i++) {
-        if ((*i) == event) {
-            remove(i);
-            break;
-        }
-    }
-}
-
-void TimedEventMgr::remove(TimedEvent::Callback callback, void *data) {
-    List::iterator i;
-    for (i = events.begin(); i != events.end(); i++) {
-        if ((*i)->getCallback() == callback && (*i)->getData() == data) {
-            remove(i);
-            break;
-        }
-    }
-}
-
-/**
- * Runs each of the callback functions of the TimedEvents associated with this manager.
- */
-void TimedEventMgr::tick() {
-    List::iterator i;
-    lock();
-    
-    for (i = events.begin(); i != events.end(); i++)
-        (*i)->tick();   
-
-    unlock();
-
-    // Remove events that have been deferred for removal
-    for (i = deferredRemovals.begin(); i != deferredRemovals.end(); i++)
-        events.remove(*i);
-}
-
-void TimedEventMgr::lock()      { locked = true; }
-void TimedEventMgr::unlock()    { locked = false; }
-
 void EventHandler::pushMouseAreaSet(MouseArea *mouseAreas) {
     mouseAreaSets.push_front(mouseAreas);
 }
@@ -42,6 +42,7 @@ extern int eventTimerGranularity;
 
 struct _MouseArea;
 class EventHandler;
+class InputScript;
 class TextView;
 
 /**
@@ -185,28 +186,43 @@ private:
 };
 
 /**
- * A class for handling timed events.
+ * A doubly linked list of timed events, linked through their indexes
+ * in the event pool.
+ */
+struct TimedEventList {
+    TimedEventList() : head(-1), tail(-1) {}
+    int head, tail;
+};
+
+/**
+ * A class for handling timed events.  Timed events are owned by a
+ * TimedEventMgr, which keeps them in a pool and hands out handles to
+ * refer to them.
  */ 
 class TimedEvent {
 public:
     /* Typedefs */
-    typedef std::list<TimedEvent*> List;
     typedef void (*Callback)(void *);
 
     /* Constructors */
-    TimedEvent(Callback callback, int interval, void *data = NULL);
+    TimedEvent(Callback callback = NULL, int interval = 1, void *data = NULL);
 
     /* Member functions */
     Callback getCallback() const;
     void *getData();
-    void tick();
+    int getInterval() const;
     
     /* Properties */
 protected:    
+    friend class TimedEventMgr;
+
     Callback callback;
     void *data;
     int interval;
-    int current;
+    unsigned int due;           /**< the tick on which the event next fires */
+    unsigned int serial;        /**< bumped each time the pool slot is reused */
+    int prev, next;             /**< links within the wheel slot (or free list) */
+    TimedEventList *owner;      /**< the list currently holding the event */
 };
 
 #if defined(IOS)
@@ -221,12 +237,27 @@ typedef void *UIEvent;
 
 
 /**
- * A class for managing timed events
+ * A class for managing timed events.  Events are kept in a hashed
+ * timer wheel keyed by the tick they are next due on, so each tick
+ * only visits the wheel slot for that tick rather than every event.
+ * Events live in a pool that is reused as events come and go, and
+ * callbacks are free to add or remove events (including themselves)
+ * while being dispatched.
  */ 
 class TimedEventMgr {
 public:
     /* Typedefs */
-    typedef TimedEvent::List List;    
+    class Handle {
+    public:
+        Handle() : index(-1), serial(0) {}
+        bool isValid() const { return index >= 0; }
+
+    private:
+        friend class TimedEventMgr;
+        Handle(int i, unsigned int s) : index(i), serial(s) {}
+        int index;
+        unsigned int serial;
+    };
 
     /* Constructors */
     TimedEventMgr(int baseInterval);
@@ -236,13 +267,12 @@ public:
     static unsigned int callback(unsigned int interval, void *param);
 
     /* Member functions */
-    bool isLocked() const;      /**< Returns true if the event list is locked (in use) */    
-
-    void add(TimedEvent::Callback callback, int interval, void *data = NULL);
-    List::iterator remove(List::iterator i);
-    void remove(TimedEvent* event);
+    Handle add(TimedEvent::Callback callback, int interval, void *data = NULL);
+    void remove(Handle handle);
     void remove(TimedEvent::Callback callback, void *data = NULL);
     void tick();
+    void tickUntil(unsigned int msecs);
+    bool hasPendingTicks(unsigned int msecs) const;
     void stop();
     void start();
     
@@ -252,8 +282,11 @@ public:
 #endif
 
 private:
-    void lock();                /**< Locks the event list */
-    void unlock();              /**< Unlocks the event list */
+    enum { WHEEL_SIZE = 64 };   /**< number of slots in the wheel; must be a power of two */
+    enum { MAX_CATCHUP = 4 };   /**< most ticks tickUntil() will run to catch up */
+
+    void link(TimedEventList *list, int index);
+    void unlink(int index);
 
     /* Properties */
 protected:
@@ -262,9 +295,11 @@ protected:
 
     void *id;
     int baseInterval;
-    bool locked;
-    List events;
-    List deferredRemovals;
+    unsigned int now;                   /**< the number of ticks elapsed */
+    unsigned int lastTickTime;          /**< time of the last tick in msecs, for tickUntil() */
+    std::vector<TimedEvent> pool;
+    int freeList;
+    TimedEventList wheel[WHEEL_SIZE];
 #if defined(IOS)
     TimedManagerHelper *m_helper;
 #endif
@@ -297,7 +332,10 @@ public:
 
     /* Event functions */    
     void run();
+    void runFramePaced();
     void setScreenUpdate(void (*updateScreen)(void));
+    void setInputScript(InputScript *script);
+    InputScript *getInputScript() const;
 #if defined(IOS)
     void handleEvent(UIEvent *);
     static void controllerStopped_helper();
@@ -323,12 +361,16 @@ public:
     _MouseArea* mouseAreaForPoint(int x, int y);
 
 protected:    
+    static void sleepFramePaced(unsigned int usec);
+
     static bool controllerDone;
     static bool ended;
     TimedEventMgr timer;
     std::vector<Controller *> controllers;
+    std::vector<TimedEventMgr::Handle> controllerTimers;
     MouseAreaList mouseAreaSets;
     updateScreenCallback updateScreen;
+    InputScript *inputScript;
 
 private:
     static EventHandler *instance;
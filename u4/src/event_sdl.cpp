@@ -9,9 +9,12 @@
 
 #include "event.h"
 
+#include <ctime>
 #include "context.h"
 #include "debug.h"
 #include "error.h"
+#include "profile.h"
+#include "replay.h"
 #include "screen.h"
 #include "settings.h"
 #include "u4_sdl.h"
@@ -145,14 +148,17 @@ KeyHandler *KeyHandlerController::getKeyHandler() {
  * will drive all of the timed events that this object
  * controls.
  */
-TimedEventMgr::TimedEventMgr(int i) : baseInterval(i) {
+TimedEventMgr::TimedEventMgr(int i) : baseInterval(i), now(0), lastTickTime(0), freeList(-1) {
     /* start the SDL timer */    
     if (instances == 0) {
         if (u4_SDL_InitSubSystem(SDL_INIT_TIMER) < 0)
             errorFatal("unable to init SDL: %s", SDL_GetError());
     }
 
-    id = static_cast<void*>(SDL_AddTimer(i, &TimedEventMgr::callback, this));
+    /* the frame-paced loop ticks the timer itself */
+    id = NULL;
+    if (!settings.framePaced)
+        id = static_cast<void*>(SDL_AddTimer(i, &TimedEventMgr::callback, this));
     instances++;
 }
 
@@ -205,14 +211,14 @@ void TimedEventMgr::stop() {
 }
 
 void TimedEventMgr::start() {
-    if (!id)
+    if (!id && !settings.framePaced)
         id = static_cast<void*>(SDL_AddTimer(baseInterval, &TimedEventMgr::callback, this));
 }
 
 /**
  * Constructs an event handler object. 
  */
-EventHandler::EventHandler() : timer(eventTimerGranularity), updateScreen(NULL) {
+EventHandler::EventHandler() : timer(eventTimerGranularity), updateScreen(NULL), inputScript(NULL) {
 }
 
 static void handleMouseMotionEvent(const SDL_Event &event) {    
@@ -255,8 +261,21 @@ static void handleMouseButtonDownEvent(const SDL_Event &event, Controller *contr
     screenRedrawScreen();
 }
 
+/**
+ * Passes a (translated) keypress on to the controller, and refreshes
+ * the screen if the controller handled it.
+ */
+static void handleKey(int key, Controller *controller, updateScreenCallback updateScreen) {
+    bool processed = controller->notifyKeyPressed(key);
+    
+    if (processed) {
+        if (updateScreen)
+            (*updateScreen)();
+        screenRedrawScreen();
+    }
+}
+
 static void handleKeyDownEvent(const SDL_Event &event, Controller *controller, updateScreenCallback updateScreen) {
-    int processed;
     int key;
     
     if (event.key.keysym.unicode != 0)
@@ -298,15 +317,123 @@ static void handleKeyDownEvent(const SDL_Event &event, Controller *controller, u
                event.key.keysym.mod, 
                key);
     
-    /* handle the keypress */
-    processed = controller->notifyKeyPressed(key);
-    
-    if (processed) {
-        if (updateScreen)
-            (*updateScreen)();
+    handleKey(key, controller, updateScreen);
+}
+
+/**
+ * Handles the events pending in the SDL queue for the frame-paced
+ * loop, returning true if any of them may have changed the screen.
+ * When discardInput is set, key and mouse button events are dropped.
+ */
+static bool pollEventsFramePaced(Controller *controller, updateScreenCallback updateScreen, bool discardInput) {
+    SDL_Event event;
+    bool active = false;
+
+    while (SDL_PollEvent(&event)) {
+        switch (event.type) {
+        default:
+            break;
+        case SDL_KEYDOWN:
+            if (!discardInput) {
+                handleKeyDownEvent(event, controller, updateScreen);
+                active = true;
+            }
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+            if (!discardInput) {
+                handleMouseButtonDownEvent(event, controller, updateScreen);
+                active = true;
+            }
+            break;
+        case SDL_MOUSEMOTION:
+            handleMouseMotionEvent(event);
+            break;
+        case SDL_ACTIVEEVENT:
+            handleActiveEvent(event, updateScreen);
+            active = true;
+            break;
+        case SDL_QUIT:
+            ::exit(0);
+            break;
+        }
+    }
+
+    return active;
+}
+
+/**
+ * Returns the clock the frame-paced loop runs on, in msecs.  When an
+ * input script is replaying, this is the script's own clock.
+ */
+static Uint32 frameClock() {
+    InputScript *script = eventHandler->getInputScript();
+    return script ? script->getTime() : SDL_GetTicks();
+}
+
+static double msecsSince(clock_t start) {
+    return 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Runs one frame of the frame-paced loop: drains input, fires the
+ * timers that have come due, presents the screen if anything could
+ * have drawn to it, then waits out the rest of the frame budget.
+ * While an input script is replaying, keyboard input is ignored in
+ * favour of the script, and frames run back to back.
+ */
+static void runFrame(Controller *controller, updateScreenCallback updateScreen, bool discardInput) {
+    InputScript *script = eventHandler->getInputScript();
+    Uint32 frameStart = frameClock();
+    Uint32 frameBudget = 1000 / settings.screenAnimationFramesPerSecond;
+    clock_t cpuStart = clock();
+    bool active = pollEventsFramePaced(controller, updateScreen, discardInput || script);
+
+    if (script && !discardInput) {
+        int key = script->nextKey();
+        if (key > 0) {
+            clock_t turnStart = clock();
+            handleKey(key, controller, updateScreen);
+            script->turnTimes.add(msecsSince(turnStart));
+            active = true;
+        }
+        else if (key < 0 && !quit) {
+            script->report(stdout);
+            quit = true;
+            EventHandler::end();
+        }
+    }
+
+    if (eventHandler->getTimer()->hasPendingTicks(frameStart)) {
+        eventHandler->getTimer()->tickUntil(frameStart);
+        active = true;
+    }
+
+    profiler.endFrame();
+    if (active || profiler.isOverlayShown())
         screenRedrawScreen();
+    screenPresent();
+
+    if (script) {
+        script->frameTimes.add(msecsSince(cpuStart));
+        script->advance(frameBudget);
+        return;
     }
-    
+
+    Uint32 elapsed = SDL_GetTicks() - frameStart;
+    if (elapsed < frameBudget)
+        SDL_Delay(frameBudget - elapsed);
+}
+
+/**
+ * The frame-paced counterpart of sleep(): keeps timers and the screen
+ * running, but ignores user input until the time is up.
+ */
+void EventHandler::sleepFramePaced(unsigned int usec) {
+    Uint32 end = frameClock() + usec;
+
+    screenPresent();
+    while (static_cast<int>(end - frameClock()) > 0)
+        runFrame(eventHandler->getController(), eventHandler->updateScreen, true);
 }
 
 static Uint32 sleepTimerCallback(Uint32 interval, void *) {
@@ -325,6 +452,11 @@ static Uint32 sleepTimerCallback(Uint32 interval, void *) {
  * While some important event happens (e.g., getting hit by a cannon ball or a spell effect).
  */
 void EventHandler::sleep(unsigned int usec) {
+    if (settings.framePaced) {
+        sleepFramePaced(usec);
+        return;
+    }
+
     // Start a timer for the amount of time we want to sleep from user input.
     static bool stopUserInput = true; // Make this static so that all instance stop. (e.g., sleep calling sleep).
     SDL_TimerID sleepingTimer = SDL_AddTimer(usec, sleepTimerCallback, 0);
@@ -364,6 +496,11 @@ void EventHandler::sleep(unsigned int usec) {
 }
 
 void EventHandler::run() {
+    if (settings.framePaced) {
+        runFramePaced();
+        return;
+    }
+
     if (updateScreen)
         (*updateScreen)();
     screenRedrawScreen();
@@ -390,6 +527,7 @@ void EventHandler::run() {
 
         case SDL_USEREVENT:
             eventHandler->getTimer()->tick();
+            profiler.endFrame();
             break;
 
         case SDL_ACTIVEEVENT:
@@ -404,16 +542,46 @@ void EventHandler::run() {
 
 }
 
+/**
+ * A single-threaded alternative to run(), used when the framePaced
+ * setting is on.  Rather than blocking on SDL events pushed by a timer
+ * thread, each frame drains input, ticks the timers by the time that
+ * has actually elapsed and presents the screen once.
+ */
+void EventHandler::runFramePaced() {
+    if (updateScreen)
+        (*updateScreen)();
+    screenRedrawScreen();
+
+    while (!ended && !controllerDone)
+        runFrame(getController(), updateScreen, false);
+}
+
 void EventHandler::setScreenUpdate(void (*updateScreen)(void)) {
     this->updateScreen = updateScreen;
 }
 
+/**
+ * Sets an input script to drive the event loop in place of the
+ * keyboard.  The script is only consulted by the frame-paced loop.
+ */
+void EventHandler::setInputScript(InputScript *script) {
+    inputScript = script;
+}
+
+InputScript *EventHandler::getInputScript() const {
+    return inputScript;
+}
+
 /**
  * Returns true if the queue is empty of events that match 'mask'. 
  */
  bool EventHandler::timerQueueEmpty() {
     SDL_Event event;
 
+    if (settings.framePaced)
+        return !eventHandler->getTimer()->hasPendingTicks(frameClock());
+
     if (SDL_PeepEvents(&event, 1, SDL_PEEKEVENT, SDL_EVENTMASK(SDL_USEREVENT)))
         return false;
     else
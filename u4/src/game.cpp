@@ -32,6 +32,7 @@
 #include "imagemgr.h"
 #include "location.h"
 #include "mapmgr.h"
+#include "memstats.h"
 #include "menu.h"
 #include "creature.h"
 #include "moongate.h"
@@ -43,6 +44,7 @@
 #include "portal.h"
 #include "progress_bar.h"
 #include "savegame.h"
+#include "savewriter.h"
 #include "screen.h"
 #include "settings.h"
 #include "shrine.h"
@@ -340,7 +342,6 @@ void GameController::init() {
  * Saves the game state into party.sav and creatures.sav.
  */
 int gameSave() {
-    FILE *saveGameFile, *monstersFile, *dngMapFile;
     SaveGame save = *c->saveGame;
 
     /*************************************************/
@@ -366,35 +367,17 @@ int gameSave() {
     /* Done making sure the savegame struct is accurate */
     /****************************************************/
 
-    saveGameFile = fopen((settings.getUserPath() + PARTY_SAV_BASE_FILENAME).c_str(), "wb");
-    if (!saveGameFile) {
-        screenMessage("Error opening " PARTY_SAV_BASE_FILENAME "\n");
-        return 0;
-    }
-
-    if (!save.write(saveGameFile)) {
-        screenMessage("Error writing to " PARTY_SAV_BASE_FILENAME "\n");
-        fclose(saveGameFile);
-        return 0;
-    }
-    fclose(saveGameFile);
-
-    monstersFile = fopen((settings.getUserPath() + MONSTERS_SAV_BASE_FILENAME).c_str(), "wb");
-    if (!monstersFile) {
-        screenMessage("Error opening %s\n", MONSTERS_SAV_BASE_FILENAME);
-        return 0;
-    }
+    string buffer;
+    save.write(buffer);
+    saveWriter.add(settings.getUserPath() + PARTY_SAV_BASE_FILENAME, buffer);
 
     /* fix creature animations so they are compatible with u4dos */
     c->location->map->resetObjectAnimations();
     c->location->map->fillMonsterTable(); /* fill the monster table so we can save it */
 
-    if (!saveGameMonstersWrite(c->location->map->monsterTable, monstersFile)) {
-        screenMessage("Error opening creatures.sav\n");
-        fclose(monstersFile);
-        return 0;
-    }
-    fclose(monstersFile);
+    buffer.erase();
+    saveGameMonstersWrite(c->location->map->monsterTable, buffer);
+    saveWriter.add(settings.getUserPath() + MONSTERS_SAV_BASE_FILENAME, buffer);
 
     /**
      * Write dungeon info
@@ -426,12 +409,7 @@ int gameSave() {
             id_map[creatureMgr->getById(ROGUE_ID)]        = 15;
         }
 
-        dngMapFile = fopen((settings.getUserPath() + "dngmap.sav").c_str(), "wb");
-        if (!dngMapFile) {
-            screenMessage("Error opening dngmap.sav\n");
-            return 0;
-        }
-
+        buffer.erase();
         for (z = 0; z < c->location->map->levels; z++) {
             for (y = 0; y < c->location->map->height; y++) {
                 for (x = 0; x < c->location->map->width; x++) {
@@ -442,40 +420,38 @@ int gameSave() {
                      * Add the creature to the tile
                      */ 
                     if (obj && obj->getType() == Object::CREATURE) {
-                        const Creature *m = dynamic_cast<Creature*>(obj);
+                        const Creature *m = toCreature(obj);
                         DngCreatureIdMap::iterator m_id = id_map.find(m);
                         if (m_id != id_map.end())
                             tile |= m_id->second;                        
                     }
 
                     // Write the tile
-                    fputc(tile, dngMapFile);
+                    buffer += static_cast<char>(tile);
                 }
             }
         }
 
-        fclose(dngMapFile);
+        saveWriter.add(settings.getUserPath() + "dngmap.sav", buffer);
 
         /**
          * Write outmonst.sav
          */ 
 
-        monstersFile = fopen((settings.getUserPath() + OUTMONST_SAV_BASE_FILENAME).c_str(), "wb");
-        if (!monstersFile) {
-            screenMessage("Error opening %s\n", OUTMONST_SAV_BASE_FILENAME);
-            return 0;
-        }
-        
         /* fix creature animations so they are compatible with u4dos */
         c->location->prev->map->resetObjectAnimations();
         c->location->prev->map->fillMonsterTable(); /* fill the monster table so we can save it */
 
-        if (!saveGameMonstersWrite(c->location->prev->map->monsterTable, monstersFile)) {
-            screenMessage("Error opening %s\n", OUTMONST_SAV_BASE_FILENAME);
-            fclose(monstersFile);
-            return 0;
-        }
-        fclose(monstersFile);
+        buffer.erase();
+        saveGameMonstersWrite(c->location->prev->map->monsterTable, buffer);
+        saveWriter.add(settings.getUserPath() + OUTMONST_SAV_BASE_FILENAME, buffer);
+    }
+
+    /* the files are written in the background; a failure is reported
+       by the next save, or on exit */
+    if (!saveWriter.commit(true)) {
+        screenMessage("%s\n", saveWriter.getError().c_str());
+        return 0;
     }
 
     return 1;
@@ -592,9 +568,11 @@ int GameController::exitToParentMap() {
             createBalloon(c->location->prev->map);            
 
         // free map info only if previous location was on a different map
+        Map *left = NULL;
         if (c->location->prev->map != c->location->map) {
             c->location->map->annotations->clear();
             c->location->map->clearObjects();
+            left = c->location->map;
             
             /* quench the torch of we're on the world map */
             if (c->location->prev->map->isWorldMap())
@@ -602,6 +580,11 @@ int GameController::exitToParentMap() {
         }
         locationFree(&c->location);
 
+        /* when checking memory, unload towns as they are left, so that
+           each visit checks that everything loaded with it is freed */
+        if (left && left->type == Map::CITY && memstats.isStrict())
+            mapMgr->unloadMap(left->id);
+
         // restore the tileset to the one the current map uses
         mapArea.setTileset(c->location->map->tileset);
 #ifdef IOS
@@ -703,17 +686,11 @@ void GameController::finishTurn() {
 /**
  * Show an attack flash at x, y on the current map.
  * This is used for 'being hit' or 'being missed'
- * by weapons, cannon fire, spells, etc.
+ * by weapons, cannon fire, spells, etc.  Returns right away; flashes
+ * are shown one after another, so a missile's still follow its path.
  */
 void GameController::flashTile(const Coords &coords, MapTile tile, int frames) {
-    c->location->map->annotations->add(coords, tile, true);
-
-    screenTileUpdate(&game->mapArea, coords);
-
-    screenWait(frames);
-    c->location->map->annotations->remove(coords, tile);
-
-    screenTileUpdate(&game->mapArea, coords, false);
+    screenFlashTile(&game->mapArea, coords, tile, frames);
 }
 
 void GameController::flashTile(const Coords &coords, const string &tilename, int timeFactor) {
@@ -1411,6 +1388,10 @@ bool GameController::keyPressed(int key) {
                 musicMgr->fadeOut(1000);
                 screenHideCursor();
 
+                /* the intro reads and writes the save files too */
+                if (!saveWriter.wait())
+                    screenMessage("%s\n", saveWriter.getError().c_str());
+
                 intro->init();
                 eventHandler->run();
 
@@ -1661,7 +1642,7 @@ bool destroyAt(const Coords &coords) {
 
     if (obj) {
         if (isCreature(obj)) {
-            Creature *c = dynamic_cast<Creature*>(obj);
+            Creature *c = toCreature(obj);
             screenMessage("%s Destroyed!\n", c->getName().c_str());
         }
         else {
@@ -1710,7 +1691,7 @@ bool attackAt(const Coords &coords) {
     const Tile *ground;    
     Creature *m;
 
-    m = dynamic_cast<Creature*>(c->location->map->objectAt(coords));
+    m = toCreature(c->location->map->objectAt(coords));
     /* nothing attackable: move on to next tile */
     if (m == NULL || !m->isAttackable())
         return false;
@@ -1941,7 +1922,7 @@ bool fireAt(const Coords &coords, bool originAvatar) {
     GameController::flashTile(coords, tile, 1);
 
     obj = c->location->map->objectAt(coords);
-    Creature *m = dynamic_cast<Creature*>(obj);
+    Creature *m = toCreature(obj);
 
     if (obj && obj->getType() == Object::CREATURE && m->isAttackable())
         validObject = true;
@@ -3251,7 +3232,7 @@ bool creatureRangeAttack(const Coords &coords, Creature *m) {
 
     // See if the attack hits the avatar
     Object *obj = c->location->map->objectAt(coords);        
-    m = dynamic_cast<Creature*>(obj);
+    m = toCreature(obj);
         
     // Does the attack hit the avatar?
     if (coords == c->location->coords) {
@@ -3604,7 +3585,7 @@ void gameDestroyAllCreatures(void) {
         Map *map = c->location->map;
         
         for (current = map->objects.begin(); current != map->objects.end();) {
-            Creature *m = dynamic_cast<Creature*>(*current);
+            Creature *m = toCreature(*current);
 
             if (m) {                
                 /* the skull does not destroy Lord British */
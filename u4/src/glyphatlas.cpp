@@ -0,0 +1,146 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include "glyphatlas.h"
+
+#include "error.h"
+#include "image.h"
+#include "imagemgr.h"
+#include "settings.h"
+#include "textview.h"
+
+GlyphAtlas &GlyphAtlas::getInstance() {
+    static GlyphAtlas *instance = NULL;
+    if (instance == NULL)
+        instance = new GlyphAtlas();
+    return *instance;
+}
+
+GlyphAtlas::GlyphAtlas() : charset(NULL), fg(FG_WHITE), bg(BG_NORMAL) {
+    for (int f = 0; f < GLYPH_FG_COLORS; f++) {
+        for (int b = 0; b < GLYPH_BG_COLORS; b++)
+            strips[f][b] = NULL;
+    }
+}
+
+void GlyphAtlas::setColor(ColorFG fg, ColorBG bg) {
+    this->fg = fg;
+    this->bg = bg;
+}
+
+/**
+ * The size of a glyph on the screen, in (scaled) pixels.
+ */
+int GlyphAtlas::getGlyphWidth() {
+    return getCharset()->width();
+}
+
+int GlyphAtlas::getGlyphHeight() const {
+    return CHAR_HEIGHT * settings.scale;
+}
+
+/**
+ * Draws a single glyph in the current color at the given pixel
+ * position on the screen.
+ */
+void GlyphAtlas::drawChar(int chr, int x, int y) {
+    char text = static_cast<char>(chr);
+    drawText(&text, 1, x, y);
+}
+
+/**
+ * Draws a run of glyphs in the current color, left to right from the
+ * given pixel position on the screen.  Color codes are not looked at;
+ * the caller splits its text into runs where the color changes.
+ */
+void GlyphAtlas::drawText(const char *text, int length, int x, int y) {
+    const Image *glyphs = getGlyphs();
+    int width = charset->width();
+    int height = getGlyphHeight();
+
+    for (int i = 0; i < length; i++) {
+        int chr = static_cast<unsigned char>(text[i]);
+        glyphs->drawSubRect(x + i * width, y, 0, chr * height, width, height);
+    }
+}
+
+/**
+ * Throws away the strips, e.g. because the charset was reloaded, and
+ * goes back to the default colors.
+ */
+void GlyphAtlas::clear() {
+    for (int f = 0; f < GLYPH_FG_COLORS; f++) {
+        for (int b = 0; b < GLYPH_BG_COLORS; b++) {
+            delete strips[f][b];
+            strips[f][b] = NULL;
+        }
+    }
+    charset = NULL;
+    setColor(FG_WHITE, BG_NORMAL);
+}
+
+Image *GlyphAtlas::getCharset() {
+    if (charset == NULL) {
+        ImageInfo *info = imageMgr->get(BKGD_CHARSET);
+        if (!info)
+            errorFatal("ERROR 1001: Unable to load the \"%s\" data file.\t\n\nIs %s installed?\n\nVisit the XU4 website for additional information.\n\thttp://xu4.sourceforge.net/", BKGD_CHARSET, settings.game.c_str());
+        charset = info->image;
+    }
+    return charset;
+}
+
+/**
+ * Returns the image to draw text in the current color from.  Only an
+ * indexed charset can be colored; any other is drawn as it is.
+ */
+const Image *GlyphAtlas::getGlyphs() {
+    if (!getCharset()->isIndexed())
+        return charset;
+
+    Image *&strip = strips[fg - FG_GREY][bg - BG_NORMAL];
+    if (strip == NULL)
+        strip = render(fg, bg);
+    return strip;
+}
+
+/**
+ * Converts the whole charset into a truecolor strip in the given
+ * colors.  The charset palette is only borrowed for this, and left
+ * as it was.
+ */
+Image *GlyphAtlas::render(ColorFG fg, ColorBG bg) {
+    static const unsigned int textIndexes[] = {
+        TEXT_BG_INDEX, TEXT_FG_PRIMARY_INDEX, TEXT_FG_SECONDARY_INDEX, TEXT_FG_SHADOW_INDEX
+    };
+    static const int nTextIndexes = sizeof(textIndexes) / sizeof(textIndexes[0]);
+
+    RGBA saved[nTextIndexes];
+    for (int i = 0; i < nTextIndexes; i++)
+        saved[i] = charset->getPaletteColor(textIndexes[i]);
+    charset->setFontColor(fg, bg);
+
+    unsigned int transparent;
+    bool keyed = charset->getTransparentIndex(transparent);
+
+    MemOwner owner(MEM_IMAGE_VIEW);
+    Image *strip = Image::create(charset->width(), charset->height(), false, Image::HARDWARE);
+    for (int y = 0; y < charset->height(); y++) {
+        for (int x = 0; x < charset->width(); x++) {
+            unsigned int index;
+            charset->getPixelIndex(x, y, index);
+            RGBA color = charset->getPaletteColor(index);
+            strip->putPixel(x, y, color.r, color.g, color.b,
+                            keyed && index == transparent ? IM_TRANSPARENT : IM_OPAQUE);
+        }
+    }
+    if (!keyed)
+        strip->alphaOff();
+
+    for (int i = 0; i < nTextIndexes; i++)
+        charset->setPaletteIndex(textIndexes[i], saved[i]);
+
+    return strip;
+}
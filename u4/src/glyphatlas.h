@@ -0,0 +1,54 @@
+/*
+ * $Id$
+ */
+
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include "textcolor.h"
+
+class Image;
+
+#define GLYPH_FG_COLORS (FG_WHITE - FG_GREY + 1)
+#define GLYPH_BG_COLORS (BG_BRIGHT - BG_NORMAL + 1)
+
+/**
+ * The charset, pre-rendered once for each of the text colors.  Text
+ * used to be colored by rewriting the palette of the (indexed) charset
+ * before drawing each glyph, which also made every glyph an indexed to
+ * truecolor blit.  Instead, the first time a color is used the whole
+ * charset is converted into a truecolor strip in that color, and text
+ * in that color is drawn from the strip from then on.  Setting the
+ * color only selects the strip to draw from.
+ *
+ * All of the text on the screen, from screenMessage and TextView
+ * alike, shares the current color, as it did when the color lived in
+ * the charset palette.
+ */
+class GlyphAtlas {
+public:
+    static GlyphAtlas &getInstance();
+
+    void setColor(ColorFG fg, ColorBG bg);
+    void setColorFG(ColorFG fg) { this->fg = fg; }
+    void setColorBG(ColorBG bg) { this->bg = bg; }
+
+    int getGlyphWidth();
+    int getGlyphHeight() const;
+    void drawChar(int chr, int x, int y);
+    void drawText(const char *text, int length, int x, int y);
+    void clear();
+
+private:
+    GlyphAtlas();
+    Image *getCharset();
+    const Image *getGlyphs();
+    Image *render(ColorFG fg, ColorBG bg);
+
+    Image *charset;             /**< the charset the strips were rendered from */
+    ColorFG fg;
+    ColorBG bg;
+    Image *strips[GLYPH_FG_COLORS][GLYPH_BG_COLORS]; /**< the charset in each color, NULL until used */
+};
+
+#endif /* GLYPHATLAS_H */
@@ -240,7 +240,7 @@ KeyHandler *KeyHandlerController::getKeyHandler() {
  * will drive all of the timed events that this object
  * controls.
  */
-TimedEventMgr::TimedEventMgr(int i) : baseInterval(i) {
+TimedEventMgr::TimedEventMgr(int i) : baseInterval(i), now(0), lastTickTime(0), freeList(-1) {
     m_helper = [[TimedManagerHelper alloc] initWithTimedEventMgr:this];
     [m_helper setInterval:baseInterval];
     [m_helper startTimer];
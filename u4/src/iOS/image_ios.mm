@@ -48,7 +48,7 @@ static CGColorSpaceRef genericColorSpace = 0;
 
 const CGBitmapInfo U4BitmapFlags =  kCGImageAlphaPremultipliedLast | kCGBitmapByteOrderDefault;
 
-Image::Image() : surface(0), cachedImageData(0) {}
+Image::Image() : surface(0), cachedImageData(0), memCategory(MEM_IMAGE_OTHER), memBytes(0) {}
 /**
  * Creates a new image.  Scale is stored to allow drawing using U4
  * (320x200) coordinates, regardless of the actual image scale.
@@ -72,6 +72,9 @@ Image *Image::create(int w, int h, bool indexed, Image::Type type) {
         assert(indexed == false);
         im->surface = CGLayerCreateWithContext(context.get(), CGSizeMake(w, h), 0);
     }
+    im->memCategory = memstats.getOwner();
+    im->memBytes = w * h * 4;
+    memstats.allocate(im->memCategory, im->memBytes);
     return im;
 }
 
@@ -123,6 +126,8 @@ Image *Image::duplicate(Image *image) {
  * Frees the image.
  */
 Image::~Image() {
+    if (memBytes)
+        memstats.release(memCategory, memBytes);
     CGLayerRelease(surface);
     clearCachedImageData();
 }
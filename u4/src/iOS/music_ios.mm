@@ -113,6 +113,10 @@ bool Music::load_sys(const string &pathname) {
 	return true;
 }
 
+void Music::prefetch_sys(const string &/*pathname*/) {
+    // The audio controller loads the whole file when it's played anyway.
+}
+
 /**
  * Returns true if the mixer is playing any audio
  */
@@ -169,6 +169,16 @@ bool SoundManager::load_sys(Sound sound, const std::string &soundPathName) {
 
 
 
+bool SoundManager::synth_sys(Sound /*sound*/) {
+    // There is no PC speaker synthesis here, the sound files are used.
+    return false;
+}
+
+unsigned int SoundManager::pack_sys() {
+    // The audio controllers keep their own samples.
+    return 0;
+}
+
 void SoundManager::play_sys(Sound sound, bool onlyOnce, int specificDurationInTicks) {
     U4AudioController *player = soundChunk.at(sound);
     if (!onlyOnce || ![player isPlaying]) {
@@ -8,6 +8,7 @@
 #include <string>
 #include <stdint.h>
 #include "types.h"
+#include "memstats.h"
 #include "u4file.h"
 #include "textcolor.h"
 
@@ -172,6 +173,8 @@ private:
     const Image &operator=(const Image&);
 
     BackendSurface surface;
+    MemCategory memCategory;    /**< the owner this image's pixels are charged to */
+    size_t memBytes;
 };
 
 #endif /* IMAGE_H */
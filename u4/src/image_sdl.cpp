@@ -14,7 +14,19 @@
 #include "settings.h"
 #include "error.h"
 
-Image::Image() : surface(NULL) {
+extern SDL_Surface *screenBuffer;
+extern bool screenDirty;
+
+/**
+ * Notes that the screen buffer has been drawn on, so that it is
+ * presented the next time round.
+ */
+static inline void touched(const SDL_Surface *surface) {
+    if (surface == screenBuffer)
+        screenDirty = true;
+}
+
+Image::Image() : surface(NULL), memCategory(MEM_IMAGE_OTHER), memBytes(0) {
 }
 
 /**
@@ -60,17 +72,24 @@ Image *Image::create(int w, int h, bool indexed, Image::Type type) {
         return NULL;
     }
 
+    im->memCategory = memstats.getOwner();
+    im->memBytes = im->surface->pitch * im->surface->h;
+    memstats.allocate(im->memCategory, im->memBytes);
+
     return im;
 }
 
 /**
- * Create a special purpose image the represents the whole screen.
+ * Create a special purpose image the represents the whole screen.  It
+ * is the buffer the screen is drawn on before it is presented, which
+ * is also where images are drawn when no other image is given.
  */
 Image *Image::createScreenImage() {
     Image *screen = new Image();
 
-    screen->surface = SDL_GetVideoSurface();
-    ASSERT(screen->surface != NULL, "SDL_GetVideoSurface() returned a NULL screen surface!");
+    screen->surface = screenBuffer;
+    ASSERT(screen->surface != NULL, "the screen buffer hasn't been created!");
+    screen->surface->refcount++;    /* the buffer belongs to the screen code */
     screen->w = screen->surface->w;
     screen->h = screen->surface->h;
     screen->indexed = screen->surface->format->palette != NULL;
@@ -106,6 +125,8 @@ Image *Image::duplicate(Image *image) {
  * Frees the image.
  */
 Image::~Image() {
+    if (memBytes)
+        memstats.release(memCategory, memBytes);
     SDL_FreeSurface(surface);
 }
 
@@ -381,6 +402,7 @@ void Image::putPixelIndex(int x, int y, unsigned int index) {
     int bpp;
     Uint8 *p;
 
+    touched(surface);
     bpp = surface->format->BytesPerPixel;
     p = static_cast<Uint8 *>(surface->pixels) + y * surface->pitch + x * bpp;
 
@@ -425,6 +447,7 @@ void Image::fillRect(int x, int y, int w, int h, int r, int g, int b, int a) {
     dest.h = h;
 
     SDL_FillRect(surface, &dest, pixel);
+    touched(surface);
 }
 
 /**
@@ -485,7 +508,7 @@ void Image::drawOn(Image *d, int x, int y) const {
     SDL_Surface *destSurface;
 
     if (d == NULL)
-        destSurface = SDL_GetVideoSurface();
+        destSurface = screenBuffer;
     else
         destSurface = d->surface;
 
@@ -494,6 +517,7 @@ void Image::drawOn(Image *d, int x, int y) const {
     r.w = w;
     r.h = h;
     SDL_BlitSurface(surface, NULL, destSurface, &r);
+    touched(destSurface);
 }
 
 /**
@@ -504,7 +528,7 @@ void Image::drawSubRectOn(Image *d, int x, int y, int rx, int ry, int rw, int rh
     SDL_Surface *destSurface;
 
     if (d == NULL)
-        destSurface = SDL_GetVideoSurface();
+        destSurface = screenBuffer;
     else
         destSurface = d->surface;
 
@@ -519,6 +543,7 @@ void Image::drawSubRectOn(Image *d, int x, int y, int rx, int ry, int rw, int rh
 
 
     SDL_BlitSurface(surface, &src, destSurface, &dest);
+    touched(destSurface);
 }
 
 /**
@@ -530,7 +555,7 @@ void Image::drawSubRectInvertedOn(Image *d, int x, int y, int rx, int ry, int rw
     SDL_Surface *destSurface;
 
     if (d == NULL)
-        destSurface = SDL_GetVideoSurface();
+        destSurface = screenBuffer;
     else
         destSurface = d->surface;
 
@@ -546,6 +571,7 @@ void Image::drawSubRectInvertedOn(Image *d, int x, int y, int rx, int ry, int rw
 
         SDL_BlitSurface(surface, &src, destSurface, &dest);
     }
+    touched(destSurface);
 }
 
 /**
@@ -13,8 +13,10 @@
 #include "imageloader.h"
 #include "imagemgr.h"
 #include "intro.h"
+#include "memstats.h"
 #include "settings.h"
 #include "u4file.h"
+#include "utils.h"
 
 using std::map;
 using std::string;
@@ -40,6 +42,9 @@ public:
 
 ImageMgr *ImageMgr::instance = NULL;
 
+/* the names of the interned subimages, indexed by handle */
+static std::vector<string> subImageHandleNames;
+
 ImageMgr *ImageMgr::getInstance() {
     if (instance == NULL) {
         instance = new ImageMgr();
@@ -588,6 +593,8 @@ ImageInfo *ImageMgr::get(const string &name, bool returnUnscaled) {
     if (info->image != NULL)
         return info;
 
+    MemOwner owner(MEM_IMAGE_IMAGEMGR);
+
     U4FILE *file = getImageFile(info);
     Image *unscaled = NULL;
     if (file) {
@@ -690,22 +697,42 @@ ImageInfo *ImageMgr::get(const string &name, bool returnUnscaled) {
  * Returns information for the given image set.
  */
 SubImage *ImageMgr::getSubImage(const string &name) {
-    string setname;
+    std::map<string, SubImage *>::iterator i = subImageIndex.find(name);
+    if (i != subImageIndex.end())
+        return i->second;
+    return NULL;
+}
+
+/**
+ * Returns the subimage for a handle from internSubImage, or NULL if
+ * the current image sets have no subimage by that name.
+ */
+SubImage *ImageMgr::getSubImage(SubImageHandle handle) {
+    ASSERT(handle >= 0 && handle < static_cast<int>(subImageHandleNames.size()), "invalid subimage handle %d", handle);
 
-    ImageSet *set = baseSet;
+    while (static_cast<int>(subImagesByHandle.size()) <= handle)
+        subImagesByHandle.push_back(getSubImage(subImageHandleNames[subImagesByHandle.size()]));
 
-    while (set != NULL) {
-        for (std::map<string, ImageInfo *>::iterator i = set->info.begin(); i != set->info.end(); i++) {
-            ImageInfo *info = (ImageInfo *) i->second;
-            std::map<string, SubImage *>::iterator j = info->subImages.find(name);
-            if (j != info->subImages.end())
-                return j->second;
-        }
+    return subImagesByHandle[handle];
+}
 
-        set = getSet(set->extends);
-    }
-        
-    return NULL;
+/**
+ * Returns a handle for the subimage with the given name, so code that
+ * draws the same subimages over and over can look them up without
+ * going through their names each time.  The name does not need to
+ * exist in the current image set.
+ */
+SubImageHandle ImageMgr::internSubImage(const string &name) {
+    static std::map<string, SubImageHandle> handles;
+
+    std::map<string, SubImageHandle>::iterator i = handles.find(name);
+    if (i != handles.end())
+        return i->second;
+
+    SubImageHandle handle = subImageHandleNames.size();
+    subImageHandleNames.push_back(name);
+    handles[name] = handle;
+    return handle;
 }
 
 /**
@@ -739,6 +766,28 @@ void ImageMgr::update(Settings *newSettings) {
     TRACE(*logger, string("base image set is '") + setname + string("'"));
 
     baseSet = getSet(setname);
+    indexSubImages();
+}
+
+/**
+ * Builds the index of subimages visible from the base set.  A subimage
+ * in the base set hides one of the same name in the sets it extends,
+ * and within a set the first image (by name) that has it wins, the
+ * same as when the sets were searched on every lookup.
+ */
+void ImageMgr::indexSubImages() {
+    subImageIndex.clear();
+    subImagesByHandle.clear();
+
+    for (ImageSet *set = baseSet; set != NULL; set = getSet(set->extends)) {
+        for (std::map<string, ImageInfo *>::iterator i = set->info.begin(); i != set->info.end(); i++) {
+            ImageInfo *info = i->second;
+            for (std::map<string, SubImage *>::iterator j = info->subImages.begin(); j != info->subImages.end(); j++)
+                subImageIndex.insert(std::make_pair(j->first, j->second));
+        }
+    }
+
+    TRACE(*logger, string("indexed ") + xu4_to_string(subImageIndex.size()) + string(" subimages"));
 }
 
 ImageSet::~ImageSet() {
@@ -97,6 +97,13 @@ public:
     bool hasBlackBackground();
 };
 
+/**
+ * A handle to a named subimage, from ImageMgr::internSubImage.  Handles
+ * stay valid for the life of the program, across image set changes and
+ * screen reinitialization, so they can be kept in static tables.
+ */
+typedef int SubImageHandle;
+
 /**
  * The image manager singleton that keeps track of all the images.
  */
@@ -107,6 +114,8 @@ public:
 
     ImageInfo *get(const std::string &name, bool returnUnscaled=false);
     SubImage *getSubImage(const std::string &name);
+    SubImage *getSubImage(SubImageHandle handle);
+    static SubImageHandle internSubImage(const std::string &name);
     void freeIntroBackgrounds();
     const std::vector<std::string> &getSetNames();
     U4FILE * getImageFile(ImageInfo *info);
@@ -136,11 +145,14 @@ private:
     void fixupFMTowns(Image *im, int prescale);
 
     void update(Settings *newSettings);
+    void indexSubImages();
 
     static ImageMgr *instance;
     std::map<std::string, ImageSet *> imageSets;
     std::vector<std::string> imageSetNames;
     ImageSet *baseSet;
+    std::map<std::string, SubImage *> subImageIndex; /**< the subimages visible from the base set, by name */
+    std::vector<SubImage *> subImagesByHandle;       /**< subimages resolved so far, by handle */
 
     Debug *logger;
 };
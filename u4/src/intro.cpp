@@ -21,11 +21,13 @@
 #include "error.h"
 #include "event.h"
 #include "imagemgr.h"
+#include "memstats.h"
 #include "menu.h"
 #include "music.h"
 #include "sound.h"
 #include "player.h"
 #include "savegame.h"
+#include "savewriter.h"
 #include "screen.h"
 #include "settings.h"
 #include "shrine.h"
@@ -358,6 +360,13 @@ void IntroController::deleteIntro() {
     delete [] objectStateTable;
     objectStateTable = NULL;
 
+    for (std::vector<AnimElement>::iterator i = titles.begin(); i != titles.end(); i++) {
+        delete i->srcImage;
+        delete i->destImage;
+    }
+    titles.clear();
+    title = titles.begin();
+
     imageMgr->freeIntroBackgrounds();
 }
 
@@ -752,14 +761,6 @@ void IntroController::finishInitiateGame(const string &nameBuffer, SexType sex)
     SaveGame saveGame;
     SaveGamePlayerRecord avatar;
 
-    FILE *saveGameFile = fopen((settings.getUserPath() + PARTY_SAV_BASE_FILENAME).c_str(), "wb");
-    if (!saveGameFile) {
-        questionArea.disableCursor();
-        errorMessage = "Unable to create save game!";
-        updateScreen();
-        return;
-    }
-
     avatar.init();
     strcpy(avatar.name, nameBuffer.c_str());
     avatar.sex = sex;
@@ -771,13 +772,20 @@ void IntroController::finishInitiateGame(const string &nameBuffer, SexType sex)
     saveGame.reagents[REAG_GINSENG] = 3;
     saveGame.reagents[REAG_GARLIC] = 4;
     saveGame.torches = 2;
-    saveGame.write(saveGameFile);
-    fclose(saveGameFile);
 
-    saveGameFile = fopen((settings.getUserPath() + MONSTERS_SAV_BASE_FILENAME).c_str(), "wb");
-    if (saveGameFile) {
-        saveGameMonstersWrite(NULL, saveGameFile);
-        fclose(saveGameFile);
+    string buffer;
+    saveGame.write(buffer);
+    saveWriter.add(settings.getUserPath() + PARTY_SAV_BASE_FILENAME, buffer);
+
+    buffer.erase();
+    saveGameMonstersWrite(NULL, buffer);
+    saveWriter.add(settings.getUserPath() + MONSTERS_SAV_BASE_FILENAME, buffer);
+
+    if (!saveWriter.commit()) {
+        questionArea.disableCursor();
+        errorMessage = "Unable to create save game!";
+        updateScreen();
+        return;
     }
     justInitiatedNewGame = true;
 
@@ -1048,9 +1056,9 @@ void IntroController::timerFired() {
     if (EventHandler::timerQueueEmpty())
         screenRedrawScreen();
 
-    if (xu4_random(2) && ++beastie1Cycle >= IntroBinData::BEASTIE1_FRAMES)
+    if (xu4_random(2, RANDOM_COSMETIC) && ++beastie1Cycle >= IntroBinData::BEASTIE1_FRAMES)
         beastie1Cycle = 0;
-    if (xu4_random(2) && ++beastie2Cycle >= IntroBinData::BEASTIE2_FRAMES)
+    if (xu4_random(2, RANDOM_COSMETIC) && ++beastie2Cycle >= IntroBinData::BEASTIE2_FRAMES)
         beastie2Cycle = 0;
 }
 
@@ -1585,6 +1593,7 @@ void IntroController::getTitleSourceData()
 {
     unsigned int r, g, b, a;        // color values
     unsigned char *srcData;         // plot data
+    MemOwner owner(MEM_IMAGE_INTRO);
 
     // The BKGD_INTRO image is assumed to have not been
     // loaded yet.  The unscaled version will be loaded
@@ -2106,6 +2115,7 @@ void IntroController::compactTitle()
 void IntroController::drawTitle()
 {
     Image *scaled;      // the scaled and filtered image
+    MemOwner owner(MEM_IMAGE_INTRO);
 
     // blit the scaled and filtered surface to the screen
     if (title->prescaled)
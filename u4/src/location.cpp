@@ -18,6 +18,7 @@
 #include "game.h"
 #include "map.h"
 #include "object.h"
+#include "profile.h"
 #include "savegame.h"
 #include "settings.h"
 #include "tileset.h"
@@ -45,11 +46,12 @@ Location::Location(MapCoords coords, Map *map, int viewmode, LocationContext ctx
  * Return the entire stack of objects at the given location.
  */
 std::vector<MapTile> Location::tilesAt(MapCoords coords, bool &focus) {
+    PROFILE_ZONE(PROF_TILES_AT);
     std::vector<MapTile> tiles;
     std::list<Annotation *> a = map->annotations->ptrsToAllAt(coords);
     std::list<Annotation *>::iterator i;
     Object *obj = map->objectAt(coords);
-    Creature *m = dynamic_cast<Creature *>(obj);
+    Creature *m = toCreature(obj);
     focus = false;
 
     bool avatar = this->coords == coords;
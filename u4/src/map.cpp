@@ -4,6 +4,8 @@
 
 #include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
 
+#include <algorithm>
+#include <utility>
 #include "u4.h"
 
 #include "map.h"
@@ -13,11 +15,13 @@
 #include "debug.h"
 #include "direction.h"
 #include "location.h"
+#include "memstats.h"
 #include "movement.h"
 #include "object.h"
 #include "person.h"
 #include "player.h"
 #include "portal.h"
+#include "profile.h"
 #include "savegame.h"
 #include "tileset.h"
 #include "tilemap.h"
@@ -171,10 +175,10 @@ Direction MapCoords::pathTo(const MapCoords &c, int valid_directions, bool towar
 
     /* get the new direction to move */
     if (directionsToObject > DIR_NONE)
-        return dirRandomDir(directionsToObject);
+        return dirRandomDir(directionsToObject, RANDOM_AI);
 
     /* there are no valid directions that lead to our target, just move wherever we can! */
-    else return dirRandomDir(valid_directions);
+    else return dirRandomDir(valid_directions, RANDOM_AI);
 }
 
 /**
@@ -253,9 +257,12 @@ Map::Map() {
     id = 0;
     tileset = NULL;
     tilemap = NULL;
+    dataBytes = 0;
 }
 
 Map::~Map() {
+    if (dataBytes)
+        memstats.release(MEM_MAP_DATA, dataBytes);
     for (PortalList::iterator i = portals.begin(); i != portals.end(); i++)
         delete *i;
     delete annotations;
@@ -271,26 +278,168 @@ string Map::getName() {
  */
 Object *Map::objectAt(const Coords &coords) {
     /* FIXME: return a list instead of one object */
-    ObjectDeque::const_iterator i;        
+    const ObjectTable::Cell *cell = objectTable.getCell(ObjectTable::cellOf(coords.x), ObjectTable::cellOf(coords.y), coords.z);
+    std::vector<std::pair<long, Object *> > here;
     Object *objAt = NULL;    
 
-    for(i = objects.begin(); i != objects.end(); i++) {
-        Object *obj = *i;
+    if (!cell)
+        return NULL;
+
+    /* look at the objects in the order they are on the map, as ties
+       go to the first one */
+    for (ObjectTable::Cell::const_iterator i = cell->begin(); i != cell->end(); i++) {
+        if ((*i)->getCoords() == coords)
+            here.push_back(std::make_pair(objectTable.getOrder(*i), *i));
+    }
+    std::sort(here.begin(), here.end());
+
+    for (unsigned int i = 0; i < here.size(); i++) {
+        Object *obj = here[i].second;
         
-        if (obj->getCoords() == coords) {
-            /* get the most visible object */
-            if (objAt && (objAt->getType() == Object::UNKNOWN) && (obj->getType() != Object::UNKNOWN))
-                objAt = obj;
-            /* give priority to objects that have the focus */
-            else if (objAt && (!objAt->hasFocus()) && (obj->hasFocus()))
-                objAt = obj;
-            else if (!objAt)
-                objAt = obj;
-        }
+        /* get the most visible object */
+        if (objAt && (objAt->getType() == Object::UNKNOWN) && (obj->getType() != Object::UNKNOWN))
+            objAt = obj;
+        /* give priority to objects that have the focus */
+        else if (objAt && (!objAt->hasFocus()) && (obj->hasFocus()))
+            objAt = obj;
+        else if (!objAt)
+            objAt = obj;
     }
     return objAt;
 }
 
+/**
+ * Returns the distance between two points, taking into account
+ * whether the map wraps around.  With diagonals, a diagonal step
+ * counts as one; otherwise, as two.  Returns -1 if the points are on
+ * different levels.
+ */
+int Map::gridDistance(const Coords &from, const Coords &to, bool diagonals) const {
+    if (from.z != to.z)
+        return -1;
+
+    int dx = abs(from.x - to.x);
+    int dy = abs(from.y - to.y);
+    if (border_behavior == BORDER_WRAP) {
+        if (dx > signed(width) - dx)
+            dx = width - dx;
+        if (dy > signed(height) - dy)
+            dy = height - dy;
+    }
+
+    if (diagonals)
+        return dx > dy ? dx : dy;
+    return dx + dy;
+}
+
+bool Map::matchesFilter(const Object *obj, ObjectFilter filter) {
+    switch (filter) {
+    case FILTER_CREATURES:
+        return isCreature(obj);
+    case FILTER_PARTY:
+        return isPartyMember(obj);
+    case FILTER_NON_PARTY:
+        return isCreature(obj) && !isPartyMember(obj);
+    default:
+        return true;
+    }
+}
+
+/**
+ * Lists the cells along one axis that hold the tiles from lo to hi,
+ * each cell once.  On a wrapping map the tile coordinates are wrapped
+ * first, since the last cell may be narrower than CELL_SIZE.
+ */
+static void cellsCovering(int lo, int hi, int size, bool wrap, std::vector<int> &cells) {
+    if (!wrap) {
+        for (int cell = ObjectTable::cellOf(lo); cell <= ObjectTable::cellOf(hi); cell++)
+            cells.push_back(cell);
+        return;
+    }
+
+    if (hi - lo + 1 >= size) {
+        lo = 0;
+        hi = size - 1;
+    }
+    for (int t = lo; t <= hi; t++) {
+        int cell = ObjectTable::cellOf((t % size + size) % size);
+        if (std::find(cells.begin(), cells.end(), cell) == cells.end())
+            cells.push_back(cell);
+    }
+}
+
+/**
+ * Collects the objects that pass the filter and are no further than
+ * radius from the center, in no particular order.
+ */
+void Map::getObjectsWithin(const Coords &center, int radius, ObjectFilter filter, bool diagonals, std::vector<Object *> &result) const {
+    bool wrap = border_behavior == BORDER_WRAP && width > 0 && height > 0;
+    std::vector<int> cellsX, cellsY;
+
+    cellsCovering(center.x - radius, center.x + radius, width, wrap, cellsX);
+    cellsCovering(center.y - radius, center.y + radius, height, wrap, cellsY);
+
+    for (std::vector<int>::iterator cy = cellsY.begin(); cy != cellsY.end(); cy++) {
+        for (std::vector<int>::iterator cx = cellsX.begin(); cx != cellsX.end(); cx++) {
+            const ObjectTable::Cell *cell = objectTable.getCell(*cx, *cy, center.z);
+            if (!cell)
+                continue;
+
+            for (ObjectTable::Cell::const_iterator i = cell->begin(); i != cell->end(); i++) {
+                int d = gridDistance(center, (*i)->getCoords(), diagonals);
+                if (d >= 0 && d <= radius && matchesFilter(*i, filter))
+                    result.push_back(*i);
+            }
+        }
+    }
+}
+
+namespace {
+    struct NearerThan {
+        NearerThan(const Map *m, const Coords &c, bool d) : map(m), center(c), diagonals(d) {}
+        bool operator()(const Object *a, const Object *b) const {
+            return map->gridDistance(center, a->getCoords(), diagonals) < map->gridDistance(center, b->getCoords(), diagonals);
+        }
+        const Map *map;
+        Coords center;
+        bool diagonals;
+    };
+}
+
+/**
+ * Collects the k objects that pass the filter and are nearest to the
+ * center, nearest first, skipping the excluded object.  Any further
+ * objects as near as the kth one are included as well, so callers
+ * can break ties themselves.  The search widens a ring of cells at a
+ * time, and stops once no unsearched cell could hold anything nearer.
+ */
+void Map::getNearestObjects(const Coords &center, unsigned int k, ObjectFilter filter, const Object *exclude, bool diagonals, std::vector<Object *> &result) const {
+    std::vector<Object *> found;
+    int maxRadius = width > height ? width : height;
+    NearerThan nearer(this, center, diagonals);
+
+    if (k == 0)
+        return;
+
+    for (int radius = ObjectTable::CELL_SIZE - 1; ; radius += ObjectTable::CELL_SIZE) {
+        found.clear();
+        getObjectsWithin(center, radius, filter, diagonals, found);
+        found.erase(std::remove(found.begin(), found.end(), exclude), found.end());
+
+        /* everything within radius has been seen, so if the kth
+           nearest is within it, nothing outside can displace it */
+        if (found.size() >= k || radius >= maxRadius * 2)
+            break;
+    }
+
+    std::stable_sort(found.begin(), found.end(), nearer);
+
+    unsigned int n = k < found.size() ? k : found.size();
+    while (n < found.size() && !nearer(found[n - 1], found[n]))
+        n++;
+    result.insert(result.end(), found.begin(), found.begin() + n);
+}
+
 /**
  * Returns the portal for the correspoding action(s) given.
  * If there is no portal that corresponds to the actions flagged
@@ -444,7 +593,7 @@ Creature *Map::addCreature(const Creature *creature, Coords coords) {
         m->setVisible(false);
     
     /* place the creature on the map */
-    objects.push_back(m);
+    appendObject(m);
     return m;
 }
 
@@ -452,7 +601,7 @@ Creature *Map::addCreature(const Creature *creature, Coords coords) {
  * Adds an object to the given map
  */
 Object *Map::addObject(Object *obj, Coords coords) {
-    objects.push_front(obj);
+    prependObject(obj);
     return obj;
 }
 
@@ -465,11 +614,32 @@ Object *Map::addObject(MapTile tile, MapTile prevtile, Coords coords) {
     obj->setPrevCoords(coords);
     obj->setMap(this);
     
-    objects.push_front(obj);    
+    prependObject(obj);
 
     return obj;
 }
 
+/**
+ * Puts an object at the front of the object list, which is where
+ * objects other than creatures go.
+ */
+void Map::prependObject(Object *obj) {
+    obj->setMap(this);
+    objects.push_front(obj);
+    objectTable.pushFront(obj);
+    objectAdded(obj, true);
+}
+
+/**
+ * Puts an object at the end of the object list.
+ */
+void Map::appendObject(Object *obj) {
+    obj->setMap(this);
+    objects.push_back(obj);
+    objectTable.pushBack(obj);
+    objectAdded(obj, false);
+}
+
 /**
  * Removes an object from the map
  */ 
@@ -482,6 +652,8 @@ void Map::removeObject(const Object *rem, bool deleteObject) {
     ObjectDeque::iterator i;
     for (i = objects.begin(); i != objects.end(); i++) {
         if (*i == rem) {
+            objectTable.erase(*i);
+            objectRemoved(*i);
             /* Party members persist through different maps, so don't delete them! */
             if (!isPartyMember(*i) && deleteObject)
                 delete (*i);
@@ -492,6 +664,8 @@ void Map::removeObject(const Object *rem, bool deleteObject) {
 }
 
 ObjectDeque::iterator Map::removeObject(ObjectDeque::iterator rem, bool deleteObject) {
+    objectTable.erase(*rem);
+    objectRemoved(*rem);
     /* Party members persist through different maps, so don't delete them! */
     if (!isPartyMember(*rem) && deleteObject)
         delete (*rem);
@@ -504,28 +678,43 @@ ObjectDeque::iterator Map::removeObject(ObjectDeque::iterator rem, bool deleteOb
  * Also performs special creature actions and creature effects.
  */
 Creature *Map::moveObjects(MapCoords avatar) {        
+    PROFILE_ZONE(PROF_MOVE_OBJECTS);
     Creature *attacker = NULL;
-    
-    for (unsigned int i = 0; i < objects.size(); i++) {
-        Creature *m = dynamic_cast<Creature*>(objects[i]);
-        
-        if (m) {
+    std::vector<ObjectTable::Row> rows;
+
+    /* special effects may remove objects along the way, so the rows
+       are listed up front and checked before each one is used */
+    objectTable.getRows(rows);
+    for (unsigned int r = 0; r < rows.size(); r++) {
+        if (!objectTable.isCurrent(rows[r]))
+            continue;
+
+        unsigned int i = rows[r].slot;
+        int flags = objectTable.getFlags(i);
+
+        if (flags & ObjectTable::OT_CREATURE) {
             /* check if the object is an attacking creature and not
                just a normal, docile person in town or an inanimate object */
-            if ((m->getType() == Object::PERSON && m->getMovementBehavior() == MOVEMENT_ATTACK_AVATAR) ||
-                (m->getType() == Object::CREATURE && m->willAttack())) {
-                MapCoords o_coords = m->getCoords();
+            if (flags & ObjectTable::OT_ATTACKS) {
+                MapCoords o_coords = objectTable.getCoords(i);
             
                 /* don't move objects that aren't on the same level as us */
                 if (o_coords.z != avatar.z)
                     continue;
 
                 if (o_coords.movementDistance(avatar, this) <= 1) {
-                    attacker = m;
+                    attacker = toCreature(objectTable.getObject(i));
                     continue;
                 }
             }
 
+            /* a creature that stays put and has nothing special to do
+               wouldn't do anything below, so leave it be */
+            if (objectTable.getMovementBehavior(i) == MOVEMENT_FIXED && !(flags & ObjectTable::OT_SPECIAL))
+                continue;
+
+            Creature *m = toCreature(objectTable.getObject(i));
+
             /* Before moving, Enact any special effects of the creature (such as storms eating objects, whirlpools teleporting, etc.) */
             m->specialEffect();
 
@@ -566,6 +755,8 @@ void Map::resetObjectAnimations() {
  */
 void Map::clearObjects() {
     objects.clear();    
+    objectTable.clear();
+    objectsCleared();
 }
 
 /**
@@ -640,7 +831,7 @@ int Map::getValidMoves(MapCoords from, MapTile transport) {
         MapTile prev_tile = *tileAt(from, WITHOUT_OBJECTS);
 
         // get the other creature object, if it exists (the one that's being moved onto)        
-        to_m = dynamic_cast<Creature*>(obj);
+        to_m = toCreature(obj);
 
         // move on if unable to move onto the avatar or another creature
         if (m && !isAvatar) { // some creatures/persons have the same tile as the avatar, so we have to adjust
@@ -766,6 +957,18 @@ const MapCoords &Map::getLabel(const string &name) const {
     return i->second;
 }
 
+/**
+ * Brings the map data charged to memstats up to date with the data
+ * actually held; called whenever the data is (re)loaded.
+ */
+void Map::updateMemStats() {
+    if (dataBytes)
+        memstats.release(MEM_MAP_DATA, dataBytes);
+    dataBytes = data.capacity() * sizeof(MapTile);
+    if (dataBytes)
+        memstats.allocate(MEM_MAP_DATA, dataBytes);
+}
+
 bool Map::fillMonsterTable() {
     ObjectDeque::iterator current;
     Object *obj;    
@@ -788,7 +991,7 @@ bool Map::fillMonsterTable() {
 
         /* moving objects first */
         if ((obj->getType() == Object::CREATURE) && (obj->getMovementBehavior() != MOVEMENT_FIXED)) {
-            Creature *c = dynamic_cast<Creature*>(obj);            
+            Creature *c = toCreature(obj);            
             /* whirlpools and storms are separated from other moving objects */
             if (c->getId() == WHIRLPOOL_ID || c->getId() == STORM_ID)            
                 monsters.push_back(obj);
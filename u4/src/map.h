@@ -14,6 +14,7 @@
 #include "direction.h"
 #include "music.h"
 #include "object.h"
+#include "objecttable.h"
 #include "savegame.h"
 #include "types.h"
 #include "u4file.h"
@@ -91,6 +92,16 @@ public:
         BORDER_FIXED
     };
 
+    /**
+     * Which objects the neighbor queries return.
+     */
+    enum ObjectFilter {
+        FILTER_ALL,
+        FILTER_CREATURES,       /**< creatures, including party members */
+        FILTER_PARTY,           /**< party members only */
+        FILTER_NON_PARTY        /**< creatures that aren't party members */
+    };
+
 
     class Source {
     public:
@@ -108,6 +119,9 @@ public:
     virtual string getName();
     
     class Object *objectAt(const Coords &coords);    
+    int gridDistance(const Coords &from, const Coords &to, bool diagonals) const;
+    void getObjectsWithin(const Coords &center, int radius, ObjectFilter filter, bool diagonals, std::vector<Object *> &result) const;
+    void getNearestObjects(const Coords &center, unsigned int k, ObjectFilter filter, const Object *exclude, bool diagonals, std::vector<Object *> &result) const;
     const Portal *portalAt(const Coords &coords, int actionFlags);
     MapTile* getTileFromData(const Coords &coords);
     MapTile* tileAt(const Coords &coords, int withObjects);
@@ -127,6 +141,7 @@ public:
     bool move(Object *obj, Direction d);
     void alertGuards();
     const MapCoords &getLabel(const string &name) const;
+    void updateMemStats();
 
     // u4dos compatibility
     bool fillMonsterTable();    
@@ -156,6 +171,7 @@ public:
     Music::Type     music;
     MapData         data;
     ObjectDeque     objects;
+    ObjectTable     objectTable;    /**< per-turn state of objects */
     std::map<string, MapCoords> labels;
     Tileset        *tileset;
     TileMap        *tilemap;
@@ -163,6 +179,19 @@ public:
     // u4dos compatibility
     SaveGameMonsterRecord monsterTable[MONSTERTABLE_SIZE];
 
+protected:
+    void prependObject(Object *obj);
+    void appendObject(Object *obj);
+
+    /*
+     * Notifications for subclasses that keep track of the objects on
+     * the map; every change to objects is expected to go through the
+     * add/remove/clear methods above.
+     */
+    virtual void objectAdded(Object *obj, bool atFront) {}
+    virtual void objectRemoved(Object *obj) {}
+    virtual void objectsCleared() {}
+
 private:
     // disallow map copying: all maps should be created and accessed
     // through the MapMgr
@@ -170,6 +199,9 @@ private:
     Map &operator=(const Map &map);
 
     void findWalkability(Coords coords, int *path_data);
+    static bool matchesFilter(const Object *obj, ObjectFilter filter);
+
+    size_t          dataBytes;  /**< size of data as last reported to memstats */
 };
 
 #endif
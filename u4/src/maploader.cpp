@@ -319,6 +319,7 @@ bool DngMapLoader::load(Map *map) {
         dungeon->data.push_back(tile);
         dungeon->dataSubTokens.push_back(mapData % 16);
     }
+    dungeon->initTokens();
 
     /* read in the dungeon rooms */
     /* FIXME: needs a cleanup function to free this memory later */
@@ -453,6 +454,7 @@ void DngMapLoader::initDungeonRoom(Dungeon *dng, int room) {
     dng->roomMaps[room]->border_behavior = Map::BORDER_FIXED;
     dng->roomMaps[room]->width = dng->roomMaps[room]->height = 11;
     dng->roomMaps[room]->data = dng->rooms[room].map_data; // Load map data
+    dng->roomMaps[room]->updateMemStats();
     dng->roomMaps[room]->music = Music::COMBAT;
     dng->roomMaps[room]->type = Map::COMBAT;
     dng->roomMaps[room]->flags |= NO_LINE_OF_SIGHT;
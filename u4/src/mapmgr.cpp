@@ -17,6 +17,7 @@
 #include "map.h"
 #include "maploader.h"
 #include "mapmgr.h"
+#include "memstats.h"
 #include "moongate.h"
 #include "person.h"
 #include "portal.h"
@@ -33,6 +34,14 @@ using std::pair;
 MapMgr *MapMgr::instance = NULL;
 
 extern bool isAbyssOpened(const Portal *p);
+
+/**
+ * Returns the memory held by map data and dialogues, the two things
+ * loading a map allocates.
+ */
+static size_t mapMemory() {
+    return memstats.getLive(MEM_MAP_DATA) + memstats.getLive(MEM_DIALOGUE);
+}
 extern bool shrineCanEnter(const Portal *p);
 
 MapMgr *MapMgr::getInstance() {
@@ -71,7 +80,16 @@ MapMgr::~MapMgr() {
     delete logger;
 }
 
+/**
+ * Throws away a map's data, people and dialogues, and puts a fresh
+ * copy of the map in its place, to be loaded again when it is next
+ * needed.  Everything its load charged to memstats should be released
+ * again; anything left over is reported as growth.
+ */
 void MapMgr::unloadMap(MapId id) {
+    size_t before = mapMemory();
+    string name = mapList[id]->fname;
+
     delete mapList[id];
     const Config *config = Config::getInstance();
     vector<ConfigElement> maps = config->getElement("maps").getChildren();
@@ -84,6 +102,9 @@ void MapMgr::unloadMap(MapId id) {
         }
     }
 
+    memstats.checkGrowth(("map data and dialogues after unloading " + name).c_str(),
+                         before - loadedBytes[id], mapMemory());
+    loadedBytes.erase(id);
 }
 
 Map *MapMgr::initMap(Map::Type type) {
@@ -127,11 +148,22 @@ Map *MapMgr::get(MapId id) {
 
         TRACE_LOCAL(*logger, string("loading map data for map \'") + mapList[id]->fname + "\'");
 
+        size_t before = mapMemory();
         loader->load(mapList[id]);
+        mapList[id]->updateMemStats();
+        loadedBytes[id] = mapMemory() - before;
     }
     return mapList[id];
 }
 
+/**
+ * Returns a map without loading its data, for looking at its
+ * properties, or NULL if there is no such map.
+ */
+const Map *MapMgr::peek(MapId id) const {
+    return id < mapList.size() ? mapList[id] : NULL;
+}
+
 void MapMgr::registerMap(Map *map) {
     if (mapList.size() <= map->id)
         mapList.resize(map->id + 1, NULL);
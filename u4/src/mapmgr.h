@@ -5,6 +5,7 @@
 #ifndef MAPMGR_H
 #define MAPMGR_H
 
+#include <map>
 #include <vector>
 #include <utility>
 
@@ -90,6 +91,7 @@ public:
     static void destroy();
 
     Map *get(MapId id);
+    const Map *peek(MapId id) const;
     Map *initMap(Map::Type type);
     void unloadMap(MapId id);
 
@@ -112,6 +114,7 @@ private:
 
     static MapMgr *instance;
     std::vector<Map *> mapList;
+    std::map<MapId, size_t> loadedBytes;    /**< map and dialogue memory charged by each load */
     Debug *logger;
 };
 
@@ -0,0 +1,136 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include <cstdlib>
+#include <cstring>
+
+#include "memstats.h"
+
+#include "debug.h"
+#include "screen.h"
+
+static const char *memCategoryNames[MEM_MAX] = {
+    "images",
+    "tiles",
+    "imagemgr",
+    "intro",
+    "views",
+    "maps",
+    "dialogue"
+};
+
+MemStats &MemStats::getInstance() {
+    static MemStats *instance = NULL;
+    if (instance == NULL)
+        instance = new MemStats();
+    return *instance;
+}
+
+MemStats::MemStats() : owner(MEM_IMAGE_OTHER), strict(false) {
+    memset(stats, 0, sizeof(stats));
+}
+
+void MemStats::allocate(MemCategory category, size_t bytes) {
+    Stat &s = stats[category];
+
+    s.live += bytes;
+    s.count++;
+    if (s.live > s.peak)
+        s.peak = s.live;
+}
+
+void MemStats::release(MemCategory category, size_t bytes) {
+    Stat &s = stats[category];
+
+    ASSERT(s.live >= bytes && s.count > 0, "releasing more %s memory than was allocated", memCategoryNames[category]);
+    s.live -= bytes;
+    s.count--;
+}
+
+/**
+ * Makes the given category the owner of images created from now on,
+ * and returns the previous owner.
+ */
+MemCategory MemStats::setOwner(MemCategory category) {
+    MemCategory prev = owner;
+    owner = category;
+    return prev;
+}
+
+/**
+ * Returns the number of bytes held by images of all categories.
+ */
+size_t MemStats::getImageLive() const {
+    size_t total = 0;
+    for (int i = MEM_IMAGE_OTHER; i <= MEM_IMAGE_VIEW; i++)
+        total += stats[i].live;
+    return total;
+}
+
+size_t MemStats::getTotalLive() const {
+    size_t total = 0;
+    for (int i = 0; i < MEM_MAX; i++)
+        total += stats[i].live;
+    return total;
+}
+
+/**
+ * Compares the bytes left resident after some teardown with those
+ * left after the previous one.  Returns false, after warning and
+ * logging the counts, if they grew; in strict mode the counts are
+ * dumped to stderr and the program exits instead.
+ */
+bool MemStats::checkGrowth(const char *what, size_t before, size_t after) const {
+    if (after <= before)
+        return true;
+
+    fprintf(stderr, "warning: %lu bytes of %s left resident, up from %lu\n",
+            static_cast<unsigned long>(after), what, static_cast<unsigned long>(before));
+    log();
+    if (strict) {
+        dump(stderr);
+        exit(1);
+    }
+    return false;
+}
+
+/**
+ * Writes the live and peak byte counts of each category to the given
+ * file.
+ */
+void MemStats::dump(FILE *out) const {
+    fprintf(out, "%-10s %8s %12s %12s\n", "category", "count", "live", "peak");
+    for (int i = 0; i < MEM_MAX; i++)
+        fprintf(out, "%-10s %8lu %12lu %12lu\n", memCategoryNames[i], stats[i].count,
+                static_cast<unsigned long>(stats[i].live), static_cast<unsigned long>(stats[i].peak));
+    fprintf(out, "%-10s %8s %12lu\n", "total", "", static_cast<unsigned long>(getTotalLive()));
+}
+
+/**
+ * Writes the current counts to the debug log, if logging for
+ * "MemStats" is enabled.
+ */
+void MemStats::log() const {
+    static Debug logger("debug/memstats.txt", "MemStats");
+    char buffer[128];
+
+    for (int i = 0; i < MEM_MAX; i++) {
+        snprintf(buffer, sizeof(buffer), "%s: %lu allocations, %lu bytes live, %lu bytes peak", memCategoryNames[i],
+                 stats[i].count, static_cast<unsigned long>(stats[i].live), static_cast<unsigned long>(stats[i].peak));
+        TRACE_LOCAL(logger, buffer);
+    }
+}
+
+/**
+ * Prints the live and peak kilobytes of each category in the message
+ * area.
+ */
+void MemStats::show() const {
+    screenMessage("Live/peak KB:\n");
+    for (int i = 0; i < MEM_MAX; i++)
+        screenMessage("%-6.6s%4lu/%4lu\n", memCategoryNames[i],
+                      static_cast<unsigned long>(stats[i].live / 1024), static_cast<unsigned long>(stats[i].peak / 1024));
+}
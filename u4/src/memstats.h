@@ -0,0 +1,90 @@
+/*
+ * $Id$
+ */
+
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <cstdio>
+#include <cstddef>
+
+/**
+ * The owners that tracked allocations are charged to.  Keep
+ * memCategoryNames in memstats.cpp in sync.
+ */
+typedef enum {
+    MEM_IMAGE_OTHER,
+    MEM_IMAGE_TILES,
+    MEM_IMAGE_IMAGEMGR,
+    MEM_IMAGE_INTRO,
+    MEM_IMAGE_VIEW,
+    MEM_MAP_DATA,
+    MEM_DIALOGUE,
+    MEM_MAX
+} MemCategory;
+
+/**
+ * Keeps a running count of the memory held by images, map data and
+ * dialogues, broken down by owner.  Images are charged to whichever
+ * category is current when they are created (see MemOwner), and
+ * remember it so they are credited back to the same one when freed.
+ * For each category the live byte and allocation counts and the
+ * high-water mark are kept.
+ *
+ * Checks for growth only warn by default.  In strict mode (--memcheck)
+ * a failed check ends the program with a non-zero exit status, so a
+ * scripted run can be used as a test.
+ */
+class MemStats {
+public:
+    static MemStats &getInstance();
+
+    void allocate(MemCategory category, size_t bytes);
+    void release(MemCategory category, size_t bytes);
+
+    MemCategory getOwner() const { return owner; }
+    MemCategory setOwner(MemCategory category);
+
+    size_t getLive(MemCategory category) const { return stats[category].live; }
+    size_t getPeak(MemCategory category) const { return stats[category].peak; }
+    unsigned long getCount(MemCategory category) const { return stats[category].count; }
+    size_t getImageLive() const;
+    size_t getTotalLive() const;
+
+    bool checkGrowth(const char *what, size_t before, size_t after) const;
+    void setStrict(bool strict) { this->strict = strict; }
+    bool isStrict() const { return strict; }
+
+    void dump(FILE *out) const;
+    void log() const;
+    void show() const;
+
+private:
+    MemStats();
+
+    struct Stat {
+        size_t live, peak;
+        unsigned long count;
+    };
+
+    MemCategory owner;
+    Stat stats[MEM_MAX];
+    bool strict;                /**< exit when a check finds growth */
+};
+
+/**
+ * Makes a category the owner of images created for the lifetime of
+ * the object, restoring the previous owner afterwards.
+ */
+class MemOwner {
+public:
+    MemOwner(MemCategory category) : prev(MemStats::getInstance().setOwner(category)) {}
+    ~MemOwner() { MemStats::getInstance().setOwner(prev); }
+
+private:
+    MemCategory prev;
+};
+
+#define memstats (MemStats::getInstance())
+
+#endif /* MEMSTATS_H */
@@ -0,0 +1,157 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include "minimap.h"
+
+#include "context.h"
+#include "image.h"
+#include "imagemgr.h"
+#include "location.h"
+#include "map.h"
+#include "settings.h"
+#include "tile.h"
+#include "tileset.h"
+
+/* a map position not drawn in the raster yet */
+#define MINIMAP_UNKNOWN ((TileId) -1)
+
+Minimap &Minimap::getInstance() {
+    static Minimap *instance = NULL;
+    if (instance == NULL)
+        instance = new Minimap();
+    return *instance;
+}
+
+Minimap::Minimap() : map(NULL), z(0), raster(NULL) {
+}
+
+/**
+ * Returns true if the minimap is turned on and there is a map it can
+ * show; dungeons and combat maps have none.
+ */
+bool Minimap::isShown() const {
+    if (!settings.minimap || !c || !c->location)
+        return false;
+
+    const Map *current = c->location->map;
+    return (current->type == Map::WORLD || current->type == Map::CITY) && !(current->flags & FIRST_PERSON);
+}
+
+/**
+ * Returns true if the minimap is shown and overlaps the given area of
+ * the (unscaled) screen.
+ */
+bool Minimap::covers(int x, int y, int width, int height) const {
+    if (!isShown())
+        return false;
+
+    return x < settings.minimapX + settings.minimapSize && x + width > settings.minimapX &&
+        y < settings.minimapY + settings.minimapSize && y + height > settings.minimapY;
+}
+
+/**
+ * Brings the part of the raster around the party up to date and draws
+ * it on the screen, scaled up, with the party's position marked.
+ */
+void Minimap::draw() {
+    if (!isShown())
+        return;
+
+    Map *current = c->location->map;
+    const Coords &party = c->location->coords;
+    prepare(current, party.z);
+
+    int zoom = settings.minimapZoom;
+    int tileSize = zoom * settings.scale;
+    int span = settings.minimapSize / zoom;
+    int width = span < static_cast<int>(current->width) ? span : current->width;
+    int height = span < static_cast<int>(current->height) ? span : current->height;
+
+    /* keep the party in the middle, but don't look past the edges */
+    int left = party.x - width / 2;
+    if (left > static_cast<int>(current->width) - width)
+        left = current->width - width;
+    if (left < 0)
+        left = 0;
+    int top = party.y - height / 2;
+    if (top > static_cast<int>(current->height) - height)
+        top = current->height - height;
+    if (top < 0)
+        top = 0;
+
+    for (int y = top; y < top + height; y++) {
+        for (int x = left; x < left + width; x++) {
+            TileId id = current->getTileFromData(Coords(x, y, z))->getId();
+            TileId &cell = cells[y * current->width + x];
+            if (cell == id)
+                continue;
+
+            Tile *tile = Tileset::findTileById(id);
+            if (tile) {
+                const RGBA &color = tile->getAverageColor();
+                raster->putPixel(x, y, color.r, color.g, color.b, IM_OPAQUE);
+            }
+            cell = id;
+        }
+    }
+
+    Image *screen = imageMgr->get("screen")->image;
+    int screenX = settings.minimapX * settings.scale;
+    int screenY = settings.minimapY * settings.scale;
+
+    if (width < span || height < span)
+        screen->fillRect(screenX, screenY, span * tileSize, span * tileSize, 0, 0, 0);
+
+    /* scale the window up a run of same colored tiles at a time */
+    for (int y = 0; y < height; y++) {
+        int run = 0;
+        unsigned int runPixel, pixel = 0;
+        raster->getPixelIndex(left, top + y, runPixel);
+        for (int x = 1; x <= width; x++) {
+            if (x < width)
+                raster->getPixelIndex(left + x, top + y, pixel);
+            if (x < width && pixel == runPixel)
+                continue;
+
+            unsigned int r, g, b, a;
+            raster->getPixel(left + run, top + y, r, g, b, a);
+            screen->fillRect(screenX + run * tileSize, screenY + y * tileSize, (x - run) * tileSize, tileSize, r, g, b);
+            run = x;
+            runPixel = pixel;
+        }
+    }
+    screen->fillRect(screenX + (party.x - left) * tileSize, screenY + (party.y - top) * tileSize,
+                     tileSize, tileSize, 255, 255, 255);
+}
+
+/**
+ * Throws away the raster, e.g. because the tile images it was drawn
+ * from have changed.
+ */
+void Minimap::clear() {
+    delete raster;
+    raster = NULL;
+    map = NULL;
+    cells.clear();
+}
+
+/**
+ * Starts the raster over when the map or its level changed since it
+ * was last drawn.
+ */
+void Minimap::prepare(Map *map, int z) {
+    if (raster && this->map == map && this->z == z)
+        return;
+
+    clear();
+    this->map = map;
+    this->z = z;
+
+    MemOwner owner(MEM_IMAGE_VIEW);
+    raster = Image::create(map->width, map->height, false, Image::SOFTWARE);
+    raster->fillRect(0, 0, map->width, map->height, 0, 0, 0);
+    cells.assign(map->width * map->height, MINIMAP_UNKNOWN);
+}
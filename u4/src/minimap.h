@@ -0,0 +1,44 @@
+/*
+ * $Id$
+ */
+
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <vector>
+
+#include "types.h"
+
+class Image;
+class Map;
+
+/**
+ * An overview of the current map, drawn over a corner of the map area
+ * at one (or two) unscaled pixels per tile.  The whole map is kept in
+ * a raster of the average colors of its tiles, one pixel to a tile.
+ * Each time the map area is drawn only the tiles around the party are
+ * checked against what the raster shows, and redrawn if the map data
+ * changed, so keeping it up to date as the party moves costs next to
+ * nothing; the part of the raster around the party is then scaled up
+ * onto the screen.
+ */
+class Minimap {
+public:
+    static Minimap &getInstance();
+
+    bool isShown() const;
+    bool covers(int x, int y, int width, int height) const;
+    void draw();
+    void clear();
+
+private:
+    Minimap();
+    void prepare(Map *map, int z);
+
+    Map *map;                   /**< the map the raster was drawn for */
+    int z;                      /**< the level of the map */
+    Image *raster;              /**< the whole map, one pixel to a tile */
+    std::vector<TileId> cells;  /**< the tile shown at each map position */
+};
+
+#endif /* MINIMAP_H */
@@ -104,7 +104,7 @@ void moveAvatar(MoveEvent &event) {
       
     Object *destObj = c->location->map->objectAt(newCoords);
     if (destObj && destObj->getType() == Object::CREATURE) {
-        Creature *m = dynamic_cast<Creature*>(destObj);
+        Creature *m = toCreature(destObj);
         //m->specialEffect();
     }
     */
@@ -185,8 +185,8 @@ int moveObject(Map *map, Creature *obj, MapCoords avatar) {
     case MOVEMENT_WANDER:
         /* World map wandering creatures always move, whereas
            town creatures that wander sometimes stay put */
-        if (map->isWorldMap() || xu4_random(2) == 0)
-            dir = dirRandomDir(map->getValidMoves(new_coords, obj->getTile()));
+        if (map->isWorldMap() || xu4_random(2, RANDOM_AI) == 0)
+            dir = dirRandomDir(map->getValidMoves(new_coords, obj->getTile()), RANDOM_AI);
         break;
 
     case MOVEMENT_FOLLOW_AVATAR:
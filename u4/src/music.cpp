@@ -21,6 +21,9 @@
 #include "error.h"
 #include "event.h"
 #include "location.h"
+#include "mapmgr.h"
+#include "portal.h"
+#include "profile.h"
 #include "settings.h"
 #include "u4.h"
 #include "u4file.h"
@@ -90,6 +93,7 @@ Music::~Music() {
 
 
 bool Music::load(Type music) {
+    PROFILE_ZONE(PROF_MUSIC);
     ASSERT(music < MAX, "Attempted to load an invalid piece of music in Music::load()");
 
     /* music already loaded */
@@ -129,7 +133,36 @@ void Music::callback(void *data) {
  * Main music loop
  */
 void Music::play() {
+    PROFILE_ZONE(PROF_MUSIC);
     playMid(c->location->map->music);
+    prefetch(c->location->map);
+}
+
+/**
+ * Has the music of the maps the party can get to from the given map
+ * (through its portals, or back to where they came from) read in the
+ * background, so it is at hand when they get there.
+ */
+void Music::prefetch(const Map *map) {
+    if (!functional || !on)
+        return;
+
+    bool wanted[MAX] = { false };
+    for (PortalList::const_iterator i = map->portals.begin(); i != map->portals.end(); i++) {
+        const Map *dest = mapMgr->peek((*i)->destid);
+        if (dest)
+            wanted[dest->music] = true;
+    }
+    if (c->location->prev)
+        wanted[c->location->prev->map->music] = true;
+
+    for (int music = NONE + 1; music < MAX; music++) {
+        if (wanted[music] && music != current) {
+            string pathname(u4find_music(filenames[music]));
+            if (!pathname.empty())
+                prefetch_sys(pathname);
+        }
+    }
 }
 
 /**
@@ -17,6 +17,8 @@
 #define INN_FADE_OUT_TIME           1000
 #define INN_FADE_IN_TIME            5000
 #define NLOOPS -1
+#define MUSIC_SWITCH_FADE_TIME      500     /**< msecs to fade out one track and fade in the next */
+#define MUSIC_CACHE_SIZE            6       /**< number of opened tracks kept around */
 
 #ifdef IOS
 # if __OBJC__
@@ -30,6 +32,8 @@ struct _Mix_Music;
 typedef _Mix_Music OSMusicMixer;
 #endif
 
+class Map;
+
 
 
 class Music {
@@ -61,6 +65,7 @@ public:
     /** Returns true if the mixer is playing any audio. */
     static bool isPlaying() {return getInstance()->isPlaying_sys();}
     static void callback(void *);    
+    static void update_sys(void *data);
 
     void init() {}
     void play();
@@ -107,10 +112,12 @@ private:
 
 
     bool load_sys(const string &pathname);
+    void prefetch_sys(const string &pathname);
     void playMid(Type music);
     void stopMid();
 
     bool load(Type music);
+    void prefetch(const Map *map);
 
 public:
     static bool functional;
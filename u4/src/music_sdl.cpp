@@ -1,6 +1,11 @@
 #include <SDL.h>
 #include <SDL_mixer.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <map>
+
 #include "music.h"
 #include "sound.h"
 
@@ -12,10 +17,126 @@
 #include "error.h"
 #include "event.h"
 #include "location.h"
+#include "profile.h"
 #include "settings.h"
 #include "u4.h"
 #include "u4file.h"
 
+/**
+ * An opened track, kept around so that going back to it doesn't touch
+ * the disk again.  When there are too many, the least recently used
+ * one is freed.
+ */
+struct CachedTrack {
+    Mix_Music *music;
+    unsigned int used;
+};
+
+static std::map<string, CachedTrack> trackCache;
+static unsigned int trackClock = 0;
+
+static bool switchPending = false;      /**< the playing track is to be faded in once the old one has faded out */
+static Mix_Music *fadingTrack = NULL;   /**< the track being faded out, which mustn't be freed yet */
+static bool updateScheduled = false;
+
+/*
+ * The prefetch thread reads the files queued for it, so they are in
+ * the system's file cache by the time they are opened.  The tracks are
+ * opened on the main thread afterwards, one per timer tick.
+ */
+static SDL_Thread *prefetchThread = NULL;
+static SDL_mutex *prefetchLock = NULL;
+static SDL_cond *prefetchWake = NULL;
+static std::deque<string> prefetchQueue;    /**< files waiting to be read */
+static std::deque<string> prefetchDone;     /**< files read, waiting to be opened */
+static bool prefetchQuit = false;
+
+static int prefetchThreadFunction(void *) {
+    static char buffer[65536];
+
+    SDL_mutexP(prefetchLock);
+    while (!prefetchQuit) {
+        if (prefetchQueue.empty()) {
+            SDL_CondWait(prefetchWake, prefetchLock);
+            continue;
+        }
+        string pathname = prefetchQueue.front();
+        prefetchQueue.pop_front();
+        SDL_mutexV(prefetchLock);
+
+        FILE *file = fopen(pathname.c_str(), "rb");
+        if (file) {
+            while (fread(buffer, 1, sizeof(buffer), file) == sizeof(buffer))
+                ;
+            fclose(file);
+        }
+
+        SDL_mutexP(prefetchLock);
+        prefetchDone.push_back(pathname);
+    }
+    SDL_mutexV(prefetchLock);
+    return 0;
+}
+
+/**
+ * Frees the least recently used tracks while there are too many,
+ * leaving alone the given ones and any that can still be heard.
+ */
+static void evictTracks(Mix_Music *keep, Mix_Music *keepToo) {
+    while (trackCache.size() > MUSIC_CACHE_SIZE) {
+        std::map<string, CachedTrack>::iterator i, oldest = trackCache.end();
+        for (i = trackCache.begin(); i != trackCache.end(); i++) {
+            if (i->second.music == keep || i->second.music == keepToo || i->second.music == fadingTrack)
+                continue;
+            if (oldest == trackCache.end() || i->second.used < oldest->second.used)
+                oldest = i;
+        }
+        if (oldest == trackCache.end())
+            break;
+
+        Mix_FreeMusic(oldest->second.music);
+        trackCache.erase(oldest);
+    }
+}
+
+/**
+ * Drops a file from the prefetch queues, e.g. once it has been opened
+ * some other way, so that it isn't read or opened again.
+ */
+static void unqueuePrefetch(const string &pathname) {
+    if (!prefetchThread)
+        return;
+
+    SDL_mutexP(prefetchLock);
+    prefetchQueue.erase(std::remove(prefetchQueue.begin(), prefetchQueue.end(), pathname), prefetchQueue.end());
+    prefetchDone.erase(std::remove(prefetchDone.begin(), prefetchDone.end(), pathname), prefetchDone.end());
+    SDL_mutexV(prefetchLock);
+}
+
+/**
+ * Opens a track.  This is done on the main thread, as SDL_mixer isn't
+ * safe to call from another, so the time each one takes is logged to
+ * debug/music.txt and counted in the profiler's musicLoad zone.
+ */
+static Mix_Music *openTrack(const string &pathname, Debug *logger) {
+    PROFILE_ZONE(PROF_MUSIC_LOAD);
+    double start = Profiler::now();
+
+    Mix_Music *music = Mix_LoadMUS(pathname.c_str());
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), " opened in %.2f msecs", (Profiler::now() - start) / 1000.0);
+    TRACE_LOCAL(*logger, pathname + msg);
+    return music;
+}
+
+static void scheduleUpdate() {
+    if (!updateScheduled) {
+        eventHandler->getTimer()->add(&Music::update_sys, 1);
+        updateScheduled = true;
+    }
+}
+
 void Music::create_sys() {
 	/*
 	 * initialize sound subsystem
@@ -46,14 +167,41 @@ void Music::create_sys() {
 	TRACE_LOCAL(*logger, "Allocating channels");
 
 	Mix_AllocateChannels(16);
+
+	TRACE_LOCAL(*logger, "Starting prefetch thread");
+
+	prefetchLock = SDL_CreateMutex();
+	prefetchWake = SDL_CreateCond();
+	if (prefetchLock && prefetchWake)
+		prefetchThread = SDL_CreateThread(prefetchThreadFunction, NULL);
 }
 
 void Music::destroy_sys() {
-    if (playing) {
-        TRACE_LOCAL(*logger, "Stopping currently playing music");
-        Mix_FreeMusic(playing);
-        playing = NULL;
+    if (updateScheduled) {
+        eventHandler->getTimer()->remove(&Music::update_sys);
+        updateScheduled = false;
+    }
+
+    if (prefetchThread) {
+        TRACE_LOCAL(*logger, "Stopping prefetch thread");
+        SDL_mutexP(prefetchLock);
+        prefetchQuit = true;
+        SDL_CondSignal(prefetchWake);
+        SDL_mutexV(prefetchLock);
+        SDL_WaitThread(prefetchThread, NULL);
+        prefetchThread = NULL;
     }
+    if (prefetchWake)
+        SDL_DestroyCond(prefetchWake);
+    if (prefetchLock)
+        SDL_DestroyMutex(prefetchLock);
+
+    TRACE_LOCAL(*logger, "Stopping currently playing music");
+    Mix_HaltMusic();
+    for (std::map<string, CachedTrack>::iterator i = trackCache.begin(); i != trackCache.end(); i++)
+        Mix_FreeMusic(i->second.music);
+    trackCache.clear();
+    playing = NULL;
 
     TRACE_LOCAL(*logger, "Closing audio");
     Mix_CloseAudio();
@@ -63,32 +211,126 @@ void Music::destroy_sys() {
 
 }
 
+/**
+ * Makes the given file the playing track, opening it unless it is
+ * still open from before or was prefetched.
+ */
 bool Music::load_sys(const string &pathname) {
+	std::map<string, CachedTrack>::iterator i = trackCache.find(pathname);
+	if (i == trackCache.end()) {
+		unqueuePrefetch(pathname);
 
-	if (playing) {
-		Mix_FreeMusic(playing);
-		playing = NULL;
+		CachedTrack track;
+		track.music = openTrack(pathname, logger);
+		if (!track.music) {
+			errorWarning("unable to load music file %s: %s", pathname.c_str(),
+					Mix_GetError());
+			return false;
+		}
+		i = trackCache.insert(std::make_pair(pathname, track)).first;
 	}
 
-	playing = Mix_LoadMUS(pathname.c_str());
-	if (!playing) {
-		errorWarning("unable to load music file %s: %s", pathname.c_str(),
-				Mix_GetError());
-		return false;
-	}
+	/* the old track may still be faded out */
+	Mix_Music *previous = playing;
+	i->second.used = ++trackClock;
+	playing = i->second.music;
+	evictTracks(playing, previous);
 	return true;
 }
 
 /**
- * Play a midi file
+ * Queues a file for the prefetch thread to read, unless its track is
+ * already open, or the file is already queued.
+ */
+void Music::prefetch_sys(const string &pathname) {
+	if (!prefetchThread)
+		return;
+
+	if (trackCache.find(pathname) != trackCache.end()) {
+		TRACE_LOCAL(*logger, pathname + " already open, not prefetched");
+		return;
+	}
+
+	SDL_mutexP(prefetchLock);
+	if (std::find(prefetchQueue.begin(), prefetchQueue.end(), pathname) == prefetchQueue.end() &&
+		std::find(prefetchDone.begin(), prefetchDone.end(), pathname) == prefetchDone.end()) {
+		prefetchQueue.push_back(pathname);
+		SDL_CondSignal(prefetchWake);
+	}
+	SDL_mutexV(prefetchLock);
+
+	scheduleUpdate();
+}
+
+/**
+ * Runs every timer tick while there is work to do: fades in the new
+ * track once the old one has faded out, and opens one prefetched file
+ * per tick, so that the cost is spread out.
+ */
+void Music::update_sys(void *data) {
+	Music *music = getInstance();
+
+	if (!Mix_PlayingMusic()) {
+		fadingTrack = NULL;
+		if (switchPending) {
+			switchPending = false;
+			if (Mix_FadeInMusic(music->playing, NLOOPS, MUSIC_SWITCH_FADE_TIME) == -1)
+				errorWarning("Mix_FadeInMusic: %s\n", Mix_GetError());
+		}
+	}
+
+	string pathname;
+	bool idle = true;
+	if (prefetchThread) {
+		SDL_mutexP(prefetchLock);
+		if (!prefetchDone.empty()) {
+			pathname = prefetchDone.front();
+			prefetchDone.pop_front();
+		}
+		idle = prefetchQueue.empty() && prefetchDone.empty();
+		SDL_mutexV(prefetchLock);
+	}
+
+	if (!pathname.empty() && trackCache.find(pathname) == trackCache.end()) {
+		CachedTrack track;
+		track.music = openTrack(pathname, music->logger);
+		track.used = trackClock;
+		if (track.music) {
+			trackCache[pathname] = track;
+			evictTracks(music->playing, fadingTrack);
+		}
+	}
+
+	if (idle && !switchPending && !fadingTrack) {
+		eventHandler->getTimer()->remove(&Music::update_sys);
+		updateScheduled = false;
+	}
+}
+
+/**
+ * Play a midi file.  If another track is playing, it is faded out
+ * first, and the new one is faded in by update_sys() after it.
  */
 void Music::playMid(Type music) {
     if (!functional || !on)
         return;
 
+    Mix_Music *previous = playing;
+
     /* loaded a new piece of music */
     if (load(music)) {
-        Mix_PlayMusic(playing, NLOOPS);
+        if (settings.volumeFades && previous != playing && Mix_PlayingMusic()) {
+            if (!switchPending) {
+                fadingTrack = previous;
+                Mix_FadeOutMusic(MUSIC_SWITCH_FADE_TIME);
+            }
+            switchPending = true;
+            scheduleUpdate();
+        }
+        else {
+            switchPending = false;
+            Mix_PlayMusic(playing, NLOOPS);
+        }
         //Mix_SetMusicPosition(0.0);  //Could be useful if music was stored on different 'it/mod' patterns
     }
 }
@@ -99,6 +341,7 @@ void Music::playMid(Type music) {
  */
 void Music::stopMid()
 {
+    switchPending = false;
     Mix_HaltMusic();
 }
 /**
@@ -128,11 +371,13 @@ void Music::setMusicVolume_sys(int volume) {
 }
 
 void Music::fadeIn_sys(int msecs, bool loadFromMap) {
+	switchPending = false;
 	if (Mix_FadeInMusic(playing, NLOOPS, msecs) == -1)
 		errorWarning("Mix_FadeInMusic: %s\n", Mix_GetError());
 }
 
 void Music::fadeOut_sys(int msecs) {
+	switchPending = false;
 	if (Mix_FadeOutMusic(msecs) == -1)
 		errorWarning("Mix_FadeOutMusic: %s\n", Mix_GetError());
 }
\ No newline at end of file
@@ -12,6 +12,31 @@
 
 using namespace std;
 
+void Object::setCoords(Coords c) {
+    prevCoords = coords;
+    coords = c;
+    updateTables();
+}
+
+void Object::setMovementBehavior(ObjectMovementBehavior b) {
+    movement_behavior = b;
+    updateTables();
+}
+
+void Object::setType(Type t) {
+    objType = t;
+    updateTables();
+}
+
+/**
+ * Brings the object's rows in the object tables of its maps up to
+ * date.
+ */
+void Object::updateTables() {
+    for (std::deque<Map *>::iterator i = maps.begin(); i != maps.end(); i++)
+        (*i)->objectTable.update(this);
+}
+
 bool Object::setDirection(Direction d) {
     return tile.setDirection(d);
 }
@@ -27,11 +27,26 @@ public:
         PERSON
     };
 
-    Object(Type type = UNKNOWN) :    
+    /**
+     * The class an object was constructed as, so it can be told apart
+     * without a dynamic_cast.  Unlike Type, which is a gameplay
+     * property, the kind never changes.  The subclasses of Creature
+     * include the KIND_CREATURE bit.
+     */
+    enum Kind {
+        KIND_OBJECT = 0,
+        KIND_CREATURE = 1,
+        KIND_PERSON = 2 | KIND_CREATURE,
+        KIND_PARTY_MEMBER = 4 | KIND_CREATURE
+    };
+
+    Object(Type type = UNKNOWN, Kind k = KIND_OBJECT) :    
       tile(0),
       prevTile(0),      
       movement_behavior(MOVEMENT_FIXED),
       objType(type), 
+      kind(k),
+      tableIndex(0),
       focused(false),
       visible(true),
       animated(true)
@@ -49,14 +64,16 @@ public:
     bool hasFocus() const                   { return focused; }
     bool isVisible() const                  { return visible; }
     bool isAnimated() const                 { return animated; }    
+    Kind getKind() const                    { return kind.value; }
+    bool isCreatureKind() const             { return (kind.value & KIND_CREATURE) != 0; }
 
     void setTile(MapTile t)                 { tile = t; }
     void setTile(Tile *t)                   {tile = t->getId();}
     void setPrevTile(MapTile t)             { prevTile = t; }
-    void setCoords(Coords c)                { prevCoords = coords; coords = c; }
+    void setCoords(Coords c);
     void setPrevCoords(Coords c)            { prevCoords = c; }    
-    void setMovementBehavior(ObjectMovementBehavior b)          { movement_behavior = b; }
-    void setType(Type t)                    { objType = t; }
+    void setMovementBehavior(ObjectMovementBehavior b);
+    void setType(Type t);
     void setFocus(bool f = true)            { focused = f; }
     void setVisible(bool v = true)          { visible = v; }
     void setAnimated(bool a = true)         { animated = a; }
@@ -71,10 +88,28 @@ public:
 
     // Properties
 protected:
+    friend class ObjectTable;
+
+    void updateTables();
+
+    void setKind(Kind k)                    { kind.value = k; }
+
+    /**
+     * Holds the kind, and keeps it out of assignments: Creature and
+     * Person copy prototypes over themselves after construction.
+     */
+    struct KindTag {
+        KindTag(Kind k) : value(k) {}
+        KindTag &operator=(const KindTag &) { return *this; }
+        Kind value;
+    };
+
     MapTile tile, prevTile;
     Coords coords, prevCoords;
     ObjectMovementBehavior movement_behavior;
     Type objType;
+    KindTag kind;
+    unsigned int tableIndex;                /**< slot in the ObjectTable of the map it was last added to */
     std::deque<class Map *> maps;           /**< A list of maps this object is a part of */    
     
     bool focused;
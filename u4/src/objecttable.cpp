@@ -0,0 +1,216 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include <algorithm>
+
+#include "objecttable.h"
+
+#include "creature.h"
+#include "object.h"
+
+ObjectTable::ObjectTable() : head(NO_SLOT), tail(NO_SLOT), count(0), nextSerial(0), frontOrder(0), backOrder(0) {}
+
+/**
+ * Adds a row for the object ahead of all the others.
+ */
+void ObjectTable::pushFront(Object *obj) {
+    unsigned int slot = allocate(obj);
+
+    order[slot] = --frontOrder;
+    prev[slot] = NO_SLOT;
+    next[slot] = head;
+    if (head != NO_SLOT)
+        prev[head] = slot;
+    else
+        tail = slot;
+    head = slot;
+}
+
+/**
+ * Adds a row for the object after all the others.
+ */
+void ObjectTable::pushBack(Object *obj) {
+    unsigned int slot = allocate(obj);
+
+    order[slot] = backOrder++;
+    next[slot] = NO_SLOT;
+    prev[slot] = tail;
+    if (tail != NO_SLOT)
+        next[tail] = slot;
+    else
+        head = slot;
+    tail = slot;
+}
+
+/**
+ * Removes the object's row, and keeps the slot for the next object
+ * added.
+ */
+void ObjectTable::erase(const Object *obj) {
+    int found = getSlot(obj);
+    if (found < 0)
+        return;
+
+    unsigned int slot = found;
+    removeFromCell(coords[slot], objects[slot]);
+
+    if (prev[slot] != NO_SLOT)
+        next[prev[slot]] = next[slot];
+    else
+        head = next[slot];
+    if (next[slot] != NO_SLOT)
+        prev[next[slot]] = prev[slot];
+    else
+        tail = prev[slot];
+
+    objects[slot] = NULL;
+    freeSlots.push_back(slot);
+    count--;
+}
+
+/**
+ * Removes all rows.  The objects may already be gone by now, so they
+ * aren't touched.
+ */
+void ObjectTable::clear() {
+    cells.clear();
+    objects.clear();
+    coords.clear();
+    movement.clear();
+    flags.clear();
+    serials.clear();
+    order.clear();
+    next.clear();
+    prev.clear();
+    freeSlots.clear();
+    head = tail = NO_SLOT;
+    count = 0;
+}
+
+/**
+ * Lists the rows in the order of Map::objects.  The rows stay usable
+ * while objects are added and removed, but have to be checked with
+ * isCurrent() before use.
+ */
+void ObjectTable::getRows(std::vector<Row> &rows) const {
+    rows.clear();
+    for (unsigned int slot = head; slot != NO_SLOT; slot = next[slot])
+        rows.push_back(Row(slot, serials[slot]));
+}
+
+/**
+ * Returns a key that sorts the object in the order of Map::objects.
+ * Objects not in the table sort last.
+ */
+long ObjectTable::getOrder(const Object *obj) const {
+    int slot = getSlot(obj);
+    return slot < 0 ? backOrder : order[slot];
+}
+
+/**
+ * Puts the object in a free slot, or a new one if there is none.
+ */
+unsigned int ObjectTable::allocate(Object *obj) {
+    unsigned int slot;
+
+    if (freeSlots.empty()) {
+        slot = objects.size();
+        objects.push_back(NULL);
+        coords.push_back(Coords());
+        movement.push_back(0);
+        flags.push_back(0);
+        serials.push_back(0);
+        order.push_back(0);
+        next.push_back(NO_SLOT);
+        prev.push_back(NO_SLOT);
+    } else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    objects[slot] = obj;
+    coords[slot] = obj->getCoords();
+    serials[slot] = nextSerial++;
+    obj->tableIndex = slot;
+    count++;
+
+    addToCell(obj->getCoords(), obj);
+    refresh(slot);
+    return slot;
+}
+
+/**
+ * Copies the object's current state into its row.  An object that is
+ * on more than one map (party members move from one combat map to
+ * the next) only knows its row in the table it was numbered in last;
+ * the other tables don't follow it.
+ */
+void ObjectTable::update(const Object *obj) {
+    unsigned int slot = obj->tableIndex;
+    if (slot < objects.size() && objects[slot] == obj)
+        refresh(slot);
+}
+
+void ObjectTable::refresh(unsigned int slot) {
+    Object *obj = objects[slot];
+    unsigned char f = 0;
+
+    if (isCreature(obj)) {
+        Creature *m = toCreature(obj);
+
+        f |= OT_CREATURE;
+        if ((m->getType() == Object::PERSON && m->getMovementBehavior() == MOVEMENT_ATTACK_AVATAR) ||
+            (m->getType() == Object::CREATURE && m->willAttack()))
+            f |= OT_ATTACKS;
+        if (m->hasSpecialBehavior())
+            f |= OT_SPECIAL;
+    }
+
+    if (!(CellKey(coords[slot]) == CellKey(obj->getCoords()))) {
+        removeFromCell(coords[slot], obj);
+        addToCell(obj->getCoords(), obj);
+    }
+
+    coords[slot] = obj->getCoords();
+    movement[slot] = obj->getMovementBehavior();
+    flags[slot] = f;
+}
+
+/**
+ * Returns the object's slot, or -1 if it isn't in the table.  Only an
+ * object that is on more than one map has to be looked for.
+ */
+int ObjectTable::getSlot(const Object *obj) const {
+    if (obj->tableIndex < objects.size() && objects[obj->tableIndex] == obj)
+        return obj->tableIndex;
+
+    std::vector<Object *>::const_iterator i = std::find(objects.begin(), objects.end(), obj);
+    return i == objects.end() ? -1 : i - objects.begin();
+}
+
+/**
+ * Returns the objects in the given cell, or NULL if there are none.
+ */
+const ObjectTable::Cell *ObjectTable::getCell(int cx, int cy, int z) const {
+    std::map<CellKey, Cell>::const_iterator i = cells.find(CellKey(cx, cy, z));
+    return i == cells.end() ? NULL : &i->second;
+}
+
+void ObjectTable::addToCell(const Coords &c, Object *obj) {
+    cells[CellKey(c)].push_back(obj);
+}
+
+void ObjectTable::removeFromCell(const Coords &c, Object *obj) {
+    std::map<CellKey, Cell>::iterator i = cells.find(CellKey(c));
+    if (i == cells.end())
+        return;
+
+    Cell::iterator j = std::find(i->second.begin(), i->second.end(), obj);
+    if (j != i->second.end())
+        i->second.erase(j);
+    if (i->second.empty())
+        cells.erase(i);
+}
@@ -0,0 +1,118 @@
+/*
+ * $Id$
+ */
+
+#ifndef OBJECTTABLE_H
+#define OBJECTTABLE_H
+
+#include <map>
+#include <vector>
+#include "coords.h"
+
+class Object;
+
+/**
+ * Keeps the state that Map::moveObjects looks at every turn -- the
+ * coordinates, movement behavior and a few flags -- for each object on
+ * a map in parallel arrays.  This lets the turn loop pass over objects
+ * that have nothing to do without touching the objects themselves,
+ * which matters on maps with many wandering creatures.
+ *
+ * Each object keeps its row (slot) for as long as it is on the map;
+ * the rows of removed objects are reused, so adding and removing an
+ * object never moves the other rows.  The order of Map::objects, which
+ * is the turn order, is kept separately as a list through the rows,
+ * along with a key that compares the same way.
+ *
+ * The Object API remains the way to change an object: the setters
+ * write through to the object's row, and Map keeps the rows in step
+ * as objects are added and removed.
+ *
+ * The table also buckets the objects into square cells of CELL_SIZE
+ * tiles, which is the spatial index behind Map::objectAt and the
+ * neighbor queries.
+ */
+class ObjectTable {
+public:
+    enum Flags {
+        OT_CREATURE = 0x01,     /**< the object is a creature */
+        OT_ATTACKS  = 0x02,     /**< attacks the avatar when next to it */
+        OT_SPECIAL  = 0x04      /**< has a special action or effect */
+    };
+
+    enum {
+        CELL_SIZE = 8
+    };
+
+    typedef std::vector<Object *> Cell;
+
+    /**
+     * A row as it was when the rows were listed; it is stale once the
+     * object in it is removed, even if the row has been reused since.
+     */
+    struct Row {
+        Row(unsigned int s, unsigned int n) : slot(s), serial(n) {}
+        unsigned int slot, serial;
+    };
+
+    ObjectTable();
+
+    void pushFront(Object *obj);
+    void pushBack(Object *obj);
+    void erase(const Object *obj);
+    void clear();
+    void update(const Object *obj);
+
+    unsigned int size() const                       { return count; }
+    void getRows(std::vector<Row> &rows) const;
+    bool isCurrent(const Row &row) const            { return objects[row.slot] != NULL && serials[row.slot] == row.serial; }
+    Object *getObject(unsigned int slot) const      { return objects[slot]; }
+    const Coords &getCoords(unsigned int slot) const { return coords[slot]; }
+    int getMovementBehavior(unsigned int slot) const { return movement[slot]; }
+    int getFlags(unsigned int slot) const           { return flags[slot]; }
+    long getOrder(const Object *obj) const;
+
+    const Cell *getCell(int cx, int cy, int z) const;
+    static int cellOf(int v)                        { return v >= 0 ? v / CELL_SIZE : -((CELL_SIZE - 1 - v) / CELL_SIZE); }
+
+private:
+    // disallow copying: objects know their slot numbers
+    ObjectTable(const ObjectTable &);
+    ObjectTable &operator=(const ObjectTable &);
+
+    struct CellKey {
+        CellKey(const Coords &c) : x(cellOf(c.x)), y(cellOf(c.y)), z(c.z) {}
+        CellKey(int cx, int cy, int cz) : x(cx), y(cy), z(cz) {}
+        bool operator==(const CellKey &k) const { return x == k.x && y == k.y && z == k.z; }
+        bool operator<(const CellKey &k) const {
+            return z != k.z ? z < k.z : (y != k.y ? y < k.y : x < k.x);
+        }
+        int x, y, z;
+    };
+
+    enum {
+        NO_SLOT = ~0u
+    };
+
+    unsigned int allocate(Object *obj);
+    int getSlot(const Object *obj) const;
+    void refresh(unsigned int slot);
+    void addToCell(const Coords &c, Object *obj);
+    void removeFromCell(const Coords &c, Object *obj);
+
+    std::map<CellKey, Cell> cells;
+    std::vector<Object *> objects;          /**< NULL in free slots */
+    std::vector<Coords> coords;
+    std::vector<unsigned char> movement;
+    std::vector<unsigned char> flags;
+    std::vector<unsigned int> serials;      /**< tells apart the objects a slot has held */
+    std::vector<long> order;                /**< sorts the slots in the order of Map::objects */
+    std::vector<unsigned int> next, prev;   /**< the slots in the order of Map::objects */
+    std::vector<unsigned int> freeSlots;
+    unsigned int head, tail;
+    unsigned int count;
+    unsigned int nextSerial;
+    long frontOrder, backOrder;
+};
+
+#endif /* OBJECTTABLE_H */
@@ -40,18 +40,6 @@ using namespace std;
 
 int chars_needed(const char *s, int columnmax, int linesdesired, int *real_lines);
 
-/**
- * Returns true of the object that 'punknown' points
- * to is a person object
- */ 
-bool isPerson(Object *punknown) {
-    Person *p;
-    if ((p = dynamic_cast<Person*>(punknown)) != NULL)
-        return true;
-    else
-        return false;
-}
-
 /**
  * Splits a piece of response text into screen-sized chunks.
  */
@@ -98,12 +86,14 @@ list<string> replySplit(const string &text) {
 }
 
 Person::Person(MapTile tile) : Creature(tile), start(0, 0) {
+    setKind(KIND_PERSON);
     setType(Object::PERSON);
     dialogue = NULL;
     npcType = NPC_EMPTY;
 }
 
 Person::Person(const Person *p) : Creature(p->tile) {
+    setKind(KIND_PERSON);
     *this = *p;
 }
 
@@ -72,7 +72,19 @@ private:
     PersonNpcType npcType;
 };
 
-bool isPerson(Object *punknown);
+/**
+ * Returns true if the object that 'punknown' points to is a person.
+ */
+inline bool isPerson(const Object *punknown) {
+    return punknown != NULL && punknown->getKind() == Object::KIND_PERSON;
+}
+
+/**
+ * Returns the object as a person, or NULL if it isn't one.
+ */
+inline Person *toPerson(Object *punknown) {
+    return isPerson(punknown) ? static_cast<Person *>(punknown) : NULL;
+}
 
 list<string> replySplit(const string &text);
 int linecount(const string &s, int columnmax);
@@ -25,14 +25,6 @@
 #include "ios_helpers.h"
 #endif
 
-bool isPartyMember(Object *punknown) {
-    PartyMember *pm;
-    if ((pm = dynamic_cast<PartyMember*>(punknown)) != NULL)
-        return true;
-    else 
-        return false;
-}
-
 /**
  * PartyMember class implementation
  */ 
@@ -41,6 +33,7 @@ PartyMember::PartyMember(Party *p, SaveGamePlayerRecord *pr) :
     player(pr),
     party(p)
 {
+    setKind(KIND_PARTY_MEMBER);
     /* FIXME: we need to rename movement behaviors */
     setMovementBehavior(MOVEMENT_ATTACK_AVATAR);
     this->ranged = Weapon::get(pr->weapon)->getRange() ? 1 : 0;
@@ -1257,6 +1250,21 @@ void Party::swapPlayers(int p1, int p2) {
     notifyOfChange(0);
 }
 
+/**
+ * Brings the party back in line with the savegame after it has been
+ * replaced as a whole, e.g. when a snapshot is restored.  The transport
+ * and torch are passed separately, since the savegame only keeps the
+ * bare transport tile and, outside of dungeons, no torch.
+ */
+void Party::restore(MapTile transport, int torchduration) {
+    for (PartyMemberVector::iterator i = members.begin(); i != members.end(); i++)
+        delete *i;
+    syncMembers();
+
+    this->torchduration = torchduration;
+    setTransport(transport);
+}
+
 void Party::syncMembers() {
     members.clear();
     for (int i = 0; i < saveGame->members; i++) {
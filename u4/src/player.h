@@ -223,6 +223,7 @@ public:
     int getActivePlayer() const;
 
     void swapPlayers(int p1, int p2);
+    void restore(MapTile transport, int torchduration);
 
     int size() const;
     PartyMember *member(int index) const;    
@@ -239,6 +240,19 @@ private:
 #endif
 };
 
-bool isPartyMember(Object *punknown);
+/**
+ * Returns true if the object that 'punknown' points to is a party
+ * member.
+ */
+inline bool isPartyMember(const Object *punknown) {
+    return punknown != NULL && punknown->getKind() == Object::KIND_PARTY_MEMBER;
+}
+
+/**
+ * Returns the object as a party member, or NULL if it isn't one.
+ */
+inline PartyMember *toPartyMember(Object *punknown) {
+    return isPartyMember(punknown) ? static_cast<PartyMember *>(punknown) : NULL;
+}
 
 #endif
@@ -0,0 +1,200 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/time.h>
+#include <time.h>
+#endif
+
+#include "profile.h"
+
+#include "filesystem.h"
+#include "screen.h"
+
+static const char *profilerZoneNames[PROF_MAX] = {
+    "screenUpdate",
+    "tilesAt",
+    "LOS",
+    "tileAnim",
+    "moveObjs",
+    "AI",
+    "music",
+    "musicLoad",
+    "script"
+};
+
+Profiler &Profiler::getInstance() {
+    static Profiler *instance = NULL;
+    if (instance == NULL)
+        instance = new Profiler();
+    return *instance;
+}
+
+Profiler::Profiler() : enabled(false), overlay(false), frame(0) {
+    memset(zones, 0, sizeof(zones));
+}
+
+/**
+ * Returns a monotonic timestamp in microseconds.
+ */
+double Profiler::now() {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return 1000000.0 * counter.QuadPart / frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+#endif
+}
+
+/**
+ * Turns timing collection on or off.  The first time the profiler is
+ * enabled, it arranges for its results to be written to
+ * debug/profile.csv when the program exits.
+ */
+void Profiler::setEnabled(bool enable) {
+    static bool registered = false;
+
+    enabled = enable;
+    if (enabled && !registered) {
+        atexit(&Profiler::dump);
+        registered = true;
+    }
+}
+
+/**
+ * Shows or hides the on-screen overlay; showing it also enables the
+ * profiler.
+ */
+void Profiler::setOverlayShown(bool show) {
+    overlay = show;
+    if (overlay)
+        setEnabled(true);
+}
+
+/**
+ * Marks entry into a zone.  Returns true if this is the outermost
+ * entry, i.e. the one that should be timed.
+ */
+bool Profiler::enter(ProfileZone zone) {
+    return zones[zone].depth++ == 0;
+}
+
+/**
+ * Marks exit from a zone, recording the time spent in it.  A negative
+ * time marks the exit of a nested entry, which isn't recorded.
+ */
+void Profiler::leave(ProfileZone zone, double usecs) {
+    Zone &z = zones[zone];
+
+    z.depth--;
+    if (usecs < 0)
+        return;
+
+    z.calls++;
+    z.total += usecs;
+    z.current += usecs;
+    if (usecs > z.max)
+        z.max = usecs;
+
+    int bucket = 0;
+    for (unsigned long u = static_cast<unsigned long>(usecs); u > 1 && bucket < BUCKETS - 1; u >>= 1)
+        bucket++;
+    z.histogram[bucket]++;
+}
+
+/**
+ * Closes off the current frame, rolling each zone's time for the frame
+ * into its history, and draws the overlay if it is shown.
+ */
+void Profiler::endFrame() {
+    if (!enabled)
+        return;
+
+    for (int i = 0; i < PROF_MAX; i++) {
+        zones[i].frames[frame % FRAMES] = zones[i].current;
+        zones[i].current = 0;
+    }
+    frame++;
+
+    if (overlay)
+        drawOverlay();
+}
+
+/**
+ * Returns the average time per frame, in msecs, spent in the zone over
+ * the last FRAMES frames.
+ */
+double Profiler::getFrameAverage(ProfileZone zone) const {
+    unsigned int n = frame < FRAMES ? frame : FRAMES;
+    double total = 0;
+
+    if (n == 0)
+        return 0;
+
+    for (unsigned int i = 0; i < n; i++)
+        total += zones[zone].frames[i];
+    return total / n / 1000.0;
+}
+
+/**
+ * Draws the per-frame average of each zone over the top left of the
+ * map area.
+ */
+void Profiler::drawOverlay() const {
+    for (int i = 0; i < PROF_MAX; i++)
+        screenTextAt(1, 1 + i, "%-12s%6.2fms", profilerZoneNames[i], getFrameAverage(static_cast<ProfileZone>(i)));
+}
+
+/**
+ * Writes a line per zone with its call count, total, mean and maximum
+ * times, and histogram of call durations to the given file.
+ */
+bool Profiler::writeCsv(const string &filename) const {
+    Path path(filename);
+    FileSystem::createDirectory(path);
+
+    FILE *csv = fopen(path.getPath().c_str(), "wt");
+    if (!csv)
+        return false;
+
+    fprintf(csv, "zone,calls,total_ms,mean_us,max_us,frame_avg_ms");
+    for (int b = 0; b < BUCKETS - 1; b++)
+        fprintf(csv, ",lt_%luus", 1UL << (b + 1));
+    fprintf(csv, ",ge_%luus", 1UL << (BUCKETS - 1));
+    fprintf(csv, "\n");
+
+    for (int i = 0; i < PROF_MAX; i++) {
+        const Zone &z = zones[i];
+        fprintf(csv, "%s,%lu,%.3f,%.3f,%.3f,%.3f", profilerZoneNames[i], z.calls, z.total / 1000.0,
+                z.calls ? z.total / z.calls : 0.0, z.max, getFrameAverage(static_cast<ProfileZone>(i)));
+        for (int b = 0; b < BUCKETS; b++)
+            fprintf(csv, ",%lu", z.histogram[b]);
+        fprintf(csv, "\n");
+    }
+
+    fclose(csv);
+    return true;
+}
+
+void Profiler::dump() {
+    getInstance().writeCsv("debug/profile.csv");
+}
@@ -0,0 +1,112 @@
+/*
+ * $Id$
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <string>
+
+using std::string;
+
+/**
+ * The parts of the game whose running time the profiler keeps track
+ * of.  Keep profilerZoneNames in profile.cpp in sync.
+ */
+typedef enum {
+    PROF_SCREEN_UPDATE,
+    PROF_TILES_AT,
+    PROF_LINE_OF_SIGHT,
+    PROF_TILE_ANIM,
+    PROF_MOVE_OBJECTS,
+    PROF_CREATURE_AI,
+    PROF_MUSIC,
+    PROF_MUSIC_LOAD,
+    PROF_SCRIPT,
+    PROF_MAX
+} ProfileZone;
+
+/**
+ * A lightweight profiler for the game's hot paths.  Code is timed by
+ * placing PROFILE_ZONE() at the top of a block; the time spent in each
+ * zone is collected per frame, kept for the last FRAMES frames, and
+ * binned into a histogram of call durations.  When the profiler is
+ * disabled a zone costs a single flag test, and building with
+ * NPROFILE removes the zones altogether.
+ */
+class Profiler {
+public:
+    enum {
+        FRAMES = 64,            /**< number of frames the rolling averages cover */
+        BUCKETS = 16            /**< histogram buckets: [2^n, 2^(n+1)) usecs each */
+    };
+
+    static Profiler &getInstance();
+    static double now();
+
+    bool isEnabled() const { return enabled; }
+    void setEnabled(bool enable);
+    bool isOverlayShown() const { return overlay; }
+    void setOverlayShown(bool show);
+
+    bool enter(ProfileZone zone);
+    void leave(ProfileZone zone, double usecs);
+    void endFrame();
+
+    double getFrameAverage(ProfileZone zone) const;
+    void drawOverlay() const;
+    bool writeCsv(const string &filename) const;
+
+private:
+    Profiler();
+
+    struct Zone {
+        int depth;              /**< nesting depth, so recursion is only timed once */
+        unsigned long calls;
+        double total, max;      /**< in usecs */
+        double current;         /**< time spent in the current frame */
+        double frames[FRAMES];  /**< time spent in each of the last FRAMES frames */
+        unsigned long histogram[BUCKETS];
+    };
+
+    static void dump();
+
+    bool enabled, overlay;
+    unsigned int frame;
+    Zone zones[PROF_MAX];
+};
+
+/**
+ * Times the enclosing scope against a profiler zone.
+ */
+class ProfileScope {
+public:
+    ProfileScope(ProfileZone z) : zone(z), active(false), outermost(false), start(0) {
+        if (Profiler::getInstance().isEnabled()) {
+            active = true;
+            outermost = Profiler::getInstance().enter(zone);
+            if (outermost)
+                start = Profiler::now();
+        }
+    }
+
+    ~ProfileScope() {
+        if (active)
+            Profiler::getInstance().leave(zone, outermost ? Profiler::now() - start : -1);
+    }
+
+private:
+    ProfileZone zone;
+    bool active, outermost;
+    double start;
+};
+
+#define profiler (Profiler::getInstance())
+
+#ifdef NPROFILE
+#define PROFILE_ZONE(zone)
+#else
+#define PROFILE_ZONE(zone) ProfileScope profileScope(zone)
+#endif
+
+#endif /* PROFILE_H */
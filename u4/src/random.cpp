@@ -0,0 +1,88 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include <ctime>
+
+#include "random.h"
+
+static RandomGenerator streams[RANDOM_MAX];
+
+RandomGenerator::RandomGenerator() {
+    seed(0);
+}
+
+/**
+ * Seeds the generator.  The seed is spread over the whole state with
+ * splitmix32, so that similar seeds still give unrelated sequences.
+ */
+void RandomGenerator::seed(uint32_t seed) {
+    for (int i = 0; i < 4; i++) {
+        uint32_t z = (seed += 0x9e3779b9);
+        z = (z ^ (z >> 16)) * 0x85ebca6b;
+        z = (z ^ (z >> 13)) * 0xc2b2ae35;
+        state.s[i] = z ^ (z >> 16);
+    }
+
+    /* an all zero state would only ever produce zeros */
+    if (!state.s[0] && !state.s[1] && !state.s[2] && !state.s[3])
+        state.s[0] = 1;
+}
+
+void RandomGenerator::setState(const State &s) {
+    state = s;
+}
+
+/**
+ * Returns one of the random number streams.  Code that needs many
+ * random numbers in a tight loop can hold on to the generator and call
+ * it directly, which saves a function call per number.
+ */
+RandomGenerator &xu4_random_stream(RandomStream stream) {
+    return streams[stream];
+}
+
+/**
+ * Seed the random number generator.
+ */
+void xu4_srandom() {
+    xu4_srandom((unsigned int)time(NULL));
+}
+
+/**
+ * Seed the random number generator with a fixed seed, so that a game
+ * can be replayed deterministically.  Each stream gets its own seed
+ * derived from the given one.
+ */
+void xu4_srandom(unsigned int seed) {
+    for (int i = 0; i < RANDOM_MAX; i++)
+        streams[i].seed(seed + 0x6a09e667 * i);
+}
+
+/**
+ * Generate a random number between 0 and (upperRange - 1) from the
+ * gameplay stream.
+ */
+int xu4_random(int upperRange) {
+    return streams[RANDOM_GAMEPLAY].below(upperRange);
+}
+
+/**
+ * Generate a random number between 0 and (upperRange - 1) from the
+ * given stream.
+ */
+int xu4_random(int upperRange, RandomStream stream) {
+    return streams[stream].below(upperRange);
+}
+
+void xu4_random_get_state(RandomState *state) {
+    for (int i = 0; i < RANDOM_MAX; i++)
+        state->streams[i] = streams[i].getState();
+}
+
+void xu4_random_set_state(const RandomState &state) {
+    for (int i = 0; i < RANDOM_MAX; i++)
+        streams[i].setState(state.streams[i]);
+}
@@ -0,0 +1,91 @@
+/*
+ * $Id$
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+/**
+ * The independent random number streams.  Each subsystem draws from
+ * its own stream, so that e.g. how many animated tiles happen to be on
+ * screen doesn't change the outcome of the next combat roll.
+ */
+typedef enum {
+    RANDOM_GAMEPLAY,    /**< combat rolls, encounters, loot, spells, etc. */
+    RANDOM_AI,          /**< creature and npc decisions and wandering */
+    RANDOM_COSMETIC,    /**< tile animations and other eye candy */
+    RANDOM_MAX
+} RandomStream;
+
+/**
+ * A small, fast pseudo-random number generator (xoshiro128**).  Unlike
+ * rand(), it is the same on every platform, its entire state can be
+ * saved and restored, and there can be as many independent generators
+ * as needed.
+ */
+class RandomGenerator {
+public:
+    struct State {
+        uint32_t s[4];
+    };
+
+    RandomGenerator();
+
+    void seed(uint32_t seed);
+    const State &getState() const { return state; }
+    void setState(const State &s);
+
+    /**
+     * Returns the next 32 random bits.
+     */
+    uint32_t next() {
+        uint32_t *s = state.s;
+        uint32_t result = rotl(s[1] * 5, 7) * 9;
+        uint32_t t = s[1] << 9;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+
+        return result;
+    }
+
+    /**
+     * Returns a random number between 0 and (upperRange - 1), using the
+     * upper bits of the next value.
+     */
+    int below(int upperRange) {
+        if (upperRange <= 0)
+            return 0;
+        return static_cast<int>((static_cast<uint64_t>(next()) * static_cast<uint32_t>(upperRange)) >> 32);
+    }
+
+private:
+    static uint32_t rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    State state;
+};
+
+/**
+ * The state of all the streams, for saving and restoring.
+ */
+struct RandomState {
+    RandomGenerator::State streams[RANDOM_MAX];
+};
+
+RandomGenerator &xu4_random_stream(RandomStream stream);
+void xu4_srandom(void);
+void xu4_srandom(unsigned int seed);
+int xu4_random(int upperval);
+int xu4_random(int upperval, RandomStream stream);
+void xu4_random_get_state(RandomState *state);
+void xu4_random_set_state(const RandomState &state);
+
+#endif /* RANDOM_H */
@@ -0,0 +1,296 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include "replay.h"
+
+#include "context.h"
+#include "error.h"
+#include "event.h"
+#include "location.h"
+#include "map.h"
+#include "utils.h"
+
+using namespace std;
+
+TimingSamples::TimingSamples(const string &n) : name(n) {}
+
+void TimingSamples::add(double msecs) {
+    samples.push_back(msecs);
+}
+
+unsigned int TimingSamples::count() const {
+    return samples.size();
+}
+
+/**
+ * Returns the sample below which the given percentage (0-100) of the
+ * samples fall.
+ */
+double TimingSamples::percentile(double p) const {
+    if (samples.empty())
+        return 0.0;
+
+    std::vector<double> sorted(samples);
+    std::vector<double>::size_type n = static_cast<std::vector<double>::size_type>((p / 100.0) * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+    return sorted[n];
+}
+
+void TimingSamples::report(FILE *out) const {
+    double total = 0.0;
+    for (std::vector<double>::const_iterator i = samples.begin(); i != samples.end(); i++)
+        total += *i;
+
+    fprintf(out, "%s: %u samples, mean %0.3f, p50 %0.3f, p90 %0.3f, p99 %0.3f, max %0.3f msecs\n",
+            name.c_str(), count(),
+            samples.empty() ? 0.0 : total / samples.size(),
+            percentile(50), percentile(90), percentile(99), percentile(100));
+}
+
+InputScript::InputScript() :
+    frameTimes("frame"),
+    turnTimes("turn"),
+    pos(0),
+    waiting(0),
+    time(0)
+{}
+
+/**
+ * Loads a script from the given file.  Returns false if the file, or
+ * a file it includes, could not be read or has an invalid line.
+ */
+bool InputScript::load(const string &fname) {
+    filename = fname;
+    steps.clear();
+    pos = 0;
+    waiting = 0;
+
+    return loadFile(fname, 0);
+}
+
+bool InputScript::loadFile(const string &fname, int depth) {
+    char buffer[256];
+    int lineno = 0;
+    std::vector<std::pair<unsigned int, int> > repeats;    /* first step and count of each open repeat */
+    bool ok = true;
+
+    if (depth > 8) {
+        errorWarning("%s: includes nested too deeply", fname.c_str());
+        return false;
+    }
+
+    FILE *file = fopen(fname.c_str(), "rt");
+    if (!file) {
+        errorWarning("%s: unable to read input script", fname.c_str());
+        return false;
+    }
+
+    string::size_type slash = fname.find_last_of("/\\");
+    string dir = (slash == string::npos) ? "" : fname.substr(0, slash + 1);
+
+    while (ok && fgets(buffer, sizeof(buffer), file) != NULL) {
+        string line(buffer);
+        lineno++;
+
+        trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        string::size_type sep = line.find_first_of(" \t");
+        string command = line.substr(0, sep);
+        string arg = (sep == string::npos) ? "" : line.substr(line.find_first_not_of(" \t", sep));
+        string where = fname + ":" + xu4_to_string(lineno);
+
+        if (command == "wait") {
+            Step step = { STEP_WAIT, static_cast<int>(strtol(arg.c_str(), NULL, 10)), "" };
+            steps.push_back(step);
+        }
+        else if (command == "key") {
+            Step step = { STEP_KEY, parseKey(arg), "" };
+            if (step.value)
+                steps.push_back(step);
+            else {
+                errorWarning("%s: unknown key '%s'", where.c_str(), arg.c_str());
+                ok = false;
+            }
+        }
+        else if (command == "text") {
+            for (string::const_iterator i = arg.begin(); i != arg.end(); i++) {
+                Step step = { STEP_KEY, static_cast<unsigned char>(*i), "" };
+                steps.push_back(step);
+            }
+        }
+        else if (command == "repeat") {
+            repeats.push_back(std::make_pair(static_cast<unsigned int>(steps.size()), static_cast<int>(strtol(arg.c_str(), NULL, 10))));
+        }
+        else if (command == "end" && !repeats.empty()) {
+            std::vector<Step> body(steps.begin() + repeats.back().first, steps.end());
+            for (int i = 1; i < repeats.back().second; i++)
+                steps.insert(steps.end(), body.begin(), body.end());
+            if (repeats.back().second < 1)
+                steps.resize(repeats.back().first);
+            repeats.pop_back();
+        }
+        else if (command == "include") {
+            ok = loadFile(dir + arg, depth + 1);
+        }
+        else if (command == "expect" && arg.compare(0, 4, "map ") == 0) {
+            Step step = { STEP_EXPECT_MAP, static_cast<int>(strtol(arg.c_str() + 4, NULL, 10)), where };
+            steps.push_back(step);
+        }
+        else if (command == "expect" && arg.compare(0, 8, "context ") == 0) {
+            Step step = { STEP_EXPECT_CONTEXT, parseContext(arg.substr(8)), where };
+            if (step.value)
+                steps.push_back(step);
+            else {
+                errorWarning("%s: unknown context '%s'", where.c_str(), arg.substr(8).c_str());
+                ok = false;
+            }
+        }
+        else {
+            errorWarning("%s: invalid line in input script: %s", where.c_str(), line.c_str());
+            ok = false;
+        }
+    }
+
+    fclose(file);
+
+    if (ok && !repeats.empty()) {
+        errorWarning("%s: repeat without an end", fname.c_str());
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * Returns the key to press this frame, 0 if no key should be pressed,
+ * or -1 once the script has run out.  Expectations reached on the way
+ * are checked; if one fails, the timings so far are reported and the
+ * program exits.
+ */
+int InputScript::nextKey() {
+    if (waiting > 0) {
+        waiting--;
+        return 0;
+    }
+
+    while (pos < steps.size() && steps[pos].type >= STEP_EXPECT_MAP) {
+        if (!check(steps[pos])) {
+            report(stderr);
+            exit(1);
+        }
+        pos++;
+    }
+
+    if (pos >= steps.size())
+        return -1;
+
+    const Step &step = steps[pos++];
+    if (step.type == STEP_WAIT) {
+        waiting = step.value - 1;
+        return 0;
+    }
+    return step.value;
+}
+
+/**
+ * Checks an expectation against where the party is now, reporting it
+ * if it does not hold.
+ */
+bool InputScript::check(const Step &step) const {
+    if (c == NULL || c->location == NULL) {
+        fprintf(stderr, "%s: expectation failed: no game is running\n", step.where.c_str());
+        return false;
+    }
+
+    if (step.type == STEP_EXPECT_MAP && c->location->map->id != static_cast<MapId>(step.value)) {
+        fprintf(stderr, "%s: expectation failed: on map %d, expected map %d\n",
+                step.where.c_str(), c->location->map->id, step.value);
+        return false;
+    }
+
+    if (step.type == STEP_EXPECT_CONTEXT && (c->location->context & step.value) == 0) {
+        fprintf(stderr, "%s: expectation failed: in context 0x%x, expected 0x%x\n",
+                step.where.c_str(), c->location->context, step.value);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Returns the script's clock, in msecs.  The clock only moves when the
+ * event loop advances it, so timers fire on the same frames no matter
+ * how fast the replay actually runs.
+ */
+unsigned int InputScript::getTime() const {
+    return time;
+}
+
+void InputScript::advance(unsigned int msecs) {
+    time += msecs;
+}
+
+/**
+ * Reports the timings gathered while replaying the script.
+ */
+void InputScript::report(FILE *out) const {
+    fprintf(out, "replay of %s finished after %u msecs of game time\n", filename.c_str(), time);
+    frameTimes.report(out);
+    turnTimes.report(out);
+}
+
+int InputScript::parseKey(const string &name) {
+    static const struct {
+        const char *name;
+        int key;
+    } keys[] = {
+        { "up", U4_UP },
+        { "down", U4_DOWN },
+        { "left", U4_LEFT },
+        { "right", U4_RIGHT },
+        { "enter", U4_ENTER },
+        { "esc", U4_ESC },
+        { "space", U4_SPACE },
+        { "backspace", U4_BACKSPACE }
+    };
+
+    if (name.length() == 1)
+        return static_cast<unsigned char>(name[0]);
+    if (name.length() == 2 && name[0] == '^' && isalpha(static_cast<unsigned char>(name[1])))
+        return toupper(static_cast<unsigned char>(name[1])) - 'A' + 1;
+
+    for (unsigned int i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        if (strcasecmp(name.c_str(), keys[i].name) == 0)
+            return keys[i].key;
+    }
+    return 0;
+}
+
+int InputScript::parseContext(const string &name) {
+    static const struct {
+        const char *name;
+        int context;
+    } contexts[] = {
+        { "world", CTX_WORLDMAP },
+        { "city", CTX_CITY },
+        { "dungeon", CTX_DUNGEON },
+        { "combat", CTX_COMBAT },
+        { "altar", CTX_ALTAR_ROOM },
+        { "shrine", CTX_SHRINE }
+    };
+
+    for (unsigned int i = 0; i < sizeof(contexts) / sizeof(contexts[0]); i++) {
+        if (strcasecmp(name.c_str(), contexts[i].name) == 0)
+            return contexts[i].context;
+    }
+    return 0;
+}
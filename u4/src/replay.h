@@ -0,0 +1,101 @@
+/*
+ * $Id$
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using std::string;
+
+/**
+ * Collects timing samples (in msecs) and reports their distribution.
+ */
+class TimingSamples {
+public:
+    TimingSamples(const string &name);
+
+    void add(double msecs);
+    unsigned int count() const;
+    double percentile(double p) const;
+    void report(FILE *out) const;
+
+private:
+    string name;
+    std::vector<double> samples;
+};
+
+/**
+ * An input script feeds key presses to the event handler from a file
+ * instead of the keyboard.  Together with a fixed random seed and the
+ * frame-paced loop running on the script's own clock, this makes a
+ * recorded session replay the same way every time, which is what the
+ * timing samples gathered while replaying are meant for.
+ *
+ * Each line of a script is one of:
+ * <pre>
+ *   # a comment
+ *   wait <frames>      let the given number of frames pass
+ *   key <key>          press a key: a single character, ^ and a letter
+ *                      for a control key, or one of up, down, left,
+ *                      right, enter, esc, space, backspace
+ *   text <string>      press each character of the string in turn
+ *   repeat <count>     run the lines up to the matching "end" the
+ *   ...                given number of times
+ *   end
+ *   include <file>     run the lines of another script, found relative
+ *                      to this one
+ *   expect map <id>    check that the party is on the given map
+ *   expect context <c> check that the party is in the given context:
+ *                      world, city, dungeon, combat, altar or shrine
+ * </pre>
+ * One key is pressed per frame.  Expectations take no time; when one
+ * fails the replay ends with a non-zero exit status, so a script that
+ * has fallen out of step with the game does not go on to report
+ * timings for the wrong scenario.
+ */
+class InputScript {
+public:
+    InputScript();
+
+    bool load(const string &filename);
+
+    int nextKey();
+
+    unsigned int getTime() const;
+    void advance(unsigned int msecs);
+    void report(FILE *out) const;
+
+    TimingSamples frameTimes;   /**< time spent in each frame, excluding idle time */
+    TimingSamples turnTimes;    /**< time spent handling each scripted key press */
+
+private:
+    enum StepType {
+        STEP_KEY,
+        STEP_WAIT,
+        STEP_EXPECT_MAP,
+        STEP_EXPECT_CONTEXT
+    };
+
+    struct Step {
+        StepType type;
+        int value;              /**< the key, frames, map id or context */
+        string where;           /**< file and line, for reporting failed expectations */
+    };
+
+    bool loadFile(const string &fname, int depth);
+    bool check(const Step &step) const;
+    static int parseKey(const string &name);
+    static int parseContext(const string &name);
+
+    string filename;
+    std::vector<Step> steps;
+    unsigned int pos;
+    int waiting;
+    unsigned int time;
+};
+
+#endif /* REPLAY_H */
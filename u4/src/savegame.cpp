@@ -7,160 +7,274 @@
 #include "savegame.h"
 
 #include <cstring>
-#include "io.h"
+#include <vector>
 #include "object.h"
 #include "types.h"
 
 using std::string;
 
-int SaveGame::write(FILE *f) const {
-    int i;
-
-    if (!writeInt(unknown1, f) ||
-        !writeInt(moves, f))
-        return 0;
-
-    for (i = 0; i < 8; i++) {
-        if (!players[i].write(f))
-            return 0;
+#define SAVEGAME_FIELD(type, member, diskSize) \
+    { #member, offsetof(type, member), sizeof(((type *)0)->member), diskSize, 1, NULL }
+#define SAVEGAME_ARRAY(type, member, diskSize) \
+    { #member, offsetof(type, member), sizeof(((type *)0)->member[0]), diskSize, \
+      sizeof(((type *)0)->member) / sizeof(((type *)0)->member[0]), NULL }
+#define SAVEGAME_RECORDS(type, member, layout) \
+    { #member, offsetof(type, member), sizeof(((type *)0)->member[0]), 0, \
+      sizeof(((type *)0)->member) / sizeof(((type *)0)->member[0]), &layout }
+#define SAVEGAME_LAYOUT(fields) { fields, sizeof(fields) / sizeof(fields[0]) }
+
+static const SaveGameField playerRecordFields[] = {
+    SAVEGAME_FIELD(SaveGamePlayerRecord, hp, 2),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, hpMax, 2),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, xp, 2),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, str, 2),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, dex, 2),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, intel, 2),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, mp, 2),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, unknown, 2),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, weapon, 2),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, armor, 2),
+    SAVEGAME_ARRAY(SaveGamePlayerRecord, name, 1),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, sex, 1),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, klass, 1),
+    SAVEGAME_FIELD(SaveGamePlayerRecord, status, 1)
+};
+
+const SaveGameLayout SaveGamePlayerRecord::layout = SAVEGAME_LAYOUT(playerRecordFields);
+
+static const SaveGameField saveGameFields[] = {
+    SAVEGAME_FIELD(SaveGame, unknown1, 4),
+    SAVEGAME_FIELD(SaveGame, moves, 4),
+    SAVEGAME_RECORDS(SaveGame, players, SaveGamePlayerRecord::layout),
+    SAVEGAME_FIELD(SaveGame, food, 4),
+    SAVEGAME_FIELD(SaveGame, gold, 2),
+    SAVEGAME_ARRAY(SaveGame, karma, 2),
+    SAVEGAME_FIELD(SaveGame, torches, 2),
+    SAVEGAME_FIELD(SaveGame, gems, 2),
+    SAVEGAME_FIELD(SaveGame, keys, 2),
+    SAVEGAME_FIELD(SaveGame, sextants, 2),
+    SAVEGAME_ARRAY(SaveGame, armor, 2),
+    SAVEGAME_ARRAY(SaveGame, weapons, 2),
+    SAVEGAME_ARRAY(SaveGame, reagents, 2),
+    SAVEGAME_ARRAY(SaveGame, mixtures, 2),
+    SAVEGAME_FIELD(SaveGame, items, 2),
+    SAVEGAME_FIELD(SaveGame, x, 1),
+    SAVEGAME_FIELD(SaveGame, y, 1),
+    SAVEGAME_FIELD(SaveGame, stones, 1),
+    SAVEGAME_FIELD(SaveGame, runes, 1),
+    SAVEGAME_FIELD(SaveGame, members, 2),
+    SAVEGAME_FIELD(SaveGame, transport, 2),
+    SAVEGAME_FIELD(SaveGame, balloonstate, 2),
+    SAVEGAME_FIELD(SaveGame, trammelphase, 2),
+    SAVEGAME_FIELD(SaveGame, feluccaphase, 2),
+    SAVEGAME_FIELD(SaveGame, shiphull, 2),
+    SAVEGAME_FIELD(SaveGame, lbintro, 2),
+    SAVEGAME_FIELD(SaveGame, lastcamp, 2),
+    SAVEGAME_FIELD(SaveGame, lastreagent, 2),
+    SAVEGAME_FIELD(SaveGame, lastmeditation, 2),
+    SAVEGAME_FIELD(SaveGame, lastvirtue, 2),
+    SAVEGAME_FIELD(SaveGame, dngx, 1),
+    SAVEGAME_FIELD(SaveGame, dngy, 1),
+    SAVEGAME_FIELD(SaveGame, orientation, 2),
+    SAVEGAME_FIELD(SaveGame, dnglevel, 2),
+    SAVEGAME_FIELD(SaveGame, location, 2)
+};
+
+const SaveGameLayout SaveGame::layout = SAVEGAME_LAYOUT(saveGameFields);
+
+static const SaveGameField monsterFields[] = {
+    SAVEGAME_FIELD(SaveGameMonsterRecord, tile, 1),
+    SAVEGAME_FIELD(SaveGameMonsterRecord, x, 1),
+    SAVEGAME_FIELD(SaveGameMonsterRecord, y, 1),
+    SAVEGAME_FIELD(SaveGameMonsterRecord, prevTile, 1),
+    SAVEGAME_FIELD(SaveGameMonsterRecord, prevx, 1),
+    SAVEGAME_FIELD(SaveGameMonsterRecord, prevy, 1),
+    SAVEGAME_FIELD(SaveGameMonsterRecord, unused1, 1),
+    SAVEGAME_FIELD(SaveGameMonsterRecord, unused2, 1)
+};
+
+const SaveGameLayout saveGameMonsterLayout = SAVEGAME_LAYOUT(monsterFields);
+
+/**
+ * Reads an unsigned value of the given size from memory.
+ */
+static unsigned int loadValue(const unsigned char *p, unsigned int size) {
+    unsigned short s;
+    unsigned int i;
+
+    switch (size) {
+    case 1:
+        return *p;
+    case 2:
+        memcpy(&s, p, sizeof(s));
+        return s;
+    default:
+        memcpy(&i, p, sizeof(i));
+        return i;
     }
+}
 
-    if (!writeInt(food, f) ||
-        !writeShort(gold, f))
-        return 0;
+/**
+ * Writes an unsigned value of the given size to memory, truncating it
+ * if necessary.
+ */
+static void storeValue(unsigned char *p, unsigned int size, unsigned int value) {
+    unsigned short s;
 
-    for (i = 0; i < 8; i++) {
-        if (!writeShort(karma[i], f))
-            return 0;
+    switch (size) {
+    case 1:
+        *p = static_cast<unsigned char>(value);
+        break;
+    case 2:
+        s = static_cast<unsigned short>(value);
+        memcpy(p, &s, sizeof(s));
+        break;
+    default:
+        memcpy(p, &value, sizeof(value));
+        break;
     }
+}
 
-    if (!writeShort(torches, f) ||
-        !writeShort(gems, f) ||
-        !writeShort(keys, f) ||
-        !writeShort(sextants, f))
-        return 0;
+/**
+ * Returns the size of the record on disk.
+ */
+unsigned int SaveGameLayout::getSize() const {
+    unsigned int size = 0;
 
-    for (i = 0; i < ARMR_MAX; i++) {
-        if (!writeShort(armor[i], f))
-            return 0;
-    }
+    for (unsigned int f = 0; f < nfields; f++)
+        size += fields[f].count * (fields[f].record ? fields[f].record->getSize() : fields[f].diskSize);
+    return size;
+}
 
-    for (i = 0; i < WEAP_MAX; i++) {
-        if (!writeShort(weapons[i], f))
-            return 0;
-    }
+/**
+ * Returns the value of an element of one of the record's fields.
+ */
+unsigned int SaveGameLayout::getValue(const void *record, unsigned int field, unsigned int index) const {
+    const unsigned char *p = static_cast<const unsigned char *>(record) + fields[field].offset + index * fields[field].memSize;
+    return loadValue(p, fields[field].memSize);
+}
 
-    for (i = 0; i < REAG_MAX; i++) {
-        if (!writeShort(reagents[i], f))
-            return 0;
-    }
+/**
+ * Encodes the record into getSize() bytes at out.
+ */
+void SaveGameLayout::encode(const void *record, unsigned char *out) const {
+    const unsigned char *base = static_cast<const unsigned char *>(record);
 
-    for (i = 0; i < SPELL_MAX; i++) {
-        if (!writeShort(mixtures[i], f))
-            return 0;
-    }
+    for (unsigned int f = 0; f < nfields; f++) {
+        const SaveGameField &field = fields[f];
 
-    if (!writeShort(items, f) ||
-        !writeChar(x, f) ||
-        !writeChar(y, f) ||
-        !writeChar(stones, f) ||
-        !writeChar(runes, f) ||
-        !writeShort(members, f) ||
-        !writeShort(transport, f) ||
-        !writeShort(balloonstate, f) ||
-        !writeShort(trammelphase, f) ||
-        !writeShort(feluccaphase, f) ||
-        !writeShort(shiphull, f) ||
-        !writeShort(lbintro, f) ||
-        !writeShort(lastcamp, f) ||
-        !writeShort(lastreagent, f) ||
-        !writeShort(lastmeditation, f) ||
-        !writeShort(lastvirtue, f) ||
-        !writeChar(dngx, f) ||
-        !writeChar(dngy, f) ||
-        !writeShort(orientation, f) ||
-        !writeShort(dnglevel, f) ||
-        !writeShort(location, f))
-        return 0;
+        for (unsigned int i = 0; i < field.count; i++) {
+            const unsigned char *p = base + field.offset + i * field.memSize;
 
-    return 1;
-}
+            if (field.record) {
+                field.record->encode(p, out);
+                out += field.record->getSize();
+                continue;
+            }
 
-int SaveGame::read(FILE *f) {
-    int i;
+            unsigned int value = loadValue(p, field.memSize);
+            for (unsigned int b = 0; b < field.diskSize; b++)
+                *out++ = static_cast<unsigned char>((value >> (8 * b)) & 0xff);
+        }
+    }
+}
 
-    if (!readInt(&unknown1, f) ||
-        !readInt(&moves, f))
-        return 0;
+/**
+ * Decodes the record from getSize() bytes at in.
+ */
+void SaveGameLayout::decode(void *record, const unsigned char *in) const {
+    unsigned char *base = static_cast<unsigned char *>(record);
+
+    for (unsigned int f = 0; f < nfields; f++) {
+        const SaveGameField &field = fields[f];
+
+        for (unsigned int i = 0; i < field.count; i++) {
+            unsigned char *p = base + field.offset + i * field.memSize;
+
+            if (field.record) {
+                field.record->decode(p, in);
+                in += field.record->getSize();
+                continue;
+            }
+
+            unsigned int value = 0;
+            for (unsigned int b = 0; b < field.diskSize; b++)
+                value |= static_cast<unsigned int>(*in++) << (8 * b);
+            storeValue(p, field.memSize, value);
+        }
+    }
+}
 
-    for (i = 0; i < 8; i++) {
-        if (!players[i].read(f))
-            return 0;
+/**
+ * Encodes an array of n records field by field, i.e. the first field
+ * of every record, then the second field of every record, and so on.
+ * That is how u4dos lays out its monster tables.
+ */
+void SaveGameLayout::encodeColumns(const void *records, unsigned int n, size_t stride, unsigned char *out) const {
+    for (unsigned int f = 0; f < nfields; f++) {
+        SaveGameLayout column = { &fields[f], 1 };
+
+        for (unsigned int i = 0; i < n; i++) {
+            column.encode(static_cast<const unsigned char *>(records) + i * stride, out);
+            out += column.getSize();
+        }
     }
+}
 
-    if (!readInt((unsigned int*)&food, f) ||
-        !readShort((unsigned short*)&gold, f))
-        return 0;
+void SaveGameLayout::decodeColumns(void *records, unsigned int n, size_t stride, const unsigned char *in) const {
+    for (unsigned int f = 0; f < nfields; f++) {
+        SaveGameLayout column = { &fields[f], 1 };
 
-    for (i = 0; i < 8; i++) {
-        if (!readShort((unsigned short*)&(karma[i]), f))
-            return 0;
+        for (unsigned int i = 0; i < n; i++) {
+            column.decode(static_cast<unsigned char *>(records) + i * stride, in);
+            in += column.getSize();
+        }
     }
+}
 
-    if (!readShort((unsigned short*)&torches, f) ||
-        !readShort((unsigned short*)&gems, f) ||
-        !readShort((unsigned short*)&keys, f) ||
-        !readShort((unsigned short*)&sextants, f))
-        return 0;
+/**
+ * Appends the savegame, in the PARTY.SAV format, to the buffer.
+ */
+void SaveGame::write(string &buffer) const {
+    std::vector<unsigned char> data(layout.getSize());
 
-    for (i = 0; i < ARMR_MAX; i++) {
-        if (!readShort((unsigned short*)&(armor[i]), f))
-            return 0;
-    }
+    layout.encode(this, &data[0]);
+    buffer.append(reinterpret_cast<const char *>(&data[0]), data.size());
+}
 
-    for (i = 0; i < WEAP_MAX; i++) {
-        if (!readShort((unsigned short*)&(weapons[i]), f))
-            return 0;
-    }
+int SaveGame::write(FILE *f) const {
+    string buffer;
 
-    for (i = 0; i < REAG_MAX; i++) {
-        if (!readShort((unsigned short*)&(reagents[i]), f))
-            return 0;
-    }
+    write(buffer);
+    return fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+}
 
-    for (i = 0; i < SPELL_MAX; i++) {
-        if (!readShort((unsigned short*)&(mixtures[i]), f))
-            return 0;
+/**
+ * Reads the savegame from PARTY.SAV data.  If there is less data than
+ * expected, the missing fields are read as zero and 0 is returned.
+ */
+int SaveGame::read(const unsigned char *data, unsigned int size) {
+    std::vector<unsigned char> padded;
+    int complete = size >= layout.getSize();
+
+    if (!complete) {
+        padded.assign(data, data + size);
+        padded.resize(layout.getSize(), 0);
+        data = &padded[0];
     }
-
-    if (!readShort(&items, f) ||
-        !readChar(&x, f) ||
-        !readChar(&y, f) ||
-        !readChar(&stones, f) ||
-        !readChar(&runes, f) ||
-        !readShort(&members, f) ||
-        !readShort(&transport, f) ||
-        !readShort(&balloonstate, f) ||
-        !readShort(&trammelphase, f) ||
-        !readShort(&feluccaphase, f) ||
-        !readShort(&shiphull, f) ||
-        !readShort(&lbintro, f) ||
-        !readShort(&lastcamp, f) ||
-        !readShort(&lastreagent, f) ||
-        !readShort(&lastmeditation, f) ||
-        !readShort(&lastvirtue, f) ||
-        !readChar(&dngx, f) ||
-        !readChar(&dngy, f) ||
-        !readShort(&orientation, f) ||
-        !readShort(&dnglevel, f) ||
-        !readShort(&location, f))
-        return 0;
+    layout.decode(this, data);
 
     /* workaround of U4DOS bug to retain savegame compatibility */
     if (location == 0 && dnglevel == 0)
         dnglevel = 0xFFFF;
 
-    return 1;
+    return complete;
+}
+
+int SaveGame::read(FILE *f) {
+    std::vector<unsigned char> data(layout.getSize());
+
+    return read(&data[0], fread(&data[0], 1, data.size(), f));
 }
 
 void SaveGame::init(const SaveGamePlayerRecord *avatarInfo) {
@@ -219,71 +333,18 @@ void SaveGame::init(const SaveGamePlayerRecord *avatarInfo) {
     location = 0;
 }
 
-int SaveGamePlayerRecord::write(FILE *f) const {
-    int i;
+void SaveGamePlayerRecord::write(string &buffer) const {
+    std::vector<unsigned char> data(layout.getSize());
 
-    if (!writeShort(hp, f) ||
-        !writeShort(hpMax, f) ||
-        !writeShort(xp, f) ||
-        !writeShort(str, f) ||
-        !writeShort(dex, f) ||
-        !writeShort(intel, f) ||
-        !writeShort(mp, f) ||
-        !writeShort(unknown, f) ||
-        !writeShort((unsigned short)weapon, f) ||
-        !writeShort((unsigned short)armor, f))
-        return 0;
-
-    for (i = 0; i < 16; i++) {
-        if (!writeChar(name[i], f))
-            return 0;
-    }
-
-    if (!writeChar((unsigned char)sex, f) ||
-        !writeChar((unsigned char)klass, f) ||
-        !writeChar((unsigned char)status, f))
-        return 0;
-
-    return 1;
+    layout.encode(this, &data[0]);
+    buffer.append(reinterpret_cast<const char *>(&data[0]), data.size());
 }
 
-int SaveGamePlayerRecord::read(FILE *f) {
-    int i;
-    unsigned char ch;
-    unsigned short s;
-
-    if (!readShort(&hp, f) ||
-        !readShort(&hpMax, f) ||
-        !readShort(&xp, f) ||
-        !readShort(&str, f) ||
-        !readShort(&dex, f) ||
-        !readShort(&intel, f) ||
-        !readShort(&mp, f) ||
-        !readShort(&unknown, f))
+int SaveGamePlayerRecord::read(const unsigned char *data, unsigned int size) {
+    if (size < layout.getSize())
         return 0;
-        
-    if (!readShort(&s, f))
-        return 0;
-    weapon = (WeaponType) s;
-    if (!readShort(&s, f))
-        return 0;
-    armor = (ArmorType) s;
-
-    for (i = 0; i < 16; i++) {
-        if (!readChar((unsigned char *) &(name[i]), f))
-            return 0;
-    }
-
-    if (!readChar(&ch, f))
-        return 0;
-    sex = (SexType) ch;
-    if (!readChar(&ch, f))
-      return 0;
-    klass = (ClassType) ch;
-    if (!readChar(&ch, f))
-        return 0;
-    status = (StatusType) ch;
 
+    layout.decode(this, data);
     return 1;
 }
 
@@ -309,54 +370,39 @@ void SaveGamePlayerRecord::init() {
     status = STAT_GOOD;
 }
 
+/**
+ * Appends the monster table, in the MONSTERS.SAV format, to the
+ * buffer.  A NULL table is written as all zeros.
+ */
+void saveGameMonstersWrite(SaveGameMonsterRecord *monsterTable, string &buffer) {
+    std::vector<unsigned char> data(saveGameMonsterLayout.getSize() * MONSTERTABLE_SIZE, 0);
+
+    if (monsterTable)
+        saveGameMonsterLayout.encodeColumns(monsterTable, MONSTERTABLE_SIZE, sizeof(SaveGameMonsterRecord), &data[0]);
+    buffer.append(reinterpret_cast<const char *>(&data[0]), data.size());
+}
+
 int saveGameMonstersWrite(SaveGameMonsterRecord *monsterTable, FILE *f) {
-    int i, max;
-    
-    if (monsterTable) {
-        for (i = 0; i < MONSTERTABLE_SIZE; i++)
-            if (!writeChar(monsterTable[i].tile, f)) return 0;
-        for (i = 0; i < MONSTERTABLE_SIZE; i++)
-            if (!writeChar(monsterTable[i].x, f)) return 0;
-        for (i = 0; i < MONSTERTABLE_SIZE; i++)
-            if (!writeChar(monsterTable[i].y, f)) return 0;
-        for (i = 0; i < MONSTERTABLE_SIZE; i++)
-            if (!writeChar(monsterTable[i].prevTile, f)) return 0;
-        for (i = 0; i < MONSTERTABLE_SIZE; i++)
-            if (!writeChar(monsterTable[i].prevx, f)) return 0;
-        for (i = 0; i < MONSTERTABLE_SIZE; i++)
-            if (!writeChar(monsterTable[i].prevy, f)) return 0;
-        for (i = 0; i < MONSTERTABLE_SIZE; i++)
-            if (!writeChar(monsterTable[i].unused1, f)) return 0;
-        for (i = 0; i < MONSTERTABLE_SIZE; i++)
-            if (!writeChar(monsterTable[i].unused2, f)) return 0;
-    }
-    else {
-        max = MONSTERTABLE_SIZE * 8;
-        for (i = 0; i < max; i++)
-            if (!writeChar((unsigned char)0, f)) return 0;
-    }
+    string buffer;
+
+    saveGameMonstersWrite(monsterTable, buffer);
+    return fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+}
+
+/**
+ * Reads the monster table from MONSTERS.SAV data.  Returns 0 if there
+ * is less data than expected, leaving the table untouched.
+ */
+int saveGameMonstersRead(SaveGameMonsterRecord *monsterTable, const unsigned char *data, unsigned int size) {
+    if (size < saveGameMonsterLayout.getSize() * MONSTERTABLE_SIZE)
+        return 0;
+
+    saveGameMonsterLayout.decodeColumns(monsterTable, MONSTERTABLE_SIZE, sizeof(SaveGameMonsterRecord), data);
     return 1;
 }
 
 int saveGameMonstersRead(SaveGameMonsterRecord *monsterTable, FILE *f) {
-    int i;
-        
-    for (i = 0; i < MONSTERTABLE_SIZE; i++)
-        if (!readChar(&monsterTable[i].tile, f)) return 0;
-    for (i = 0; i < MONSTERTABLE_SIZE; i++)
-        if (!readChar(&monsterTable[i].x, f)) return 0;
-    for (i = 0; i < MONSTERTABLE_SIZE; i++)
-        if (!readChar(&monsterTable[i].y, f)) return 0;
-    for (i = 0; i < MONSTERTABLE_SIZE; i++)
-        if (!readChar(&monsterTable[i].prevTile, f)) return 0;
-    for (i = 0; i < MONSTERTABLE_SIZE; i++)
-        if (!readChar(&monsterTable[i].prevx, f)) return 0;
-    for (i = 0; i < MONSTERTABLE_SIZE; i++)
-        if (!readChar(&monsterTable[i].prevy, f)) return 0;
-    for (i = 0; i < MONSTERTABLE_SIZE; i++)
-        if (!readChar(&monsterTable[i].unused1, f)) return 0;
-    for (i = 0; i < MONSTERTABLE_SIZE; i++)
-        if (!readChar(&monsterTable[i].unused1, f)) return 0;
-
-    return 1;    
+    std::vector<unsigned char> data(saveGameMonsterLayout.getSize() * MONSTERTABLE_SIZE);
+
+    return saveGameMonstersRead(monsterTable, &data[0], fread(&data[0], 1, data.size(), f));
 }
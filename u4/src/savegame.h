@@ -5,6 +5,7 @@
 #ifndef SAVEGAME_H
 #define SAVEGAME_H
 
+#include <cstddef>
 #include <cstdio>
 #include <deque>
 #include <string>
@@ -19,6 +20,38 @@
 
 class Object;
 
+struct SaveGameLayout;
+
+/**
+ * Describes how one field of a savegame record is laid out, both in
+ * the struct and on disk.  All values are stored on disk in little
+ * endian order, as u4dos wrote them.
+ */
+struct SaveGameField {
+    const char *name;
+    size_t offset;                  /**< offset of the field in the struct */
+    unsigned int memSize;           /**< size of one element in memory */
+    unsigned int diskSize;          /**< size of one element on disk: 1, 2 or 4 bytes */
+    unsigned int count;             /**< number of elements, for arrays */
+    const SaveGameLayout *record;   /**< for arrays of records, the layout of one */
+};
+
+/**
+ * The layout of a savegame record, as a table of its fields.  The same
+ * table drives encoding, decoding and dumping the record.
+ */
+struct SaveGameLayout {
+    unsigned int getSize() const;
+    unsigned int getValue(const void *record, unsigned int field, unsigned int index = 0) const;
+    void encode(const void *record, unsigned char *out) const;
+    void decode(void *record, const unsigned char *in) const;
+    void encodeColumns(const void *records, unsigned int n, size_t stride, unsigned char *out) const;
+    void decodeColumns(void *records, unsigned int n, size_t stride, const unsigned char *in) const;
+
+    const SaveGameField *fields;
+    unsigned int nfields;
+};
+
 /**
  * The list of all weapons.  These values are used in both the
  * inventory fields and character records of the savegame.
@@ -168,8 +201,10 @@ enum Rune {
  * The Ultima IV savegame player record data.  
  */
 struct SaveGamePlayerRecord {
-    int write(FILE *f) const;
-    int read(FILE *f);
+    static const SaveGameLayout layout;
+
+    void write(std::string &buffer) const;
+    int read(const unsigned char *data, unsigned int size);
     void init();
 
     unsigned short hp;
@@ -204,7 +239,11 @@ typedef struct _SaveGameMonsterRecord {
  * Represents the on-disk contents of PARTY.SAV.
  */
 struct SaveGame {
+    static const SaveGameLayout layout;
+
+    void write(std::string &buffer) const;
     int write(FILE *f) const;
+    int read(const unsigned char *data, unsigned int size);
     int read(FILE *f);
     void init(const SaveGamePlayerRecord *avatarInfo);
 
@@ -246,7 +285,11 @@ struct SaveGame {
     unsigned short location;
 };
 
+void saveGameMonstersWrite(SaveGameMonsterRecord *monsterTable, std::string &buffer);
 int saveGameMonstersWrite(SaveGameMonsterRecord *monsterTable, FILE *f);
+int saveGameMonstersRead(SaveGameMonsterRecord *monsterTable, const unsigned char *data, unsigned int size);
 int saveGameMonstersRead(SaveGameMonsterRecord *monsterTable, FILE *f);
 
+extern const SaveGameLayout saveGameMonsterLayout;
+
 #endif
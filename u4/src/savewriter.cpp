@@ -0,0 +1,148 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "savewriter.h"
+
+#include "filesystem.h"
+
+SaveWriter &SaveWriter::getInstance() {
+    static SaveWriter *instance = NULL;
+    if (instance == NULL)
+        instance = new SaveWriter();
+    return *instance;
+}
+
+/**
+ * Makes sure a background commit gets to finish when the program
+ * exits, whichever way it exits.
+ */
+SaveWriter::SaveWriter() : thread(NULL), result(true) {
+    atexit(&SaveWriter::waitAtExit);
+}
+
+/**
+ * Adds a file to be written by the next commit.
+ */
+void SaveWriter::add(const string &filename, const string &contents) {
+    File file;
+
+    file.filename = filename;
+    file.contents = contents;
+    pending.push_back(file);
+}
+
+/**
+ * Writes out the files added since the last commit, either right away
+ * or on a background thread.  Returns false if writing failed; with a
+ * background commit, that can only be noticed for the previous one.
+ */
+bool SaveWriter::commit(bool background) {
+    bool ok = wait();
+
+    writing.clear();
+    for (std::vector<File>::iterator i = pending.begin(); i != pending.end(); i++) {
+        std::map<string, string>::iterator last = written.find(i->filename);
+        if (last == written.end() || last->second != i->contents || !Path::exists(i->filename))
+            writing.push_back(*i);
+    }
+    pending.clear();
+
+    if (writing.empty())
+        return ok;
+
+    if (background && startThread_sys())
+        return ok;
+
+    result = writeFiles();
+    finish();
+    return ok && result;
+}
+
+/**
+ * Waits for a background commit to finish.  Returns false if it
+ * failed.
+ */
+bool SaveWriter::wait() {
+    if (!thread)
+        return true;
+
+    waitThread_sys();
+    finish();
+    return result;
+}
+
+void SaveWriter::waitAtExit() {
+    SaveWriter &writer = getInstance();
+    if (!writer.wait())
+        fprintf(stderr, "%s\n", writer.getError().c_str());
+}
+
+/**
+ * Writes each file to a temporary, and once they all made it to disk,
+ * renames them over the originals.
+ */
+bool SaveWriter::writeFiles() {
+    std::vector<File>::iterator i;
+
+    for (i = writing.begin(); i != writing.end(); i++) {
+        string tmp = i->filename + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "wb");
+        if (!f) {
+            error = "Error opening " + tmp;
+            return false;
+        }
+
+        bool ok = fwrite(i->contents.data(), 1, i->contents.size(), f) == i->contents.size() &&
+            fflush(f) == 0;
+#if !defined(_WIN32)
+        ok = ok && fsync(fileno(f)) == 0;
+#endif
+        if (fclose(f) != 0 || !ok) {
+            remove(tmp.c_str());
+            error = "Error writing " + tmp;
+            return false;
+        }
+    }
+
+    for (i = writing.begin(); i != writing.end(); i++) {
+        string tmp = i->filename + ".tmp";
+#if defined(_WIN32)
+        bool ok = MoveFileEx(tmp.c_str(), i->filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        bool ok = rename(tmp.c_str(), i->filename.c_str()) == 0;
+#endif
+        if (!ok) {
+            error = "Error replacing " + i->filename;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Records what was written by the last commit, so unchanged files can
+ * be skipped next time.  After a failure nothing is known about the
+ * files, so they will all be written again.
+ */
+void SaveWriter::finish() {
+    for (std::vector<File>::iterator i = writing.begin(); i != writing.end(); i++) {
+        if (result)
+            written[i->filename] = i->contents;
+        else
+            written.erase(i->filename);
+    }
+    writing.clear();
+}
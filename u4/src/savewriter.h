@@ -0,0 +1,63 @@
+/*
+ * $Id$
+ */
+
+#ifndef SAVEWRITER_H
+#define SAVEWRITER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+using std::string;
+
+struct SDL_Thread;
+typedef SDL_Thread OSSaveThread;
+
+/**
+ * Writes out the files that make up a saved game.  The contents of
+ * each file are collected in memory first; committing then writes
+ * every changed file to a temporary file next to it and renames the
+ * temporaries over the originals, so a crash part way through a save
+ * never leaves a half-written file behind.  Files whose contents are
+ * the same as the last time they were written (e.g. dngmap.sav when
+ * nothing in the dungeon moved) are skipped; what was written is kept
+ * to compare against, as the files are small.  The writing can be done
+ * on a background thread, so saving doesn't hold up the game.
+ */
+class SaveWriter {
+public:
+    static SaveWriter &getInstance();
+
+    void add(const string &filename, const string &contents);
+    bool commit(bool background = false);
+    bool wait();
+
+    const string &getError() const { return error; }
+
+private:
+    SaveWriter();
+
+    struct File {
+        string filename;
+        string contents;
+    };
+
+    static void waitAtExit();
+    static int writeThread(void *data);
+    bool startThread_sys();
+    void waitThread_sys();
+    bool writeFiles();
+    void finish();
+
+    std::vector<File> pending;      /**< files added since the last commit */
+    std::vector<File> writing;      /**< files being written by the current commit */
+    std::map<string, string> written;   /**< what was last written to each file */
+    OSSaveThread *thread;
+    bool result;
+    string error;
+};
+
+#define saveWriter (SaveWriter::getInstance())
+
+#endif /* SAVEWRITER_H */
@@ -0,0 +1,36 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include <SDL.h>
+
+#include "savewriter.h"
+
+/**
+ * Runs a background commit.
+ */
+int SaveWriter::writeThread(void *data) {
+    SaveWriter *writer = static_cast<SaveWriter *>(data);
+    writer->result = writer->writeFiles();
+    return 0;
+}
+
+/**
+ * Starts writing the files of a commit on a thread of their own.
+ * Returns false if the thread couldn't be started, in which case they
+ * are written right away instead.
+ */
+bool SaveWriter::startThread_sys() {
+    thread = SDL_CreateThread(&SaveWriter::writeThread, this);
+    return thread != NULL;
+}
+
+/**
+ * Waits for the writing thread to finish.
+ */
+void SaveWriter::waitThread_sys() {
+    SDL_WaitThread(thread, NULL);
+    thread = NULL;
+}
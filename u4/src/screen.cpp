@@ -18,12 +18,16 @@
 #include "dungeonview.h"
 #include "error.h"
 #include "event.h"
+#include "glyphatlas.h"
 #include "intro.h"
 #include "imagemgr.h"
 #include "location.h"
+#include "memstats.h"
+#include "minimap.h"
 #include "names.h"
 #include "object.h"
 #include "player.h"
+#include "profile.h"
 #include "savegame.h"
 #include "settings.h"
 #include "textcolor.h"
@@ -60,7 +64,9 @@ using std::vector;
 
 void screenLoadGraphicsFromConf(void);
 Layout *screenLoadLayoutFromConf(const ConfigElement &conf);
-void screenShowGemTile(Layout *layout, Map *map, MapTile &t, bool focus, int x, int y);
+static bool screenViewportCoords(unsigned int width, unsigned int height, int x, int y, MapCoords &tc);
+static bool screenViewportPosition(const Coords &coords, int &x, int &y);
+static void screenGemReset();
 
 vector<Layout *> layouts;
 vector<TileAnimSet *> tileanimSets;
@@ -73,6 +79,27 @@ TileAnimSet *tileanims = NULL;
 ImageInfo *charsetInfo = NULL;
 ImageInfo *gemTilesInfo = NULL;
 
+#define GEM_BLACK -1
+
+/**
+ * The gem view is kept drawn between peers in an image of its own, so
+ * peering again only has to redraw the cells that changed.  Each cell
+ * remembers the row of the gem tiles (or of the charset, in dungeons)
+ * that was drawn there, and the row for every tile on the map is
+ * worked out once, when the map is first peered at.
+ */
+struct GemView {
+    Map *map;
+    Layout *layout;
+    unsigned int scale;
+    Image *image;
+    vector<int> cells;          /**< row drawn in each cell, or GEM_BLACK */
+    vector<int> rows;           /**< row for each tile id, or GEM_BLACK */
+    vector<bool> framed;        /**< whether the animation frame is added to the row */
+};
+
+static GemView gemView = { NULL, NULL, 0, NULL };
+
 void screenFindLineOfSight(vector<MapTile> viewportTiles[VIEWPORT_W][VIEWPORT_H]);
 void screenFindLineOfSightDOS(vector<MapTile> viewportTiles[VIEWPORT_W][VIEWPORT_H]);
 void screenFindLineOfSightEnhanced(vector<MapTile> viewportTiles[VIEWPORT_W][VIEWPORT_H]);
@@ -106,6 +133,9 @@ void screenInit() {
     
     charsetInfo = NULL;    
     gemTilesInfo = NULL;
+    screenGemReset();
+    Minimap::getInstance().clear();
+    GlyphAtlas::getInstance().clear();
     
     screenLoadGraphicsFromConf();
     
@@ -170,26 +200,44 @@ void screenDelete() {
  * Re-initializes the screen and implements any changes made in settings
  */
 void screenReInit() {        
+    static bool torndown = false;
+    static size_t residentAfterTeardown = 0;
+
     intro->deleteIntro();       /* delete intro stuff */
     Tileset::unloadAllImages(); /* unload tilesets, which will be reloaded lazily as needed */
+    if (DungeonView::instance)
+        DungeonViewer.clearCaches(); /* the dungeon sprites and walls were drawn for the old settings */
+    for (std::vector<TileAnimSet *>::const_iterator i = tileanimSets.begin(); i != tileanimSets.end(); i++)
+        (*i)->clearCaches();    /* so were the pre-rendered tile animations */
     ImageMgr::destroy();
     tileanims = NULL;
     screenDelete(); /* delete screen stuff */
+
+    /*
+     * Apart from the views' scratch images, which are sized for the
+     * old scale until the views are reinited, every image loaded for
+     * the old settings should be gone by now.  If more is left behind
+     * than after the last re-init, something is leaking.
+     */
+    size_t resident = memstats.getImageLive() - memstats.getLive(MEM_IMAGE_VIEW);
+    if (torndown)
+        memstats.checkGrowth("images after screen re-init", residentAfterTeardown, resident);
+    torndown = true;
+    residentAfterTeardown = resident;
+
     screenInit();   /* re-init screen stuff (loading new backgrounds, etc.) */
     intro->init();    /* re-fix the backgrounds loaded and scale images, etc. */
 }
 
 void screenTextAt(int x, int y, const char *fmt, ...) {
     char buffer[BufferSize];
-    unsigned int i;
 
     va_list args;
     va_start(args, fmt);
     vsnprintf(buffer, BufferSize, fmt, args);
     va_end(args);
 
-    for (i = 0; i < strlen(buffer); i++)
-        screenShowChar(buffer[i], x + i, y);
+    screenShowText(buffer, strlen(buffer), x, y);
 }
 
 void screenPrompt() {
@@ -199,6 +247,18 @@ void screenPrompt() {
     }
 }
 
+/**
+ * Draws the characters of a message collected since the last color
+ * change, wrap or cursor movement in one go, and starts a new run.
+ */
+static void screenMessageRun(const char *buffer, int &runStart, unsigned int end, int runCol) {
+    if (runStart < 0)
+        return;
+
+    screenShowText(buffer + runStart, end - runStart, TEXT_AREA_X + runCol, TEXT_AREA_Y + c->line);
+    runStart = -1;
+}
+
 void screenMessage(const char *fmt, ...) {
 #ifdef IOS
     static bool recursed = false;
@@ -209,6 +269,7 @@ void screenMessage(const char *fmt, ...) {
     char buffer[BufferSize];
     unsigned int i;
     int wordlen;    
+    int runStart = -1, runCol = 0;
 
     va_list args;
     va_start(args, fmt);
@@ -235,6 +296,7 @@ void screenMessage(const char *fmt, ...) {
 
         /* backspace */
         if (buffer[i] == '\b') {
+            screenMessageRun(buffer, runStart, i, runCol);
             c->col--;
             if (c->col < 0) {
                 c->col += 16;
@@ -253,12 +315,14 @@ void screenMessage(const char *fmt, ...) {
 			case FG_RED:
 			case FG_YELLOW:
 			case FG_WHITE:
+				screenMessageRun(buffer, runStart, i, runCol);
 				screenTextColor(buffer[i]);
 				continue;
 		}
 
         /* check for word wrap */
         if ((c->col + wordlen > 16) || buffer[i] == '\n' || c->col == 16) {
+            screenMessageRun(buffer, runStart, i, runCol);
             if (buffer[i] == '\n' || buffer[i] == ' ')
                 i++;
             c->line++;
@@ -272,15 +336,20 @@ void screenMessage(const char *fmt, ...) {
 
         /* code for move cursor right */
         if (buffer[i] == 0x12) {
+            screenMessageRun(buffer, runStart, i, runCol);
             c->col++;
             continue;
         }
         /* don't show a space in column 1.  Helps with Hawkwind. */
         if (buffer[i] == ' ' && c->col == 0)
           continue; 
-        screenShowChar(buffer[i], TEXT_AREA_X + c->col, TEXT_AREA_Y + c->line);
+        if (runStart < 0) {
+            runStart = i;
+            runCol = c->col;
+        }
         c->col++;
     }
+    screenMessageRun(buffer, runStart, i, runCol);
 
     screenSetCursorPos(TEXT_AREA_X + c->col, TEXT_AREA_Y + c->line);
     screenShowCursor();
@@ -364,8 +433,26 @@ Layout *screenLoadLayoutFromConf(const ConfigElement &conf) {
 
 
 vector<MapTile> screenViewportTile(unsigned int width, unsigned int height, int x, int y, bool &focus) {
-    MapCoords center = c->location->coords;    
     static MapTile grass = c->location->map->tileset->getByName("grass")->getId();
+    MapCoords tc;
+
+    /* off the edge of the map: pad with grass tiles */
+    if (!screenViewportCoords(width, height, x, y, tc)) {
+        focus = false;
+        vector<MapTile> result;
+        result.push_back(grass);
+        return result;
+    }
+
+    return c->location->tilesAt(tc, focus);
+}
+
+/**
+ * Finds the map coordinates shown at a position in the viewport.
+ * Returns false if the position is off the edge of the map.
+ */
+static bool screenViewportCoords(unsigned int width, unsigned int height, int x, int y, MapCoords &tc) {
+    MapCoords center = c->location->coords;    
     
     if (c->location->map->width <= width &&
         c->location->map->height <= height) {
@@ -373,7 +460,7 @@ vector<MapTile> screenViewportTile(unsigned int width, unsigned int height, int
         center.y = c->location->map->height / 2;
     }
 
-    MapCoords tc = center;
+    tc = center;
 
     tc.x += x - (width / 2);
     tc.y += y - (height / 2);
@@ -381,31 +468,17 @@ vector<MapTile> screenViewportTile(unsigned int width, unsigned int height, int
     /* Wrap the location if we can */    
     tc.wrap(c->location->map);
 
-    /* off the edge of the map: pad with grass tiles */
-    if (MAP_IS_OOB(c->location->map, tc)) {        
-        focus = false;
-        vector<MapTile> result;
-        result.push_back(grass);
-        return result;
-    }
-
-    return c->location->tilesAt(tc, focus);
+    return !MAP_IS_OOB(c->location->map, tc);
 }
 
-bool screenTileUpdate(TileView *view, const Coords &coords, bool redraw)
+/**
+ * Finds where on the map area the tile at the given coordinates goes.
+ * Returns false if it is not on screen or not in sight.
+ */
+static bool screenViewportPosition(const Coords &coords, int &x, int &y)
 {
-	if (c->location->map->flags & FIRST_PERSON)
-		return false;
-
-	// Get the tiles
-	bool focus;
-	MapCoords mc(coords);
-	mc.wrap(c->location->map);
-	vector<MapTile> tiles = c->location->tilesAt(mc, focus);
-
-	// Get the screen coordinates
-	int x = coords.x;
-	int y = coords.y;
+	x = coords.x;
+	y = coords.y;
 
 	if (c->location->map->width > VIEWPORT_W || c->location->map->height > VIEWPORT_H)
 	{
@@ -414,11 +487,32 @@ bool screenTileUpdate(TileView *view, const Coords &coords, bool redraw)
 		y = y - c->location->coords.y + VIEWPORT_H / 2;
 	}
 
+	return x >= 0 && y >= 0 && x < VIEWPORT_W && y < VIEWPORT_H && screenLos[x][y];
+}
+
+bool screenTileUpdate(TileView *view, const Coords &coords, bool redraw)
+{
+	if (c->location->map->flags & FIRST_PERSON)
+		return false;
+
+	// Get the screen coordinates
+	int x, y;
+
 	// Draw if it is on screen
-	if (x >= 0 && y >= 0 && x < VIEWPORT_W && y < VIEWPORT_H && screenLos[x][y])
+	if (screenViewportPosition(coords, x, y))
 	{
+		// Get the tiles
+		bool focus;
+		MapCoords mc(coords);
+		mc.wrap(c->location->map);
+		vector<MapTile> tiles = c->location->tilesAt(mc, focus);
+
 		view->drawTile(tiles, focus, x, y);
 
+		/* don't leave a hole in the minimap */
+		if (Minimap::getInstance().covers(BORDER_WIDTH + x * TILE_WIDTH, BORDER_HEIGHT + y * TILE_HEIGHT, TILE_WIDTH, TILE_HEIGHT))
+			Minimap::getInstance().draw();
+
 		if (redraw)
 		{
 			//screenRedrawMapArea();
@@ -434,6 +528,7 @@ bool screenTileUpdate(TileView *view, const Coords &coords, bool redraw)
  * neither is set, the map area is left untouched.
  */
 void screenUpdate(TileView *view, bool showmap, bool blackout) {
+    PROFILE_ZONE(PROF_SCREEN_UPDATE);
     ASSERT(c != NULL, "context has not yet been initialized");
 
     screenLock();
@@ -473,6 +568,7 @@ void screenUpdate(TileView *view, bool showmap, bool blackout) {
                     view->drawTile(black, false, x, y);
             }
         }
+        Minimap::getInstance().draw();
         screenRedrawMapArea();
     }
 
@@ -495,24 +591,30 @@ void screenDrawImage(const string &name, int x, int y) {
     }
     
     SubImage *subimage = imageMgr->getSubImage(name);
-    if (subimage) 
-        info = imageMgr->get(subimage->srcImageName);
-    
-	if (info) {
-		info->image->alphaOn();
-        
-        if (info) {
-            info->image->drawSubRect(x, y,
-                                     subimage->x * (settings.scale / info->prescale),
-                                     subimage->y * (settings.scale / info->prescale),
-                                     subimage->width * (settings.scale / info->prescale),
-                                     subimage->height * (settings.scale / info->prescale));
-            return;
-        }
-    }
+    if (subimage && screenDrawSubImage(subimage, x, y))
+        return;
+
     errorFatal("ERROR 1006: Unable to load the image \"%s\".\t\n\nIs %s installed?\n\nVisit the XU4 website for additional information.\n\thttp://xu4.sourceforge.net/", name.c_str(), settings.game.c_str());
 }
 
+/**
+ * Draw a subimage on the screen.  Returns false if the image it is
+ * part of could not be loaded.
+ */
+bool screenDrawSubImage(const SubImage *subimage, int x, int y) {
+    ImageInfo *info = imageMgr->get(subimage->srcImageName);
+    if (!info)
+        return false;
+
+    info->image->alphaOn();
+    info->image->drawSubRect(x, y,
+                             subimage->x * (settings.scale / info->prescale),
+                             subimage->y * (settings.scale / info->prescale),
+                             subimage->width * (settings.scale / info->prescale),
+                             subimage->height * (settings.scale / info->prescale));
+    return true;
+}
+
 void screenDrawImageInMapArea(const string &name) {
     ImageInfo *info;
     
@@ -550,7 +652,7 @@ void screenTextColor(int color) {
 		case FG_RED:
 		case FG_YELLOW:
 		case FG_WHITE:
-			charsetInfo->image->setFontColorFG((ColorFG)color);
+			GlyphAtlas::getInstance().setColorFG((ColorFG)color);
 	}
 }
 
@@ -564,9 +666,17 @@ void screenShowChar(int chr, int x, int y) {
             errorFatal("ERROR 1001: Unable to load the \"%s\" data file.\t\n\nIs %s installed?\n\nVisit the XU4 website for additional information.\n\thttp://xu4.sourceforge.net/", BKGD_CHARSET, settings.game.c_str());
     }
     
-    charsetInfo->image->drawSubRect(x * charsetInfo->image->width(), y * (CHAR_HEIGHT * settings.scale),
-                                    0, chr * (CHAR_HEIGHT * settings.scale),
-                                    charsetInfo->image->width(), CHAR_HEIGHT * settings.scale);
+    GlyphAtlas &glyphs = GlyphAtlas::getInstance();
+    glyphs.drawChar(chr, x * glyphs.getGlyphWidth(), y * glyphs.getGlyphHeight());
+}
+
+/**
+ * Draw a run of characters from the charset onto the screen, starting
+ * at the given text position.
+ */
+void screenShowText(const char *text, int length, int x, int y) {
+    GlyphAtlas &glyphs = GlyphAtlas::getInstance();
+    glyphs.drawText(text, length, x * glyphs.getGlyphWidth(), y * glyphs.getGlyphHeight());
 }
 
 /**
@@ -592,7 +702,7 @@ void screenScrollMessageArea() {
                      CHAR_HEIGHT * settings.scale,
                      0, 0, 0);
     
-    screenRedrawScreen();
+    screenRedrawTextArea(TEXT_AREA_X, TEXT_AREA_Y, TEXT_AREA_W, TEXT_AREA_H);
 }
 
 void screenCycle() {
@@ -686,6 +796,7 @@ void screenSetCursorPos(int x, int y) {
  */
 void screenFindLineOfSight(vector <MapTile> viewportTiles[VIEWPORT_W][VIEWPORT_H]) {
     int x, y;
+    PROFILE_ZONE(PROF_LINE_OF_SIGHT);
 
     if (!c)
         return;
@@ -1115,96 +1226,144 @@ void screenEraseTextArea(int x, int y, int width, int height) {
 }
 
 /**
- * Do the tremor spell effect where the screen shakes.
+ * Do the tremor spell effect where the screen shakes.  The shaking is
+ * laid over the screen when it is presented, rather than drawn into
+ * it, so this returns right away.
  */
 void screenShake(int iterations) {
-    int shakeOffset;
-    unsigned short i;
-    Image *screen = imageMgr->get("screen")->image;
-    Image *bottom;
-    
-    // the MSVC8 binary was generating a Access Violation when using
-    // drawSubRectOn() or drawOn() to draw the screen surface on top
-    // of itself.  Occured on settings.scale 2 and 4 only.
-    // Therefore, a temporary Image buffer is used to store the area
-    // that gets clipped at the bottom.
-    
-    if (settings.screenShakes) {
-        // specify the size of the offset, and create a buffer
-        // to store the offset row plus 1
-        shakeOffset = 1;
-        bottom = Image::create(SCALED(320), SCALED(shakeOffset+1), false, Image::HARDWARE);
-        
-        for (i = 0; i < iterations; i++) {
-            // store the bottom row
-            screen->drawOn(bottom, 0, SCALED((shakeOffset+1)-200));
-            
-            // shift the screen down and make the top row black
-            screen->drawSubRectOn(screen, 0, SCALED(shakeOffset), 0, 0, SCALED(320), SCALED(200-(shakeOffset+1)));
-            bottom->drawOn(screen, 0, SCALED(200-(shakeOffset)));
-            screen->fillRect(0, 0, SCALED(320), SCALED(shakeOffset), 0, 0, 0);
-            screenRedrawScreen();
-            EventHandler::sleep(settings.shakeInterval);
-            
-            // shift the screen back up, and replace the bottom row
-            screen->drawOn(screen, 0, 0-SCALED(shakeOffset));
-            bottom->drawOn(screen, 0, SCALED(200-(shakeOffset+1)));
-            screenRedrawScreen();
-            EventHandler::sleep(settings.shakeInterval);
-        }
-        // free the bottom row image
-        delete bottom;
-    }
+    if (settings.screenShakes)
+        screenStartShake(iterations);
 }
 
 /**
- * Draw a tile graphic on the screen.
+ * Flashes a tile (e.g. a hit or a miss) at the given coordinates for
+ * the given number of animation frames, after any flash already going
+ * on.  The flash is laid over the screen each time it is presented, so
+ * this returns right away, and the map can be drawn as usual in the
+ * meantime.
  */
-void screenShowGemTile(Layout *layout, Map *map, MapTile &t, bool focus, int x, int y) {
-    // Make sure we account for tiles that look like other tiles (dungeon tiles, mainly)
-    string looks_like = t.getTileType()->getLooksLike();
-    if (!looks_like.empty())
-        t = map->tileset->getByName(looks_like)->getId();
-    
-    unsigned int tile = map->translateToRawTileIndex(t);
-    
-    if (map->type == Map::DUNGEON) {
-        ASSERT(charsetInfo, "charset not initialized");
-        std::map<string, int>::iterator charIndex = dungeonTileChars.find(t.getTileType()->getName());
-        if (charIndex != dungeonTileChars.end()) {
-            charsetInfo->image->drawSubRect((layout->viewport.x + (x * layout->tileshape.width)) * settings.scale,
-                                            (layout->viewport.y + (y * layout->tileshape.height)) * settings.scale,
-                                            0, 
-                                            charIndex->second * layout->tileshape.height * settings.scale, 
-                                            layout->tileshape.width * settings.scale,
-                                            layout->tileshape.height * settings.scale);
-        }
-    }
-    else {
-        if (gemTilesInfo == NULL) {
-            gemTilesInfo = imageMgr->get(BKGD_GEMTILES);
-            if (!gemTilesInfo)
-                errorFatal("ERROR 1002: Unable to load the \"%s\" data file.\t\n\nIs %s installed?\n\nVisit the XU4 website for additional information.\n\thttp://xu4.sourceforge.net/", BKGD_GEMTILES, settings.game.c_str());
+void screenFlashTile(TileView *view, const Coords &coords, MapTile tile, int numberOfAnimationFrames) {
+    int x, y;
+    if ((c->location->map->flags & FIRST_PERSON) || !screenViewportPosition(coords, x, y))
+        return;
+
+    c->location->map->annotations->add(coords, tile, true);
+    screenTileUpdate(view, coords, false);
+    screenStartOverlay((BORDER_WIDTH + x * TILE_WIDTH) * settings.scale, (BORDER_HEIGHT + y * TILE_HEIGHT) * settings.scale,
+                       TILE_WIDTH * settings.scale, TILE_HEIGHT * settings.scale, numberOfAnimationFrames);
+    c->location->map->annotations->remove(coords, tile);
+    screenTileUpdate(view, coords, false);
+}
+
+/**
+ * Throws away the gem view, so it is drawn from scratch the next time.
+ */
+static void screenGemReset() {
+    delete gemView.image;
+    gemView.image = NULL;
+    gemView.map = NULL;
+    gemView.layout = NULL;
+    gemView.cells.clear();
+    gemView.rows.clear();
+    gemView.framed.clear();
+}
+
+/**
+ * Makes sure the gem view is set up for the given map and layout,
+ * starting it over if either (or the scale) changed since the last
+ * peer.
+ */
+static void screenGemPrepare(Map *map, Layout *layout) {
+    if (gemView.image && gemView.map == map && gemView.layout == layout && gemView.scale == settings.scale)
+        return;
+
+    screenGemReset();
+    gemView.map = map;
+    gemView.layout = layout;
+    gemView.scale = settings.scale;
+
+    int width = layout->viewport.width * layout->tileshape.width * settings.scale;
+    int height = layout->viewport.height * layout->tileshape.height * settings.scale;
+    MemOwner owner(MEM_IMAGE_VIEW);
+    gemView.image = Image::create(width, height, false, Image::HARDWARE);
+    gemView.image->alphaOff();
+    gemView.image->fillRect(0, 0, width, height, 0, 0, 0);
+    gemView.cells.assign(layout->viewport.width * layout->viewport.height, GEM_BLACK);
+
+    /*
+     * Work out the row for every tile, accounting for tiles that look
+     * like other tiles (dungeon tiles, mainly).  Outside of dungeons,
+     * the row is the raw tile index, which counts animation frames.
+     */
+    TileId count = Tile::getNextId();
+    gemView.rows.assign(count, GEM_BLACK);
+    gemView.framed.assign(count, false);
+    for (TileId id = 0; id < count; id++) {
+        const Tile *tile = Tileset::findTileById(id);
+        if (!tile)
+            continue;
+
+        MapTile t(id);
+        bool framed = true;
+        if (!tile->getLooksLike().empty()) {
+            tile = map->tileset->getByName(tile->getLooksLike());
+            if (!tile)
+                continue;
+            t = tile->getId();
+            framed = false;
         }
-        
-        if (tile < 128) {
-            gemTilesInfo->image->drawSubRect((layout->viewport.x + (x * layout->tileshape.width)) * settings.scale,
-                                             (layout->viewport.y + (y * layout->tileshape.height)) * settings.scale,
-                                             0, 
-                                             tile * layout->tileshape.height * settings.scale,
-                                             layout->tileshape.width * settings.scale,
-                                             layout->tileshape.height * settings.scale);
+
+        if (map->type == Map::DUNGEON) {
+            std::map<string, int>::iterator charIndex = dungeonTileChars.find(tile->getName());
+            if (charIndex != dungeonTileChars.end())
+                gemView.rows[id] = charIndex->second;
         } else {
-            Image *screen = imageMgr->get("screen")->image;
-            screen->fillRect((layout->viewport.x + (x * layout->tileshape.width)) * settings.scale,
-                             (layout->viewport.y + (y * layout->tileshape.height)) * settings.scale,
-                             layout->tileshape.width * settings.scale,
-                             layout->tileshape.height * settings.scale,
-                             0, 0, 0);
+            gemView.rows[id] = map->translateToRawTileIndex(t);
+            gemView.framed[id] = framed;
         }
     }
 }
 
+/**
+ * Returns the row to draw for a tile in the gem view.
+ */
+static int screenGemRow(const MapTile &t) {
+    if (t.getId() >= gemView.rows.size())
+        return GEM_BLACK;
+
+    int row = gemView.rows[t.getId()];
+    if (row != GEM_BLACK && gemView.framed[t.getId()])
+        row += t.getFrame();
+
+    /* there are only 128 gem tiles */
+    if (gemView.map->type != Map::DUNGEON && row >= 128)
+        return GEM_BLACK;
+    return row;
+}
+
+/**
+ * Returns the tile shown in the gem view at a position in the
+ * viewport.  Unless peering shows objects, that's just the map data,
+ * or the avatar, which can be had without going through all that is
+ * at the location.
+ */
+static MapTile screenGemTileAt(int width, int height, int x, int y) {
+    MapCoords tc;
+    if (!screenViewportCoords(width, height, x, y, tc)) {
+        bool focus;
+        return screenViewportTile(width, height, x, y, focus).front();
+    }
+
+    if (c->location->viewMode == VIEW_GEM && (!settings.enhancements || !settings.enhancementsOptions.peerShowsObjects)) {
+        if (c->location->coords == tc)
+            return c->party->getTransport();
+        return *c->location->map->getTileFromData(tc);
+    }
+
+    bool focus;
+    return c->location->tilesAt(tc, focus).front();
+}
+
 Layout *screenGetGemLayout(const Map *map) {
     if (map->type == Map::DUNGEON) {
         std::vector<Layout *>::const_iterator i;
@@ -1223,8 +1382,7 @@ Layout *screenGetGemLayout(const Map *map) {
 
 
 void screenGemUpdate() {
-    MapTile tile;
-    int x, y;
+    Map *map = c->location->map;
     Image *screen = imageMgr->get("screen")->image;
     
     screen->fillRect(BORDER_WIDTH * settings.scale, 
@@ -1233,77 +1391,72 @@ void screenGemUpdate() {
                      VIEWPORT_H * TILE_HEIGHT * settings.scale,
                      0, 0, 0);
     
-    Layout *layout = screenGetGemLayout(c->location->map);
-    
+    Layout *layout = screenGetGemLayout(map);
+    screenGemPrepare(map, layout);
+
+    int width = layout->viewport.width;
+    int height = layout->viewport.height;
+    int x, y;
+
+    static vector<int> rows;
+    rows.assign(width * height, GEM_BLACK);
     
     //TODO, move the code responsible for determining 'peer' visibility to a non SDL specific part of the code.
-    if (c->location->map->type == Map::DUNGEON) {
+    if (map->type == Map::DUNGEON) {
     	//DO THE SPECIAL DUNGEON MAP TRAVERSAL
-    	std::vector<std::vector<int> > drawnTiles(layout->viewport.width, vector<int>(layout->viewport.height, 0));
-    	std::list<std::pair<int,int> > coordStack;
+    	static vector<unsigned char> visited;
+    	static vector<int> cellStack;
+    	visited.assign(width * height, 0);
+    	cellStack.clear();
         
     	//Put the avatar's position on the stack
-    	int center_x = layout->viewport.width / 2 - 1;
-    	int center_y = layout->viewport.height / 2 - 1;
+    	int center_x = width / 2 - 1;
+    	int center_y = height / 2 - 1;
     	int avt_x = c->location->coords.x - 1;
     	int avt_y = c->location->coords.y - 1;
+    	TileId avatarTileId = map->tileset->getByName("avatar")->getId();
         
-    	coordStack.push_back(std::pair<int,int>(center_x, center_y));
+    	cellStack.push_back(center_y * width + center_x);
     	bool weAreDrawingTheAvatarTile = true;
         
     	//And draw each tile on the growing stack until it is empty
-    	while (coordStack.size() > 0) {
-    		std::pair<int,int> currentXY = coordStack.back();
-    		coordStack.pop_back();
-            
-    		x = currentXY.first;
-    		y = currentXY.second;
-            
-    		if (	x < 0 || x >= layout->viewport.width ||
-                y < 0 || y >= layout->viewport.height)
-    			continue;	//Skip out of range tiles
+    	while (!cellStack.empty()) {
+    		int cell = cellStack.back();
+    		cellStack.pop_back();
             
-    		if (drawnTiles[x][y])
+    		if (visited[cell])
     			continue;	//Skip already considered tiles
             
-    		drawnTiles[x][y] = 1;
-            
-    		// DRAW THE ACTUAL TILE
-    		bool focus;
-            
-            
-			vector<MapTile> tiles = screenViewportTile(layout->viewport.width,
-                                                       layout->viewport.height, x - center_x + avt_x, y - center_y + avt_y, focus);
-			tile = tiles.front();
-            
-			TileId avatarTileId = c->location->map->tileset->getByName("avatar")->getId();
+    		visited[cell] = 1;
+    		x = cell % width;
+    		y = cell / width;
             
+			MapTile tile = screenGemTileAt(width, height, x - center_x + avt_x, y - center_y + avt_y);
             
 			if (!weAreDrawingTheAvatarTile)
 			{
 				//Hack to avoid showing the avatar tile multiple times in cycling dungeon maps
 				if (tile.getId() == avatarTileId)
-					tile = c->location->map->getTileFromData(c->location->coords)->getId();
+					tile = map->getTileFromData(c->location->coords)->getId();
 			}
             
-			screenShowGemTile(layout, c->location->map, tile, focus, x, y);
+			rows[cell] = screenGemRow(tile);
             
 			if (!tile.getTileType()->isOpaque() || tile.getTileType()->isWalkable() ||  weAreDrawingTheAvatarTile)
 			{
 				//Continue the search so we can see through all walkable objects, non-opaque objects (like creatures)
 				//or the avatar position in those rare circumstances where he is stuck in a wall
                 
-				//by adding all relative adjacency combinations to the stack for drawing
-				coordStack.push_back(std::pair<int,int>(x	+ 1	,	y	- 1	));
-				coordStack.push_back(std::pair<int,int>(x	+ 1	,	y		));
-				coordStack.push_back(std::pair<int,int>(x	+ 1	,	y	+ 1	));
-                
-				coordStack.push_back(std::pair<int,int>(x		,	y	- 1	));
-				coordStack.push_back(std::pair<int,int>(x		,	y	+ 1	));
-                
-				coordStack.push_back(std::pair<int,int>(x	- 1	,	y	- 1	));
-				coordStack.push_back(std::pair<int,int>(x	- 1	,	y	 	));
-				coordStack.push_back(std::pair<int,int>(x	- 1	,	y	+ 1	));
+				//by adding all adjacent tiles within the viewport to the stack for drawing
+				for (int dy = -1; dy <= 1; dy++) {
+					for (int dx = -1; dx <= 1; dx++) {
+						if ((dx || dy) &&
+							x + dx >= 0 && x + dx < width &&
+							y + dy >= 0 && y + dy < height &&
+							!visited[cell + dy * width + dx])
+							cellStack.push_back(cell + dy * width + dx);
+					}
+				}
                 
 				// We only draw the avatar tile once, it is the first tile drawn
 				weAreDrawingTheAvatarTile = false;
@@ -1312,15 +1465,41 @@ void screenGemUpdate() {
         
 	} else {
 		//DO THE REGULAR EVERYTHING-IS-VISIBLE MAP TRAVERSAL
-		for (x = 0; x < layout->viewport.width; x++) {
-			for (y = 0; y < layout->viewport.height; y++) {
-				bool focus;
-				tile = screenViewportTile(layout->viewport.width,
-                                          layout->viewport.height, x, y, focus).front();
-				screenShowGemTile(layout, c->location->map, tile, focus, x, y);
-			}
+		for (y = 0; y < height; y++) {
+			for (x = 0; x < width; x++)
+				rows[y * width + x] = screenGemRow(screenGemTileAt(width, height, x, y));
 		}
 	}
+
+    /* redraw the cells that changed since the last peer */
+    ImageInfo *info;
+    if (map->type == Map::DUNGEON) {
+        ASSERT(charsetInfo, "charset not initialized");
+        info = charsetInfo;
+    } else {
+        if (gemTilesInfo == NULL) {
+            gemTilesInfo = imageMgr->get(BKGD_GEMTILES);
+            if (!gemTilesInfo)
+                errorFatal("ERROR 1002: Unable to load the \"%s\" data file.\t\n\nIs %s installed?\n\nVisit the XU4 website for additional information.\n\thttp://xu4.sourceforge.net/", BKGD_GEMTILES, settings.game.c_str());
+        }
+        info = gemTilesInfo;
+    }
+
+    int tileWidth = layout->tileshape.width * settings.scale;
+    int tileHeight = layout->tileshape.height * settings.scale;
+    for (int cell = 0; cell < width * height; cell++) {
+        if (rows[cell] == gemView.cells[cell])
+            continue;
+
+        x = (cell % width) * tileWidth;
+        y = (cell / width) * tileHeight;
+        gemView.image->fillRect(x, y, tileWidth, tileHeight, 0, 0, 0);
+        if (rows[cell] != GEM_BLACK)
+            info->image->drawSubRectOn(gemView.image, x, y, 0, rows[cell] * tileHeight, tileWidth, tileHeight);
+        gemView.cells[cell] = rows[cell];
+    }
+
+    gemView.image->draw(layout->viewport.x * settings.scale, layout->viewport.y * settings.scale);
     
     screenRedrawMapArea();
     
@@ -1334,4 +1513,8 @@ void screenGemUpdate() {
 void inline screenLock(){};
 void inline screenUnlock(){};
 void inline screenWait(int numberOfAnimationFrames){};
+void inline screenPresent(){};
+void screenStartShake(int iterations){};
+void screenStartOverlay(int x, int y, int width, int height, int numberOfAnimationFrames){};
+void screenClearEffects(){};
 #endif
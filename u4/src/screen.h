@@ -33,6 +33,7 @@
 
 class Image;
 class Map;
+struct SubImage;
 class Tile;
 class TileView;
 class Coords;
@@ -95,6 +96,7 @@ const std::vector<std::string> &screenGetFilterNames();
 const std::vector<std::string> &screenGetLineOfSightStyles();
 
 void screenDrawImage(const std::string &name, int x = 0, int y = 0);
+bool screenDrawSubImage(const SubImage *subimage, int x, int y);
 void screenDrawImageInMapArea(const std::string &bkgd);
 
 void screenCycle(void);
@@ -106,10 +108,16 @@ void screenMessage(const char *fmt, ...) PRINTF_LIKE(1, 2);
 void screenPrompt(void);
 void screenRedrawMapArea(void);
 void screenRedrawScreen(void);
+void screenPresent(void);
 void screenRedrawTextArea(int x, int y, int width, int height);
 void screenScrollMessageArea(void);
 void screenShake(int iterations);
+void screenStartShake(int iterations);
+void screenStartOverlay(int x, int y, int width, int height, int numberOfAnimationFrames);
+void screenClearEffects(void);
+void screenFlashTile(TileView *view, const Coords &coords, MapTile tile, int numberOfAnimationFrames);
 void screenShowChar(int chr, int x, int y);
+void screenShowText(const char *text, int length, int x, int y);
 void screenShowCharMasked(int chr, int x, int y, unsigned char mask);
 void screenTextAt(int x, int y, const char *fmt, ...) PRINTF_LIKE(3, 4);
 void screenTextColor(int color);
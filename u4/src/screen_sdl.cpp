@@ -42,6 +42,12 @@ using std::vector;
 SDL_Cursor *cursors[5];
 Scaler filterScaler;
 
+/**
+ * Everything is drawn on this buffer (it is the "screen" image), and
+ * copied from it to the display surface when the screen is presented.
+ */
+SDL_Surface *screenBuffer = NULL;
+
 SDL_Cursor *screenInitCursor(const char * const xpm[]);
 
 extern bool verbose;
@@ -66,6 +72,14 @@ void screenInit_sys() {
     if (!SDL_SetVideoMode(320 * settings.scale, 200 * settings.scale, 0, SDL_HWSURFACE | SDL_ANYFORMAT | (settings.fullscreen ? SDL_FULLSCREEN : 0)))
         errorFatal("unable to set video: %s", SDL_GetError());
 
+    SDL_PixelFormat *format = SDL_GetVideoSurface()->format;
+    screenBuffer = SDL_CreateRGBSurface(SDL_SWSURFACE, 320 * settings.scale, 200 * settings.scale, format->BitsPerPixel,
+                                        format->Rmask, format->Gmask, format->Bmask, format->Amask);
+    if (!screenBuffer)
+        errorFatal("unable to create the screen buffer: %s", SDL_GetError());
+    if (format->palette)
+        SDL_SetColors(screenBuffer, format->palette->colors, 0, format->palette->ncolors);
+
     if (verbose) {
         char driver[32];
         printf("screen initialized [screenInit()], using %s video driver\n", SDL_VideoDriverName(driver, sizeof(driver)));
@@ -92,6 +106,9 @@ void screenInit_sys() {
 
 void screenDelete_sys() {
 	screenRefreshThreadEnd();
+    screenClearEffects();
+    SDL_FreeSurface(screenBuffer);
+    screenBuffer = NULL;
     SDL_FreeCursor(cursors[1]);
     SDL_FreeCursor(cursors[2]);
     SDL_FreeCursor(cursors[3]);
@@ -207,48 +224,267 @@ int screenLoadImageCga(Image **image, int width, int height, U4FILE *file, Compr
 
 SDL_mutex *screenLockMutex = NULL;
 int frameDuration = 0;
+bool screenDirty = false;       /**< whether the buffer was drawn on since it was last presented */
 
 void screenLock() {
-	SDL_mutexP(screenLockMutex);
+	if (screenLockMutex)
+		SDL_mutexP(screenLockMutex);
 }
 
 void screenUnlock() {
-	SDL_mutexV(screenLockMutex);
+	if (screenLockMutex)
+		SDL_mutexV(screenLockMutex);
+}
+
+/**
+ * Effects such as screen shakes and tile flashes aren't drawn into the
+ * screen buffer; they are laid over the display surface as the buffer
+ * is copied there.  Nothing has to be redrawn when an effect ends, and
+ * the game can draw the screen as usual while they go on.  Effects are
+ * timed in SDL ticks and nothing waits for them: whichever thread
+ * presents the screen works out from the time what to show.
+ */
+struct ScreenOverlay {
+    Uint32 start, end;      /**< when the overlay shows, in SDL ticks */
+    int x, y;               /**< where the overlay goes, in screen pixels */
+    Image *image;
+};
+
+static vector<ScreenOverlay> screenOverlays;
+static Uint32 screenOverlaysEnd = 0;        /**< when the last overlay ends */
+static Uint32 screenShakeStart = 0;         /**< when the current shake began */
+static Uint32 screenShakeEnd = 0;           /**< when it ends, or 0 for no shake */
+static bool screenEffectsShown = false;     /**< whether the last present showed effects */
+
+/**
+ * Returns true if time a is before time b, allowing for the tick count
+ * wrapping around.
+ */
+static bool ticksBefore(Uint32 a, Uint32 b) {
+    return static_cast<Sint32>(a - b) < 0;
+}
+
+/**
+ * Shakes the screen down and back up again the given number of times,
+ * holding each position for shakeInterval, and returns right away.  A
+ * shake started while another is going on carries on after it.
+ */
+void screenStartShake(int iterations) {
+    Uint32 now = SDL_GetTicks();
+
+    screenLock();
+    if (!screenShakeEnd || !ticksBefore(now, screenShakeEnd)) {
+        screenShakeStart = now;
+        screenShakeEnd = now;
+    }
+    screenShakeEnd += iterations * 2 * settings.shakeInterval;
+    if (!screenShakeEnd)
+        screenShakeEnd = 1;     /* 0 is no shake, should the ticks wrap to it */
+    screenUnlock();
+
+    screenRedrawScreen();
+}
+
+/**
+ * Shows what is on the screen in the given area (in screen pixels)
+ * for the given number of animation frames, even if the screen is
+ * drawn over in the meantime, and returns right away.  An overlay
+ * started while another is showing is shown after it, so a missile's
+ * flashes still go along its path one tile at a time.
+ */
+void screenStartOverlay(int x, int y, int width, int height, int numberOfAnimationFrames) {
+    Uint32 now = SDL_GetTicks();
+    ScreenOverlay overlay;
+
+    overlay.x = x;
+    overlay.y = y;
+
+    MemOwner owner(MEM_IMAGE_VIEW);
+    overlay.image = Image::create(width, height, false, Image::HARDWARE);
+    overlay.image->alphaOff();
+
+    SDL_Rect src;
+    src.x = x;
+    src.y = y;
+    src.w = width;
+    src.h = height;
+
+    screenLock();
+    overlay.start = screenOverlays.empty() || ticksBefore(screenOverlaysEnd, now) ? now : screenOverlaysEnd;
+    overlay.end = overlay.start + numberOfAnimationFrames * frameDuration;
+    screenOverlaysEnd = overlay.end;
+    SDL_BlitSurface(screenBuffer, &src, overlay.image->getSurface(), NULL);
+    screenOverlays.push_back(overlay);
+    screenUnlock();
+
+    screenRedrawScreen();
+}
+
+/**
+ * Drops all the effects, e.g. before the screen is torn down.
+ */
+void screenClearEffects() {
+    screenLock();
+    for (vector<ScreenOverlay>::iterator i = screenOverlays.begin(); i != screenOverlays.end(); i++)
+        delete i->image;
+    screenOverlays.clear();
+    screenShakeEnd = 0;
+    screenEffectsShown = false;
+    screenUnlock();
+}
+
+/**
+ * Returns true if there are effects going on or waiting to start, or
+ * the last present showed some, so the screen has to be presented
+ * even if nothing was drawn.
+ */
+static bool screenEffectsPending() {
+    return screenShakeEnd || !screenOverlays.empty() || screenEffectsShown;
+}
+
+/**
+ * Copies the given area of the screen buffer to the display and shows
+ * it, with the effects due at this time laid over it.  While there are
+ * effects, or the last ones have just ended, all of the screen is
+ * shown.  Called with the screen locked.
+ */
+static void screenUpdateRect(int x, int y, int width, int height) {
+    SDL_Surface *video = SDL_GetVideoSurface();
+    Uint32 now = SDL_GetTicks();
+
+    vector<ScreenOverlay>::iterator i = screenOverlays.begin();
+    while (i != screenOverlays.end()) {
+        if (!ticksBefore(now, i->end)) {
+            delete i->image;
+            i = screenOverlays.erase(i);
+        } else
+            i++;
+    }
+    if (screenShakeEnd && !ticksBefore(now, screenShakeEnd))
+        screenShakeEnd = 0;
+
+    /* shaken down for the first shakeInterval, up for the next, and so on */
+    bool shakenDown = screenShakeEnd && settings.shakeInterval > 0 &&
+        ((now - screenShakeStart) / settings.shakeInterval) % 2 == 0;
+
+    bool effects = screenShakeEnd || !screenOverlays.empty();
+    if (effects || screenEffectsShown || width == 0 || height == 0) {
+        x = y = 0;
+        width = video->w;
+        height = video->h;
+    }
+
+    /* shaken down, the screen is moved down with a black row on top */
+    int offset = shakenDown ? settings.scale : 0;
+    SDL_Rect src, dest;
+    src.x = x;
+    src.y = y;
+    src.w = width;
+    src.h = height - offset;
+    dest.x = x;
+    dest.y = y + offset;
+    SDL_BlitSurface(screenBuffer, &src, video, &dest);
+    if (offset) {
+        dest.x = dest.y = 0;
+        dest.w = video->w;
+        dest.h = offset;
+        SDL_FillRect(video, &dest, SDL_MapRGB(video->format, 0, 0, 0));
+    }
+
+    for (i = screenOverlays.begin(); i != screenOverlays.end(); i++) {
+        if (ticksBefore(now, i->start))
+            continue;
+        dest.x = i->x;
+        dest.y = i->y + offset;
+        SDL_BlitSurface(i->image->getSurface(), NULL, video, &dest);
+    }
+
+    SDL_UpdateRect(video, x, y, width, height);
+    screenEffectsShown = effects;
 }
 
+/**
+ * When the frame-paced loop is in use, redraw requests are only
+ * recorded here and the screen is flipped once per frame by
+ * screenPresent().
+ */
 void screenRedrawScreen() {
+    if (settings.framePaced) {
+        screenDirty = true;
+        return;
+    }
+
 	screenLock();
-    SDL_UpdateRect(SDL_GetVideoSurface(), 0, 0, 0, 0);
+    screenDirty = false;
+    screenUpdateRect(0, 0, 0, 0);
     screenUnlock();
 }
 
 void screenRedrawTextArea(int x, int y, int width, int height) {
+    if (settings.framePaced) {
+        screenDirty = true;
+        return;
+    }
+
 	screenLock();
-	SDL_UpdateRect(SDL_GetVideoSurface(), x * CHAR_WIDTH * settings.scale, y * CHAR_HEIGHT * settings.scale, width * CHAR_WIDTH * settings.scale, height * CHAR_HEIGHT * settings.scale);
+	screenUpdateRect(x * CHAR_WIDTH * settings.scale, y * CHAR_HEIGHT * settings.scale, width * CHAR_WIDTH * settings.scale, height * CHAR_HEIGHT * settings.scale);
 	screenUnlock();
 }
 
+/**
+ * Flips the screen if anything was drawn on it since the last present,
+ * or effects are going on or have just ended.  Only does anything when
+ * the frame-paced loop is in use.
+ */
+void screenPresent() {
+    if (!settings.framePaced || (!screenDirty && !screenEffectsPending()))
+        return;
+
+    screenDirty = false;
+    screenUpdateRect(0, 0, 0, 0);
+}
+
 void screenWait(int numberOfAnimationFrames) {
+	screenPresent();
 	SDL_Delay(numberOfAnimationFrames * frameDuration);
 }
 
 bool continueScreenRefresh = true;
 SDL_Thread *screenRefreshThread = NULL;
 
+/**
+ * Presents the screen from the refresh thread, if anything was drawn on
+ * it since the last present or effects are going on.  The flag is
+ * cleared before the copy, so a draw made during it is presented next
+ * time round.
+ */
+static void screenRefresh() {
+    screenLock();
+    if (screenDirty || screenEffectsPending()) {
+        screenDirty = false;
+        screenUpdateRect(0, 0, 0, 0);
+    }
+    screenUnlock();
+}
+
 int screenRefreshThreadFunction(void *unused) {
 
 	while (continueScreenRefresh) {
 		SDL_Delay(frameDuration);
-		screenRedrawScreen();
+		screenRefresh();
 	}
 	return 0;
 }
 
 void screenRefreshThreadInit() {
-	screenLockMutex = SDL_CreateMutex();;
-
 	frameDuration = 1000 / settings.screenAnimationFramesPerSecond;
 
+	/* the frame-paced loop presents the screen itself */
+	if (settings.framePaced)
+		return;
+
+	screenLockMutex = SDL_CreateMutex();;
+
 	continueScreenRefresh = true;
 	if (screenRefreshThread) {
 		errorWarning("Screen refresh thread already exists.");
@@ -263,6 +499,9 @@ void screenRefreshThreadInit() {
 }
 
 void screenRefreshThreadEnd() {
+	if (!screenRefreshThread)
+		return;
+
 	continueScreenRefresh = false;
 	SDL_WaitThread(screenRefreshThread, NULL);
 	screenRefreshThread = NULL;
@@ -191,8 +191,14 @@ bool Settings::read() {
     lineOfSight           = DEFAULT_LINEOFSIGHT;
     screenShakes          = DEFAULT_SCREEN_SHAKES;
     gamma                 = DEFAULT_GAMMA;
+    minimap               = DEFAULT_MINIMAP;
+    minimapX              = DEFAULT_MINIMAP_X;
+    minimapY              = DEFAULT_MINIMAP_Y;
+    minimapSize           = DEFAULT_MINIMAP_SIZE;
+    minimapZoom           = DEFAULT_MINIMAP_ZOOM;
     musicVol              = DEFAULT_MUSIC_VOLUME;
     soundVol              = DEFAULT_SOUND_VOLUME;
+    pcSpeakerSounds       = DEFAULT_PC_SPEAKER_SOUNDS;
     volumeFades           = DEFAULT_VOLUME_FADES;
     shortcutCommands      = DEFAULT_SHORTCUT_COMMANDS;
     keydelay              = DEFAULT_KEY_DELAY;
@@ -202,6 +208,8 @@ bool Settings::read() {
     enhancements          = DEFAULT_ENHANCEMENTS;    
     gameCyclesPerSecond   = DEFAULT_CYCLES_PER_SECOND;
     screenAnimationFramesPerSecond = DEFAULT_ANIMATION_FRAMES_PER_SECOND;
+    framePaced            = DEFAULT_FRAME_PACED;
+    profiling             = DEFAULT_PROFILING;
     debug                 = DEFAULT_DEBUG;
     battleDiff            = DEFAULT_BATTLE_DIFFICULTY;
     validateXml           = DEFAULT_VALIDATE_XML;
@@ -264,10 +272,22 @@ bool Settings::read() {
             screenShakes = (int) strtoul(buffer + strlen("screenShakes="), NULL, 0);        
         else if (strstr(buffer, "gamma=") == buffer)
             gamma = (int) strtoul(buffer + strlen("gamma="), NULL, 0);        
+        else if (strstr(buffer, "minimap=") == buffer)
+            minimap = (int) strtoul(buffer + strlen("minimap="), NULL, 0);
+        else if (strstr(buffer, "minimapX=") == buffer)
+            minimapX = (int) strtoul(buffer + strlen("minimapX="), NULL, 0);
+        else if (strstr(buffer, "minimapY=") == buffer)
+            minimapY = (int) strtoul(buffer + strlen("minimapY="), NULL, 0);
+        else if (strstr(buffer, "minimapSize=") == buffer)
+            minimapSize = (int) strtoul(buffer + strlen("minimapSize="), NULL, 0);
+        else if (strstr(buffer, "minimapZoom=") == buffer)
+            minimapZoom = (int) strtoul(buffer + strlen("minimapZoom="), NULL, 0);
         else if (strstr(buffer, "musicVol=") == buffer)
             musicVol = (int) strtoul(buffer + strlen("musicVol="), NULL, 0);
         else if (strstr(buffer, "soundVol=") == buffer)
             soundVol = (int) strtoul(buffer + strlen("soundVol="), NULL, 0);
+        else if (strstr(buffer, "pcSpeakerSounds=") == buffer)
+            pcSpeakerSounds = (int) strtoul(buffer + strlen("pcSpeakerSounds="), NULL, 0);
         else if (strstr(buffer, "volumeFades=") == buffer)
             volumeFades = (int) strtoul(buffer + strlen("volumeFades="), NULL, 0);        
         else if (strstr(buffer, "shortcutCommands=") == buffer)
@@ -284,6 +304,12 @@ bool Settings::read() {
             enhancements = (int) strtoul(buffer + strlen("enhancements="), NULL, 0);        
         else if (strstr(buffer, "gameCyclesPerSecond=") == buffer)
             gameCyclesPerSecond = (int) strtoul(buffer + strlen("gameCyclesPerSecond="), NULL, 0);
+        else if (strstr(buffer, "frameRate=") == buffer)
+            screenAnimationFramesPerSecond = (int) strtoul(buffer + strlen("frameRate="), NULL, 0);
+        else if (strstr(buffer, "framePaced=") == buffer)
+            framePaced = (int) strtoul(buffer + strlen("framePaced="), NULL, 0);
+        else if (strstr(buffer, "profiling=") == buffer)
+            profiling = (int) strtoul(buffer + strlen("profiling="), NULL, 0);
         else if (strstr(buffer, "debug=") == buffer)
             debug = (int) strtoul(buffer + strlen("debug="), NULL, 0);
         else if (strstr(buffer, "battleDiff=") == buffer)
@@ -374,6 +400,16 @@ bool Settings::read() {
 
     fclose(settingsFile);
 
+    if (screenAnimationFramesPerSecond < 1)
+        screenAnimationFramesPerSecond = 1;
+    else if (screenAnimationFramesPerSecond > MAX_FRAMES_PER_SECOND)
+        screenAnimationFramesPerSecond = MAX_FRAMES_PER_SECOND;
+
+    if (minimapZoom < 1)
+        minimapZoom = 1;
+    else if (minimapZoom > MAX_MINIMAP_ZOOM)
+        minimapZoom = MAX_MINIMAP_ZOOM;
+
     eventTimerGranularity = (1000 / gameCyclesPerSecond);
     return true;
 }
@@ -400,8 +436,14 @@ bool Settings::write() {
             "lineOfSight=%s\n"
             "screenShakes=%d\n"
             "gamma=%d\n"
+            "minimap=%d\n"
+            "minimapX=%d\n"
+            "minimapY=%d\n"
+            "minimapSize=%d\n"
+            "minimapZoom=%d\n"
             "musicVol=%d\n"
             "soundVol=%d\n"
+            "pcSpeakerSounds=%d\n"
             "volumeFades=%d\n"
             "shortcutCommands=%d\n"
             "keydelay=%d\n"
@@ -410,6 +452,9 @@ bool Settings::write() {
             "battlespeed=%d\n"
             "enhancements=%d\n"            
             "gameCyclesPerSecond=%d\n"
+            "frameRate=%d\n"
+            "framePaced=%d\n"
+            "profiling=%d\n"
             "debug=%d\n"
             "battleDiff=%s\n"
             "validateXml=%d\n"
@@ -446,8 +491,14 @@ bool Settings::write() {
             lineOfSight.c_str(),
             screenShakes,
             gamma,
+            minimap,
+            minimapX,
+            minimapY,
+            minimapSize,
+            minimapZoom,
             musicVol,
             soundVol,
+            pcSpeakerSounds,
             volumeFades,
             shortcutCommands,
             keydelay,
@@ -456,6 +507,9 @@ bool Settings::write() {
             battleSpeed,
             enhancements,            
             gameCyclesPerSecond,
+            screenAnimationFramesPerSecond,
+            framePaced,
+            profiling,
             debug,
             battleDiff.c_str(),
             validateXml,
@@ -19,12 +19,14 @@ using std::string;
 #define MAX_KEY_DELAY                   1000
 #define MAX_KEY_INTERVAL                100
 #define MAX_CYCLES_PER_SECOND           20
+#define MAX_FRAMES_PER_SECOND           120
 #define MAX_SPELL_EFFECT_SPEED          10
 #define MAX_CAMP_TIME                   10
 #define MAX_INN_TIME                    10
 #define MAX_SHRINE_TIME                 20
 #define MAX_SHAKE_INTERVAL              200
 #define MAX_VOLUME                      10
+#define MAX_MINIMAP_ZOOM                2
 
 #define DEFAULT_SCALE                   2
 #define DEFAULT_FULLSCREEN              0
@@ -38,8 +40,14 @@ using std::string;
 #define DEFAULT_LINEOFSIGHT             "DOS"
 #define DEFAULT_SCREEN_SHAKES           1
 #define DEFAULT_GAMMA                   100
+#define DEFAULT_MINIMAP                 0
+#define DEFAULT_MINIMAP_X               132
+#define DEFAULT_MINIMAP_Y               12
+#define DEFAULT_MINIMAP_SIZE            48
+#define DEFAULT_MINIMAP_ZOOM            1
 #define DEFAULT_MUSIC_VOLUME            10
 #define DEFAULT_SOUND_VOLUME            10
+#define DEFAULT_PC_SPEAKER_SOUNDS       0
 #define DEFAULT_VOLUME_FADES            1
 #define DEFAULT_SHORTCUT_COMMANDS       0
 #define DEFAULT_KEY_DELAY               500
@@ -49,6 +57,8 @@ using std::string;
 #define DEFAULT_ENHANCEMENTS            1
 #define DEFAULT_CYCLES_PER_SECOND       4
 #define DEFAULT_ANIMATION_FRAMES_PER_SECOND 24
+#define DEFAULT_FRAME_PACED             0
+#define DEFAULT_PROFILING               0
 #define DEFAULT_DEBUG                   0
 #define DEFAULT_VALIDATE_XML            1
 #define DEFAULT_SPELL_EFFECT_SPEED      10
@@ -107,6 +117,8 @@ public:
     bool                fullscreen;
     int                 gameCyclesPerSecond;
     int					screenAnimationFramesPerSecond;
+    bool                framePaced;
+    bool                profiling;
     bool                innAlwaysCombat;
     int                 innTime;
     int                 keydelay;
@@ -116,10 +128,16 @@ public:
     unsigned int        scale;
     bool                screenShakes;
     int                 gamma;
+    bool                minimap;
+    int                 minimapX;
+    int                 minimapY;
+    int                 minimapSize;
+    int                 minimapZoom;
     int                 shakeInterval;
     bool                shortcutCommands;
     int                 shrineTime;
     int                 soundVol;
+    bool                pcSpeakerSounds;
     int                 spellEffectSpeed;
     bool                validateXml;
     bool                volumeFades;
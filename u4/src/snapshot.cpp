@@ -0,0 +1,454 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+#include "snapshot.h"
+
+#include "annotation.h"
+#include "aura.h"
+#include "context.h"
+#include "creature.h"
+#include "game.h"
+#include "location.h"
+#include "map.h"
+#include "mapmgr.h"
+#include "player.h"
+#include "random.h"
+#include "savegame.h"
+#include "savewriter.h"
+#include "stats.h"
+
+#define SNAPSHOT_MAGIC      "XU4S"
+#define SNAPSHOT_VERSION    1
+#define SNAPSHOT_MAX_SIZE   (16 * 1024 * 1024) /* far more than any game needs */
+
+/**
+ * Appends little endian values to a snapshot.
+ */
+class SnapshotWriter {
+public:
+    SnapshotWriter(string &d) : data(d) {}
+
+    void put8(unsigned int v)       { data += static_cast<char>(v & 0xff); }
+    void put16(unsigned int v)      { put8(v); put8(v >> 8); }
+    void put32(unsigned int v)      { put16(v); put16(v >> 16); }
+    void putTile(const MapTile &t)  { put16(t.id); put8(t.frame); put8(t.freezeAnimation); }
+    void putCoords(const Coords &c) { put16(c.x); put16(c.y); put16(c.z); }
+
+private:
+    string &data;
+};
+
+/**
+ * Reads little endian values back from a snapshot.  Reading past the
+ * end returns zeros and marks the reader as failed.
+ */
+class SnapshotReader {
+public:
+    SnapshotReader(const string &d) : data(d), pos(0), ok(true) {}
+
+    bool isOk() const               { return ok; }
+    bool atEnd() const              { return pos == data.size(); }
+
+    unsigned int get8() {
+        if (pos >= data.size()) {
+            ok = false;
+            return 0;
+        }
+        return static_cast<unsigned char>(data[pos++]);
+    }
+    unsigned int get16()            { unsigned int v = get8(); return v | (get8() << 8); }
+    unsigned int get32()            { unsigned int v = get16(); return v | (get16() << 16); }
+    int getSigned16()               { return static_cast<short>(get16()); }
+    MapTile getTile() {
+        MapTile t(get16());
+        t.frame = get8();
+        t.freezeAnimation = get8() != 0;
+        return t;
+    }
+    Coords getCoords() {
+        int x = getSigned16(), y = getSigned16();
+        return Coords(x, y, getSigned16());
+    }
+    const unsigned char *getBytes(unsigned int n) {
+        if (data.size() - pos < n) {
+            ok = false;
+            pos = data.size();
+            return NULL;
+        }
+        pos += n;
+        return reinterpret_cast<const unsigned char *>(data.data()) + pos - n;
+    }
+
+private:
+    const string &data;
+    string::size_type pos;
+    bool ok;
+};
+
+/**
+ * The saved state of one object.
+ */
+struct SnapshotObject {
+    bool creature;
+    CreatureId id;
+    MapTile tile, prevTile;
+    Coords coords, prevCoords;
+    ObjectMovementBehavior movement;
+    bool focused, visible, animated;
+    int hp;
+    StatusType status;
+};
+
+/**
+ * The saved state of one level of the location stack and its map.
+ */
+struct SnapshotLevel {
+    MapId map;
+    MapCoords coords;
+    std::vector<SnapshotObject> objects;
+    std::vector<Annotation> annotations;
+};
+
+static void writeLevel(SnapshotWriter &out, const Location *location) {
+    Map *map = location->map;
+
+    out.put8(map->id);
+    out.putCoords(location->coords);
+
+    out.put16(map->objects.size());
+    for (ObjectDeque::const_iterator i = map->objects.begin(); i != map->objects.end(); i++) {
+        Object *obj = *i;
+        Creature *m = toCreature(obj);
+
+        out.put8(m != NULL);
+        out.put16(m ? m->getId() : 0);
+        out.putTile(obj->getTile());
+        out.putTile(obj->getPrevTile());
+        out.putCoords(obj->getCoords());
+        out.putCoords(obj->getPrevCoords());
+        out.put8(obj->getMovementBehavior());
+        out.put8((obj->hasFocus() ? 1 : 0) | (obj->isVisible() ? 2 : 0) | (obj->isAnimated() ? 4 : 0));
+        out.put16(m ? m->getHp() : 0);
+        out.put8(m ? m->getStatus() : STAT_GOOD);
+    }
+
+    const Annotation::List &annotations = map->annotations->getAll();
+    out.put16(annotations.size());
+    for (Annotation::List::const_iterator i = annotations.begin(); i != annotations.end(); i++) {
+        Annotation a = *i;
+        out.putCoords(a.getCoords());
+        out.putTile(a.getTile());
+        out.put8((a.isVisualOnly() ? 1 : 0) | (a.isCoverUp() ? 2 : 0));
+        out.put16(a.getTTL());
+    }
+}
+
+static void readLevel(SnapshotReader &in, SnapshotLevel &level) {
+    level.map = in.get8();
+    level.coords = in.getCoords();
+
+    level.objects.resize(in.get16());
+    for (std::vector<SnapshotObject>::iterator i = level.objects.begin(); i != level.objects.end() && in.isOk(); i++) {
+        i->creature = in.get8() != 0;
+        i->id = in.get16();
+        i->tile = in.getTile();
+        i->prevTile = in.getTile();
+        i->coords = in.getCoords();
+        i->prevCoords = in.getCoords();
+        i->movement = static_cast<ObjectMovementBehavior>(in.get8());
+        unsigned int flags = in.get8();
+        i->focused = (flags & 1) != 0;
+        i->visible = (flags & 2) != 0;
+        i->animated = (flags & 4) != 0;
+        i->hp = in.getSigned16();
+        i->status = static_cast<StatusType>(in.get8());
+    }
+
+    unsigned int n = in.get16();
+    for (unsigned int i = 0; i < n && in.isOk(); i++) {
+        Coords coords = in.getCoords();
+        MapTile tile = in.getTile();
+        unsigned int flags = in.get8();
+        Annotation a(coords, tile, (flags & 1) != 0, (flags & 2) != 0);
+        a.setTTL(in.getSigned16());
+        level.annotations.push_back(a);
+    }
+}
+
+/**
+ * Removes all the objects from a map and deletes them, except party
+ * members, which persist through maps (see Map::removeObject).
+ * Map::clearObjects only forgets them.
+ */
+static void deleteObjects(Map *map) {
+    while (!map->objects.empty())
+        map->removeObject(map->objects.begin());
+}
+
+/**
+ * Puts the saved objects and annotations back on the level's map.
+ * Objects go to the front of the map's object list and creatures to
+ * the back, and annotations to the front of theirs, so each is added
+ * in the order that keeps the saved ordering.
+ */
+static void restoreLevel(const SnapshotLevel &level, Map *map) {
+    std::vector<SnapshotObject>::const_reverse_iterator o;
+    std::vector<SnapshotObject>::const_iterator m;
+    std::vector<Annotation>::const_reverse_iterator a;
+
+    map->annotations->clear();
+    deleteObjects(map);
+
+    for (o = level.objects.rbegin(); o != level.objects.rend(); o++) {
+        if (o->creature)
+            continue;
+        Object *obj = map->addObject(o->tile, o->prevTile, o->coords);
+        obj->setPrevCoords(o->prevCoords);
+        obj->setMovementBehavior(o->movement);
+        obj->setFocus(o->focused);
+        obj->setVisible(o->visible);
+        obj->setAnimated(o->animated);
+    }
+
+    for (m = level.objects.begin(); m != level.objects.end(); m++) {
+        if (!m->creature)
+            continue;
+        Creature *creature = map->addCreature(creatureMgr->getById(m->id), m->coords);
+        creature->setTile(m->tile);
+        creature->setPrevTile(m->prevTile);
+        creature->setPrevCoords(m->prevCoords);
+        creature->setMovementBehavior(m->movement);
+        creature->setFocus(m->focused);
+        creature->setVisible(m->visible);
+        creature->setAnimated(m->animated);
+        creature->setHp(m->hp);
+        creature->setStatus(m->status);
+    }
+
+    for (a = level.annotations.rbegin(); a != level.annotations.rend(); a++) {
+        Annotation copy = *a;
+        map->annotations->add(copy.getCoords(), copy.getTile(), copy.isVisualOnly(), copy.isCoverUp())->setTTL(copy.getTTL());
+    }
+}
+
+/**
+ * Returns true if a snapshot can be taken right now.
+ */
+bool Snapshot::canCapture() {
+    return c != NULL && c->location != NULL && (c->location->context & CTX_CAN_SAVE_GAME) != 0;
+}
+
+/**
+ * Captures the current state of the game.
+ */
+bool Snapshot::capture() {
+    if (!canCapture())
+        return false;
+
+    std::vector<const Location *> levels;
+    for (const Location *l = c->location; l != NULL; l = l->prev)
+        levels.insert(levels.begin(), l);
+
+    std::vector<unsigned char> save(SaveGame::layout.getSize());
+    SaveGame::layout.encode(c->saveGame, &save[0]);
+
+    RandomState random;
+    xu4_random_get_state(&random);
+
+    data.erase();
+    SnapshotWriter out(data);
+
+    data += SNAPSHOT_MAGIC;
+    out.put8(SNAPSHOT_VERSION);
+    data.append(reinterpret_cast<const char *>(&save[0]), save.size());
+
+    out.putTile(c->party->getTransport());
+    out.put16(c->party->getTorchDuration());
+    out.put8(c->party->getActivePlayer());
+
+    out.put8(c->moonPhase);
+    out.put8(c->windDirection);
+    out.put16(c->windCounter);
+    out.put8(c->windLock);
+    out.put8(c->horseSpeed);
+    out.put8(c->opacity);
+    out.put8(c->aura->getType());
+    out.put16(c->aura->getDuration());
+
+    for (int i = 0; i < RANDOM_MAX; i++) {
+        for (int j = 0; j < 4; j++)
+            out.put32(random.streams[i].s[j]);
+    }
+
+    /* the last ship the party left is remembered by its place on the world map */
+    int lastShip = -1;
+    const ObjectDeque &world = levels.front()->map->objects;
+    for (unsigned int i = 0; i < world.size(); i++) {
+        if (world[i] == c->lastShip)
+            lastShip = i;
+    }
+    out.put16(lastShip);
+
+    out.put8(levels.size());
+    for (std::vector<const Location *>::iterator i = levels.begin(); i != levels.end(); i++)
+        writeLevel(out, *i);
+
+    return true;
+}
+
+/**
+ * Restores the game to the state it was in when the snapshot was
+ * taken.  Returns false, leaving the game untouched, if the snapshot
+ * is empty or not valid.
+ */
+bool Snapshot::restore(GameController *game) const {
+    if (data.empty() || c == NULL || c->location == NULL)
+        return false;
+
+    /* decode the whole snapshot before changing anything */
+    SnapshotReader in(data);
+    const unsigned char *magic = in.getBytes(strlen(SNAPSHOT_MAGIC));
+    if (!magic || memcmp(magic, SNAPSHOT_MAGIC, strlen(SNAPSHOT_MAGIC)) != 0 || in.get8() != SNAPSHOT_VERSION)
+        return false;
+
+    const unsigned char *save = in.getBytes(SaveGame::layout.getSize());
+    MapTile transport = in.getTile();
+    int torchDuration = in.get16();
+    int activePlayer = static_cast<signed char>(in.get8());
+
+    int moonPhase = in.get8();
+    Direction windDirection = static_cast<Direction>(in.get8());
+    int windCounter = in.get16();
+    bool windLock = in.get8() != 0;
+    int horseSpeed = in.get8();
+    int opacity = in.get8();
+    Aura::Type auraType = static_cast<Aura::Type>(in.get8());
+    int auraDuration = in.get16();
+
+    RandomState random;
+    for (int i = 0; i < RANDOM_MAX; i++) {
+        for (int j = 0; j < 4; j++)
+            random.streams[i].s[j] = in.get32();
+    }
+
+    int lastShip = in.getSigned16();
+
+    std::vector<SnapshotLevel> levels(in.get8());
+    for (std::vector<SnapshotLevel>::iterator i = levels.begin(); i != levels.end(); i++)
+        readLevel(in, *i);
+
+    if (!in.isOk() || !in.atEnd() || levels.empty() || levels.front().map != MAP_WORLD)
+        return false;
+
+    for (std::vector<SnapshotLevel>::iterator i = levels.begin(); i != levels.end(); i++) {
+        for (std::vector<SnapshotObject>::iterator j = i->objects.begin(); j != i->objects.end(); j++) {
+            if (j->creature && creatureMgr->getById(j->id) == NULL)
+                return false;
+        }
+    }
+
+    /* leave any maps entered on top of the world map */
+    while (c->location->prev) {
+        if (c->location->prev->map != c->location->map) {
+            c->location->map->annotations->clear();
+            deleteObjects(c->location->map);
+        }
+        locationFree(&c->location);
+    }
+    game->mapArea.setTileset(c->location->map->tileset);
+
+    SaveGame::layout.decode(c->saveGame, save);
+    c->party->restore(transport, torchDuration);
+
+    for (unsigned int i = 0; i < levels.size(); i++) {
+        Map *map = mapMgr->get(levels[i].map);
+        if (i > 0)
+            game->setMap(map, 1, NULL);
+        c->location->coords = levels[i].coords;
+        restoreLevel(levels[i], map);
+    }
+    c->party->setActivePlayer(activePlayer);
+
+    c->moonPhase = moonPhase;
+    c->windDirection = windDirection;
+    c->windCounter = windCounter;
+    c->windLock = windLock;
+    c->horseSpeed = horseSpeed;
+    c->opacity = opacity;
+    c->aura->set(auraType, auraDuration);
+    xu4_random_set_state(random);
+
+    c->lastShip = NULL;
+    const ObjectDeque &world = c->location->prev ? c->location->prev->map->objects : c->location->map->objects;
+    if (lastShip >= 0 && lastShip < static_cast<int>(world.size()))
+        c->lastShip = world[lastShip];
+
+    c->stats->update();
+    return true;
+}
+
+/**
+ * Writes the snapshot to a file, compressed.  The file is written
+ * through the SaveWriter, so it is replaced in one go or not at all.
+ */
+bool Snapshot::write(const string &filename) const {
+    if (data.empty() || data.size() > SNAPSHOT_MAX_SIZE)
+        return false;
+
+    uLongf size = compressBound(data.size());
+    std::vector<unsigned char> packed(size);
+    if (compress2(&packed[0], &size, reinterpret_cast<const Bytef *>(data.data()), data.size(), Z_BEST_COMPRESSION) != Z_OK)
+        return false;
+
+    string contents = SNAPSHOT_MAGIC;
+    SnapshotWriter out(contents);
+    out.put32(data.size());
+    contents.append(reinterpret_cast<const char *>(&packed[0]), size);
+
+    saveWriter.add(filename, contents);
+    return saveWriter.commit();
+}
+
+/**
+ * Reads a snapshot written by write().  The snapshot is only replaced
+ * if the file could be read, and unpacked to the size its header
+ * gives; a header asking for more than any snapshot can hold is taken
+ * as a corrupt file.
+ */
+bool Snapshot::read(const string &filename) {
+    FILE *f = fopen(filename.c_str(), "rb");
+    if (!f)
+        return false;
+
+    std::vector<unsigned char> packed;
+    unsigned char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        packed.insert(packed.end(), buffer, buffer + n);
+    fclose(f);
+
+    unsigned int header = strlen(SNAPSHOT_MAGIC) + 4;
+    if (packed.size() <= header || memcmp(&packed[0], SNAPSHOT_MAGIC, strlen(SNAPSHOT_MAGIC)) != 0)
+        return false;
+
+    unsigned long expected = packed[header - 4] | (packed[header - 3] << 8) | (packed[header - 2] << 16) |
+        (static_cast<unsigned long>(packed[header - 1]) << 24);
+    if (expected == 0 || expected > SNAPSHOT_MAX_SIZE)
+        return false;
+
+    uLongf size = expected;
+    std::vector<unsigned char> unpacked(size);
+    if (uncompress(&unpacked[0], &size, &packed[header], packed.size() - header) != Z_OK || size != expected)
+        return false;
+
+    data.assign(reinterpret_cast<const char *>(&unpacked[0]), size);
+    return true;
+}
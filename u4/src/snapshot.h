@@ -0,0 +1,45 @@
+/*
+ * $Id$
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+
+using std::string;
+
+class GameController;
+
+/**
+ * A snapshot of the running game, kept in memory so it can be
+ * restored instantly: no save files are read, and no maps are
+ * reloaded or people recreated as when loading a game.  Besides what
+ * the save files hold, it keeps every object on the maps (not just the
+ * ones that fit in the u4dos monster table), the annotations, the
+ * aura, wind, moon phase and random number streams, so that a
+ * restored game carries on exactly as it would have.  The timers are
+ * not kept: the wind and moons are what the game timer advances, and
+ * the rest of the timers belong to whatever is on screen.
+ *
+ * Snapshots can be taken wherever the game can be saved, i.e. on the
+ * world map and in dungeons.  They can also be written to, and read
+ * back from, a compressed file.
+ */
+class Snapshot {
+public:
+    static bool canCapture();
+
+    bool capture();
+    bool restore(GameController *game) const;
+    bool isEmpty() const { return data.empty(); }
+    unsigned int getSize() const { return data.size(); }
+
+    bool write(const string &filename) const;
+    bool read(const string &filename);
+
+private:
+    string data;
+};
+
+#endif /* SNAPSHOT_H */
@@ -9,8 +9,10 @@
 #include "debug.h"
 #include "error.h"
 #include "music.h"
+#include "profile.h"
 #include "settings.h"
 #include "u4file.h"
+#include "utils.h"
 
 #include "sound_p.h"
 
@@ -28,7 +30,7 @@ void soundStop(int channel) {
 
 SoundManager *SoundManager::instance = 0;
 
-SoundManager::SoundManager() {
+SoundManager::SoundManager() : soundBank(NULL) {
 }
 
 SoundManager::~SoundManager() {
@@ -59,7 +61,39 @@ int SoundManager::init() {
         
         soundFilenames.push_back(i->getString("file"));
     }
-    return init_sys();
+
+    int result = init_sys();
+    preload();
+    return result;
+}
+
+/**
+ * Loads every sound effect up front, so that none of them has to be
+ * read from disk the first time it plays, e.g. in the middle of a
+ * fight.  With the pcSpeakerSounds setting, the PC speaker style
+ * effects of the original game are synthesized instead, and no files
+ * are read at all.  The backend then packs all the samples into a
+ * single allocation.  Anything that fails here is simply loaded again
+ * when it is first played.
+ */
+void SoundManager::preload() {
+    /* the mixer is opened when the music manager is created */
+    Music::getInstance();
+    if (!Music::functional || !settings.soundVol)
+        return;
+
+    Debug logger("debug/sound.txt", "Sound");
+    double start = Profiler::now();
+
+    for (int sound = 0; sound < SOUND_MAX; sound++) {
+        if (!settings.pcSpeakerSounds || !synth_sys(static_cast<Sound>(sound)))
+            load(static_cast<Sound>(sound));
+    }
+    unsigned int size = pack_sys();
+
+    TRACE(logger, string("preloaded ") + xu4_to_string(SOUND_MAX) + " sounds (" +
+          xu4_to_string(size / 1024) + " KB" + (settings.pcSpeakerSounds ? ", synthesized" : "") +
+          ") in " + xu4_to_string(static_cast<int>((Profiler::now() - start) / 1000)) + " ms");
 }
 
 bool SoundManager::load(Sound sound) {
@@ -59,14 +59,18 @@ public:
     void stop(int channel = 1);
 private:
     bool load(Sound sound);
+    void preload();
 	int init_sys();
 	void del()		{del_sys();}
 	void del_sys();
     void play_sys(Sound sound, bool onlyOnce, int specificDurationInTicks);
     bool load_sys(Sound sound, const std::string &soundPathName);
+    bool synth_sys(Sound sound);
+    unsigned int pack_sys();
     void stop_sys(int channel);
     std::vector<std::string> soundFilenames;
     std::vector<OSSoundChunk *> soundChunk;
+    void *soundBank;    /**< the samples of every preloaded sound, in one allocation */
     SoundManager();
     static SoundManager *instance;
 };
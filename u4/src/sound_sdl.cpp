@@ -10,15 +10,63 @@
 #include <SDL.h>
 #include <SDL_mixer.h>
 
+#include <cstdlib>
+#include <cstring>
+
 #include "sound.h"
 
 #include "config.h"
 #include "debug.h"
 #include "error.h"
 #include "music.h"
+#include "random.h"
 #include "settings.h"
 #include "u4file.h"
 
+/**
+ * One step of a PC speaker effect: a square wave sweeping from one
+ * frequency to another, or, for noise, the speaker flipped at random
+ * at about those rates.  A frequency of 0 is silence, and an effect
+ * ends at the first step without a length.
+ */
+struct SpeakerStep {
+    int from, to;       /**< in Hz */
+    int msecs;
+    bool noise;
+};
+
+#define SPEAKER_STEPS 4
+#define SPEAKER_LEVEL 6000
+
+static const SpeakerStep speakerSounds[SOUND_MAX][SPEAKER_STEPS] = {
+    { { 1500,  100, 800, false } },                                 /* TITLE_FADE */
+    { { 4000, 4000,  15, true } },                                  /* WALK_NORMAL */
+    { { 4000, 4000,  15, true }, { 0, 0, 60, false }, { 4000, 4000, 15, true } }, /* WALK_SLOWED */
+    { { 3000, 3000,  20, true } },                                  /* WALK_COMBAT */
+    { {  150,  150,  80, false } },                                 /* BLOCKED */
+    { {  300,  300, 100, false } },                                 /* ERROR */
+    { { 6000, 1000,  60, true } },                                  /* PC_ATTACK */
+    { {  800,  200, 120, false } },                                 /* PC_STRUCK */
+    { { 1000, 6000,  60, true } },                                  /* NPC_ATTACK */
+    { {  200,  800, 120, false } },                                 /* NPC_STRUCK */
+    { { 3000,  300, 200, true } },                                  /* ACID */
+    { {  600,  300, 300, false } },                                 /* SLEEP */
+    { {  800,  200, 120, false } },                                 /* POISON_EFFECT */
+    { {  200,  800, 120, false } },                                 /* POISON_DAMAGE */
+    { {  200, 2000, 150, false } },                                 /* EVADE */
+    { {  200, 2000, 150, false } },                                 /* FLEE */
+    { {  200, 2000, 150, false } },                                 /* ITEM_STOLEN */
+    { {  400, 1600, 400, false }, { 1600, 400, 400, false } },      /* LBHEAL */
+    { {  500,  500, 100, false }, { 700, 700, 100, false }, { 900, 900, 100, false }, { 1200, 1200, 200, false } }, /* LEVELUP */
+    { {  100, 3000, 600, false } },                                 /* MOONGATE */
+    { { 2000,  200, 300, true } },                                  /* CANNON */
+    { {  150,   60, 1000, true } },                                 /* RUMBLE */
+    { {  200, 2000,  80, false }, { 2000, 200, 80, false }, { 200, 2000, 80, false }, { 2000, 200, 80, false } }, /* PREMAGIC_MANA_JUMBLE */
+    { { 2000,  100, 300, false } },                                 /* MAGIC */
+    { {  300,  900, 250, false }, { 900, 300, 250, false } },       /* WHIRLPOOL */
+    { {  800,  100, 600, true } }                                   /* STORM */
+};
+
 
 bool SoundManager::load_sys(Sound sound, const string &pathname) {
     soundChunk[sound] = Mix_LoadWAV(pathname.c_str());
@@ -29,6 +77,118 @@ bool SoundManager::load_sys(Sound sound, const string &pathname) {
     return true;
 }
 
+/**
+ * Synthesizes a PC speaker style effect in the mixer's output format.
+ * The chunk owns its samples, like one loaded from a file.
+ */
+bool SoundManager::synth_sys(Sound sound) {
+    int rate, channels;
+    Uint16 format;
+    if (!Mix_QuerySpec(&rate, &format, &channels))
+        return false;
+
+    const SpeakerStep *steps = speakerSounds[sound];
+    int samples = 0;
+    for (int i = 0; i < SPEAKER_STEPS && steps[i].msecs; i++)
+        samples += rate * steps[i].msecs / 1000;
+
+    SDL_AudioCVT cvt;
+    if (SDL_BuildAudioCVT(&cvt, AUDIO_S16SYS, 1, rate, format, channels, rate) < 0)
+        return false;
+    cvt.len = samples * sizeof(Sint16);
+    cvt.buf = static_cast<Uint8 *>(malloc(cvt.len * cvt.len_mult));
+    if (!cvt.buf)
+        return false;
+
+    /* the noise is seeded per sound, so an effect sounds the same every time */
+    RandomGenerator noise;
+    noise.seed(sound);
+
+    Sint16 *out = reinterpret_cast<Sint16 *>(cvt.buf);
+    Sint16 level = SPEAKER_LEVEL;
+    double phase = 0;
+    for (int i = 0; i < SPEAKER_STEPS && steps[i].msecs; i++) {
+        int n = rate * steps[i].msecs / 1000;
+        for (int j = 0; j < n; j++) {
+            double freq = steps[i].from + (steps[i].to - steps[i].from) * double(j) / n;
+            if (freq <= 0) {
+                *out++ = 0;
+                continue;
+            }
+
+            /* the speaker flips twice per period */
+            phase += freq / rate;
+            if (phase >= 0.5) {
+                phase -= 0.5;
+                if (steps[i].noise)
+                    level = noise.below(2) ? SPEAKER_LEVEL : -SPEAKER_LEVEL;
+                else
+                    level = -level;
+            }
+            *out++ = level;
+        }
+    }
+
+    Mix_Chunk *chunk = NULL;
+    if (SDL_ConvertAudio(&cvt) == 0)
+        chunk = Mix_QuickLoad_RAW(cvt.buf, cvt.len_cvt);
+    if (!chunk) {
+        free(cvt.buf);
+        return false;
+    }
+    chunk->allocated = 1;
+    soundChunk[sound] = chunk;
+    return true;
+}
+
+/**
+ * Moves the samples of every loaded sound into the one sound bank, so
+ * they all sit together in memory instead of scattered over as many
+ * allocations.  Sounds that share a file share their samples too.
+ * Returns the size of the bank.
+ */
+unsigned int SoundManager::pack_sys() {
+    std::vector<Uint32> offsets(soundChunk.size());
+    Uint32 size = 0;
+    unsigned int i, j;
+
+    for (i = 0; i < soundChunk.size(); i++) {
+        if (!soundChunk[i])
+            continue;
+        for (j = 0; j < i; j++) {
+            if (soundChunk[j] && soundChunk[j]->alen == soundChunk[i]->alen &&
+                memcmp(soundChunk[j]->abuf, soundChunk[i]->abuf, soundChunk[i]->alen) == 0)
+                break;
+        }
+        if (j < i)
+            offsets[i] = offsets[j];
+        else {
+            offsets[i] = size;
+            size += soundChunk[i]->alen;
+        }
+    }
+
+    Uint8 *bank = size ? static_cast<Uint8 *>(malloc(size)) : NULL;
+    if (!bank)
+        return 0;
+
+    for (i = 0; i < soundChunk.size(); i++) {
+        if (!soundChunk[i])
+            continue;
+        memcpy(bank + offsets[i], soundChunk[i]->abuf, soundChunk[i]->alen);
+
+        Mix_Chunk *packed = Mix_QuickLoad_RAW(bank + offsets[i], soundChunk[i]->alen);
+        if (packed) {
+            packed->volume = soundChunk[i]->volume;
+            Mix_FreeChunk(soundChunk[i]);
+            soundChunk[i] = packed;
+        }
+    }
+
+    soundBank = bank;
+    return size;
+}
+
 void SoundManager::play_sys(Sound sound, bool onlyOnce, int specificDurationInTicks) {
 
     /**
@@ -57,4 +217,12 @@ int SoundManager::init_sys()
 
 void SoundManager::del_sys()
 {
+    for (std::vector<Mix_Chunk *>::iterator i = soundChunk.begin(); i != soundChunk.end(); i++) {
+        if (*i)
+            Mix_FreeChunk(*i);
+    }
+    soundChunk.clear();
+
+    free(soundBank);
+    soundBank = NULL;
 }
@@ -9,13 +9,10 @@
 
 #include "debug.h"
 #include "event.h"
-#include "image.h"
-#include "imagemgr.h"
+#include "glyphatlas.h"
 #include "settings.h"
 #include "textview.h"
 
-Image *TextView::charset = NULL;
-
 TextView::TextView(int x, int y, int columns, int rows) : View(x, y, columns * CHAR_WIDTH, rows * CHAR_HEIGHT) {
     this->columns = columns;
     this->rows = rows;
@@ -24,18 +21,11 @@ TextView::TextView(int x, int y, int columns, int rows) : View(x, y, columns * C
     this->cursorX = 0;
     this->cursorY = 0;
     this->cursorPhase = 0;
-    if (charset == NULL)
-        charset = imageMgr->get(BKGD_CHARSET)->image;
-    eventHandler->getTimer()->add(&cursorTimer, /*SCR_CYCLE_PER_SECOND*/4, this);
+    cursorTimerHandle = eventHandler->getTimer()->add(&cursorTimer, /*SCR_CYCLE_PER_SECOND*/4, this);
 }
 
 TextView::~TextView() {
-    eventHandler->getTimer()->remove(&cursorTimer, this);
-}
-
-void TextView::reinit() {
-    View::reinit();
-    charset = imageMgr->get(BKGD_CHARSET)->image;
+    eventHandler->getTimer()->remove(cursorTimerHandle);
 }
 
 /**
@@ -45,11 +35,18 @@ void TextView::drawChar(int chr, int x, int y) {
     ASSERT(x < columns, "x value of %d out of range", x);
     ASSERT(y < rows, "y value of %d out of range", y);
 
-    charset->drawSubRect(SCALED(this->x + (x * CHAR_WIDTH)),
-                         SCALED(this->y + (y * CHAR_HEIGHT)),
-                         0, SCALED(chr * CHAR_HEIGHT),
-                         SCALED(CHAR_WIDTH),
-                         SCALED(CHAR_HEIGHT));
+    GlyphAtlas::getInstance().drawChar(chr, SCALED(this->x + (x * CHAR_WIDTH)), SCALED(this->y + (y * CHAR_HEIGHT)));
+}
+
+/**
+ * Draw a run of characters from the charset onto the view, starting
+ * at the given position.
+ */
+void TextView::drawText(const char *text, int length, int x, int y) {
+    ASSERT(x + length <= columns, "text of length %d at x value of %d out of range", length, x);
+    ASSERT(y < rows, "y value of %d out of range", y);
+
+    GlyphAtlas::getInstance().drawText(text, length, SCALED(this->x + (x * CHAR_WIDTH)), SCALED(this->y + (y * CHAR_HEIGHT)));
 }
 
 /**
@@ -140,15 +137,14 @@ string TextView::colorizeString(string input, ColorFG color, unsigned int colors
 }
 
 void TextView::setFontColor(ColorFG fg, ColorBG bg) {
-    charset->setFontColorFG(fg);
-    charset->setFontColorBG(bg);
+    GlyphAtlas::getInstance().setColor(fg, bg);
 }
 
 void TextView::setFontColorFG(ColorFG fg) {
-    charset->setFontColorFG(fg);
+    GlyphAtlas::getInstance().setColorFG(fg);
 }
 void TextView::setFontColorBG(ColorBG bg) {
-    charset->setFontColorBG(bg);
+    GlyphAtlas::getInstance().setColorBG(bg);
 }
 
 void TextView::textAt(int x, int y, const char *fmt, ...) {
@@ -167,6 +163,8 @@ void TextView::textAt(int x, int y, const char *fmt, ...) {
     vsnprintf(buffer, sizeof(buffer), fmt, args);
     va_end(args);
 
+    /* draw the text between color codes as runs */
+    unsigned int runStart = 0;
     for (i = 0; i < strlen(buffer); i++) {
         switch (buffer[i]) {
             case FG_GREY:
@@ -176,13 +174,16 @@ void TextView::textAt(int x, int y, const char *fmt, ...) {
             case FG_RED:
             case FG_YELLOW:
             case FG_WHITE:
+                if (i > runStart)
+                    drawText(buffer + runStart, i - runStart, x + (runStart - offset), y);
                 setFontColorFG((ColorFG)buffer[i]);
                 offset++;
+                runStart = i + 1;
                 break;
-            default:
-                drawChar(buffer[i], x+(i-offset), y);
         }
     }
+    if (i > runStart)
+        drawText(buffer + runStart, i - runStart, x + (runStart - offset), y);
 
     if (cursorFollowsText)
         setCursorPos(x + i, y, true);
@@ -14,6 +14,7 @@
 #define CHAR_WIDTH 8
 #define CHAR_HEIGHT 8
 
+#include "event.h"
 #include "view.h"
 #include "image.h"
 
@@ -25,8 +26,6 @@ public:
     TextView(int x, int y, int columns, int rows);
     virtual ~TextView();
 
-    void reinit();
-
     int getCursorX() const { return cursorX; }
     int getCursorY() const { return cursorY; }
     bool getCursorEnabled() const { return cursorEnabled; }
@@ -34,6 +33,7 @@ public:
 
     void drawChar(int chr, int x, int y);
     void drawCharMasked(int chr, int x, int y, unsigned char mask);
+    void drawText(const char *text, int length, int x, int y);
     void textAt(int x, int y, const char *fmt, ...) PRINTF_LIKE(4, 5);
     void scroll();
 
@@ -44,7 +44,7 @@ public:
     void drawCursor();
     static void cursorTimer(void *data);
 
-    // functions to modify the charset font palette
+    // functions to set the color of the text drawn
     void setFontColor(ColorFG fg, ColorBG bg);
     void setFontColorFG(ColorFG fg);
     void setFontColorBG(ColorBG bg);
@@ -61,7 +61,7 @@ protected:
     bool cursorFollowsText;     /**< whether the cursor is moved past the last character written */
     int cursorX, cursorY;       /**< current position of cursor */
     int cursorPhase;            /**< the rotation state of the cursor */
-    static Image *charset;      /**< image containing font */
+    TimedEventMgr::Handle cursorTimerHandle; /**< the timer that animates the cursor */
 };
 
 #endif /* TEXTVIEW_H */
@@ -13,6 +13,7 @@
 #include "image.h"
 #include "imagemgr.h"
 #include "location.h"
+#include "memstats.h"
 #include "settings.h"
 #include "tileanim.h"
 #include "tilemap.h"
@@ -38,6 +39,7 @@ Tile::Tile(Tileset *tileset)
     , imageName()
     , looks_like()
     , image(NULL)
+    , averageColor()
     , tiledInDungeon(false)
     , directions()
     , animationRule("") {
@@ -108,6 +110,16 @@ Image *Tile::getImage() {
     return image;
 }
 
+/**
+ * Returns the average color of the tile, e.g. for drawing it as a
+ * single pixel.  It is worked out when the image is loaded.
+ */
+const RGBA &Tile::getAverageColor() {
+    if (!image)
+        loadImage();
+    return averageColor;
+}
+
 /**
  * Loads the tile image
  */ 
@@ -147,6 +159,7 @@ void Tile::loadImage() {
         if (info) {
             w = (subimage ? subimage->width * scale : info->width * scale / info->prescale);
             h = (subimage ? (subimage->height * scale) / frames : (info->height * scale / info->prescale) / frames);
+            MemOwner owner(MEM_IMAGE_TILES);
             image = Image::create(w, h * frames, false, Image::HARDWARE);
 
 
@@ -158,6 +171,23 @@ void Tile::loadImage() {
                 tiles->drawSubRectOn(image, 0, 0, subimage->x * scale, subimage->y * scale, subimage->width * scale, subimage->height * scale);
             }
             else info->image->drawOn(image, 0, 0);
+
+            /* transparent pixels count for nothing */
+            unsigned int r = 0, g = 0, b = 0, total = 0;
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    unsigned int pr, pg, pb, pa;
+                    image->getPixel(x, y, pr, pg, pb, pa);
+                    r += pr * pa;
+                    g += pg * pa;
+                    b += pb * pa;
+                    total += pa;
+                }
+            }
+            if (total)
+                averageColor = RGBA(r / total, g / total, b / total, IM_OPAQUE);
+            else
+                averageColor = RGBA(0, 0, 0, IM_OPAQUE);
         }
 
         if (animationRule.size() > 0) {
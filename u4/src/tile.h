@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "direction.h"
+#include "image.h"
 #include "types.h"
 #include "tileset.h"
 
@@ -16,7 +17,6 @@ using std::string;
 using std::vector;
 
 class ConfigElement;
-class Image;
 class Tileset;
 class TileAnim;
 
@@ -61,6 +61,7 @@ public:
     int getScale() const                {return scale;}
     TileAnim *getAnim() const           {return anim;}
     Image *getImage();
+    const RGBA &getAverageColor();
     const string &getLooksLike() const  {return looks_like;}
 
     bool isTiledInDungeon() const       {return tiledInDungeon;}
@@ -106,6 +107,7 @@ public:
     int frameForDirection(Direction d) const;
 
     static void resetNextId()                       {nextId = 0;}
+    static TileId getNextId()                       {return nextId;}
     static bool canTalkOverTile(const Tile *tile)   {return tile->canTalkOver() != 0;}
     static bool canAttackOverTile(const Tile *tile) {return tile->canAttackOver() != 0;}
     void deleteImage();
@@ -131,6 +133,7 @@ private:
     string looks_like;  /**< The name of the tile that this tile looks exactly like (if any) */    
 
     Image *image;       /**< The original image for this tile (with all of its frames) */
+    RGBA averageColor;  /**< The average color of the first frame, once the image is loaded */
     bool tiledInDungeon;
     vector<Direction> directions;
 
@@ -8,7 +8,9 @@
 
 #include "config.h"
 #include "direction.h"
+#include "error.h"
 #include "image.h"
+#include "profile.h"
 #include "screen.h"
 #include "tileanim.h"
 #include "u4.h"
@@ -18,325 +20,420 @@
 using std::string;
 using std::vector;
 
-TileAnimTransform *TileAnimTransform::create(const ConfigElement &conf) {
-    TileAnimTransform *transform;
-    static const char *transformTypeEnumStrings[] = { "invert", "pixel", "scroll", "frame", "pixel_color", NULL };
-
-    int type = conf.getEnum("type", transformTypeEnumStrings);    
-
-    switch (type) {
-    case 0:
-        transform = new TileAnimInvertTransform(conf.getInt("x"),
-                                                conf.getInt("y"),
-                                                conf.getInt("width"),
-                                                conf.getInt("height"));
-        break;
-
-    case 1: 
-        {
-            transform = new TileAnimPixelTransform(conf.getInt("x"),
-                                                   conf.getInt("y"));
-
-            vector<ConfigElement> children = conf.getChildren();
-            for (std::vector<ConfigElement>::iterator i = children.begin(); i != children.end(); i++) {
-                if (i->getName() == "color") {
-                    RGBA *rgba = loadColorFromConf(*i);
-                    ((TileAnimPixelTransform *)transform)->colors.push_back(rgba);
-                }
-            }
-        }
-
-        break;
-    
-    case 2:
-        transform = new TileAnimScrollTransform(conf.getInt("increment"));
-        break;
-
-    case 3:
-        transform = new TileAnimFrameTransform();
-        break;
-
-    case 4:
-        {
-            transform = new TileAnimPixelColorTransform(conf.getInt("x"),
-                                                        conf.getInt("y"),
-                                                        conf.getInt("width"),
-                                                        conf.getInt("height"));
-
-            vector<ConfigElement> children = conf.getChildren();
-            for (std::vector<ConfigElement>::iterator i = children.begin(); i != children.end(); i++) {
-                if (i->getName() == "color") {
-                    RGBA *rgba = loadColorFromConf(*i);
-                    if (i == children.begin())
-                        ((TileAnimPixelColorTransform *)transform)->start = rgba;
-                    else ((TileAnimPixelColorTransform *)transform)->end = rgba;
-                }
-            }
-        }
-    }
-
-    /**
-     * See if the transform is performed randomely
-     */
-    if (conf.exists("random"))
-        transform->random = conf.getInt("random");
-    else transform->random = 0;
-
-    return transform;
-}
-
 /**
  * Loads a color from a config element
  */
-RGBA *TileAnimTransform::loadColorFromConf(const ConfigElement &conf) {
-    RGBA *rgba;
-    
-    rgba = new RGBA;
-    rgba->r = conf.getInt("red");
-    rgba->g = conf.getInt("green");
-    rgba->b = conf.getInt("blue");
-    rgba->a = IM_OPAQUE;
-
-    return rgba;
+static RGBA loadColorFromConf(const ConfigElement &conf) {
+    return RGBA(conf.getInt("red"), conf.getInt("green"), conf.getInt("blue"), IM_OPAQUE);
 }
 
-TileAnimInvertTransform::TileAnimInvertTransform(int x, int y, int w, int h) {
-    this->x = x;
-    this->y = y;
-    this->w = w;
-    this->h = h;
-}
+/**
+ * TileAnimSet
+ */ 
+TileAnimSet::TileAnimSet(const ConfigElement &conf) {
+    name = conf.getString("name");
 
-bool TileAnimInvertTransform::drawsTile() const { return false; }
-void TileAnimInvertTransform::draw(Image *dest, Tile *tile, MapTile &mapTile) {    
-    int scale = tile->getScale();
-    tile->getImage()->drawSubRectInvertedOn(dest, x * scale, y * scale, x * scale,
-        (tile->getHeight() * mapTile.frame) + (y * scale), w * scale, h * scale);    
+    vector<ConfigElement> children = conf.getChildren();
+    for (std::vector<ConfigElement>::iterator i = children.begin(); i != children.end(); i++) {
+        if (i->getName() == "tileanim") {
+            TileAnim *anim = new TileAnim(*i);
+            tileanims[anim->name] = anim;
+        }
+    }
 }
 
-TileAnimPixelTransform::TileAnimPixelTransform(int x, int y) {
-    this->x = x;
-    this->y = y;
+/**
+ * Returns the tile animation with the given name from the current set
+ */ 
+TileAnim *TileAnimSet::getByName(const std::string &name) {    
+    TileAnimMap::iterator i = tileanims.find(name);
+    if (i == tileanims.end())
+        return NULL;
+    return i->second;
 }
 
-bool TileAnimPixelTransform::drawsTile() const { return false; }
-void TileAnimPixelTransform::draw(Image *dest, Tile *tile, MapTile &mapTile) {
-    RGBA *color = colors[xu4_random(colors.size())];
-    int scale = tile->getScale();
-    dest->fillRect(x * scale, y * scale, scale, scale, color->r, color->g, color->b, color->a);
+/**
+ * Frees the pre-rendered frames of all the tile animations in the set.
+ */
+void TileAnimSet::clearCaches() {
+    for (TileAnimMap::iterator i = tileanims.begin(); i != tileanims.end(); i++)
+        i->second->clearCache();
 }
 
-bool TileAnimScrollTransform::drawsTile() const { return true; }
-TileAnimScrollTransform::TileAnimScrollTransform(int i) : increment(i), current(0), lastOffset(0) {}
-void TileAnimScrollTransform::draw(Image *dest, Tile *tile, MapTile &mapTile) {
-    if (increment == 0)
-        increment = tile->getScale();
-
-    int offset = screenCurrentCycle * 4 / SCR_CYCLE_PER_SECOND * tile->getScale();
-    if (lastOffset != offset) {
-        lastOffset = offset;
-        current += increment;
-        if (current >= tile->getHeight())
-            current = 0;
+TileAnim::TileAnim(const ConfigElement &conf) : random(0), gateCycle(-1), gateOpen(false), cacheable(false), scrollOp(-1) {
+    name = conf.getString("name");
+    if (conf.exists("random"))
+        random = conf.getInt("random");
+       
+    /* the global transforms are done before any of the contextual ones */
+    vector<ConfigElement> children = conf.getChildren();
+    std::vector<ConfigElement>::iterator i;
+    for (i = children.begin(); i != children.end(); i++) {
+        if (i->getName() == "transform")
+            compileTransform(*i);
+    }
+    for (i = children.begin(); i != children.end(); i++) {
+        if (i->getName() == "context")
+            compileContext(*i);
     }
-    
-    tile->getImage()->drawSubRectOn(dest, 0, current, 0, tile->getHeight() * mapTile.frame, tile->getWidth(), tile->getHeight() - current);
-    if (current != 0)
-        tile->getImage()->drawSubRectOn(dest, 0, 0, 0, (tile->getHeight() * mapTile.frame) + tile->getHeight() - current, tile->getWidth(), current);
 
+    /*
+     * See if the animation comes out the same every time: only
+     * inverting and scrolling (outside of any context, as the scroll
+     * moves on whenever it's drawn), none of it random.
+     */
+    cacheable = !program.empty();
+    scrollOp = -1;
+    bool inContext = false;
+    for (unsigned int j = 0; j < program.size(); j++) {
+        TileAnimOp::Code code = program[j].code;
+        if (code == TileAnimOp::IF_FRAME || code == TileAnimOp::IF_DIR)
+            inContext = true;
+        else if (code == TileAnimOp::SCROLL && scrollOp == -1 && !inContext)
+            scrollOp = j;
+        else if (code != TileAnimOp::INVERT)
+            cacheable = false;
+
+        if (program[j].random)
+            cacheable = false;
+    }
 }
 
 /**
- * Advance the frame by one and draw it!
- */ 
-bool TileAnimFrameTransform::drawsTile() const { return true; }
-void TileAnimFrameTransform::draw(Image *dest, Tile *tile, MapTile &mapTile) {
-    if (++currentFrame >= tile->getFrames())
-    	currentFrame = 0;
-    tile->getImage()->drawSubRectOn(dest, 0, 0, 0, currentFrame * tile->getHeight(), tile->getWidth(), tile->getHeight());
-
-
+ * Frees the pre-rendered frames.  They have to be rendered again
+ * whenever the scale or the graphics change.
+ */
+void TileAnim::clearCache() {
+    for (FrameCache::iterator i = frames.begin(); i != frames.end(); i++)
+        delete i->second;
+    frames.clear();
 }
 
-TileAnimPixelColorTransform::TileAnimPixelColorTransform(int x, int y, int w, int h) {
-    this->x = x;
-    this->y = y;
-    this->w = w;
-    this->h = h;
-}
+/**
+ * Compiles a transformation into an op at the end of the program.
+ */
+void TileAnim::compileTransform(const ConfigElement &conf) {
+    static const char *transformTypeEnumStrings[] = { "invert", "pixel", "scroll", "frame", "pixel_color", NULL };
+    TileAnimOp op;
+
+    op.code = static_cast<TileAnimOp::Code>(conf.getEnum("type", transformTypeEnumStrings));
+    op.random = conf.exists("random") ? conf.getInt("random") : 0;
+    op.x = op.y = op.w = op.h = 0;
+    op.increment = 0;
+    op.color = colors.size();
+    op.colors = 0;
+    op.skip = 0;
+    op.current = op.lastOffset = 0;
+    op.gateCycle = -1;
+    op.gateOpen = false;
+
+    switch (op.code) {
+    case TileAnimOp::INVERT:
+    case TileAnimOp::PIXEL_COLOR:
+        op.w = conf.getInt("width");
+        op.h = conf.getInt("height");
+        /* fall through */
+    case TileAnimOp::PIXEL:
+        op.x = conf.getInt("x");
+        op.y = conf.getInt("y");
+        break;
+    case TileAnimOp::SCROLL:
+        op.increment = conf.getInt("increment");
+        break;
+    default:
+        break;
+    }
 
-bool TileAnimPixelColorTransform::drawsTile() const { return false; }
-void TileAnimPixelColorTransform::draw(Image *dest, Tile *tile, MapTile &mapTile) {
-    RGBA diff = *end;
-    int scale = tile->getScale();
-    diff.r -= start->r;
-    diff.g -= start->g;
-    diff.b -= start->b;
-
-    Image *tileImage = tile->getImage();
-
-    for (int j = y * scale; j < (y * scale) + (h * scale); j++) {
-        for (int i = x * scale; i < (x * scale) + (w * scale); i++) {
-            RGBA pixelAt;
-            
-            tileImage->getPixel(i, j + (mapTile.frame * tile->getHeight()), pixelAt.r, pixelAt.g, pixelAt.b, pixelAt.a);
-            if (pixelAt.r >= start->r && pixelAt.r <= end->r &&
-                pixelAt.g >= start->g && pixelAt.g <= end->g &&
-                pixelAt.b >= start->b && pixelAt.b <= end->b) {
-                dest->putPixel(i, j, start->r + xu4_random(diff.r), start->g + xu4_random(diff.g), start->b + xu4_random(diff.b), pixelAt.a);
+    if (op.code == TileAnimOp::PIXEL || op.code == TileAnimOp::PIXEL_COLOR) {
+        vector<ConfigElement> children = conf.getChildren();
+        for (std::vector<ConfigElement>::iterator i = children.begin(); i != children.end(); i++) {
+            if (i->getName() == "color") {
+                colors.push_back(loadColorFromConf(*i));
+                op.colors++;
             }
         }
+
+        /* a color range is from the first color to the last */
+        if (op.code == TileAnimOp::PIXEL_COLOR && op.colors != 2) {
+            if (op.colors > 2)
+                colors.erase(colors.begin() + op.color + 1, colors.end() - 1);
+            else
+                errorFatal("tile animation '%s' needs two colors for its pixel_color transform", name.c_str());
+            op.colors = 2;
+        }
     }
+
+    program.push_back(op);
 }
 
 /**
- * Creates a new animation context which controls if animation transforms are performed or not
- */ 
-TileAnimContext* TileAnimContext::create(const ConfigElement &conf) {
-    TileAnimContext *context;
+ * Compiles a context into a test op followed by the ops for its
+ * transformations, which the test skips over when out of context.
+ */
+void TileAnim::compileContext(const ConfigElement &conf) {
     static const char *contextTypeEnumStrings[] = { "frame", "dir", NULL };
     static const char *dirEnumStrings[] = { "none", "west", "north", "east", "south", NULL };
+    TileAnimOp op;
 
-    TileAnimContext::Type type = (TileAnimContext::Type)conf.getEnum("type", contextTypeEnumStrings);
-
-    switch(type) {
-    case FRAME:
-        context = new TileAnimFrameContext(conf.getInt("frame"));
+    switch (conf.getEnum("type", contextTypeEnumStrings)) {
+    case 0:
+        op.code = TileAnimOp::IF_FRAME;
+        op.x = conf.getInt("frame");
         break;
-    case DIR:
-        context = new TileAnimPlayerDirContext(Direction(conf.getEnum("dir", dirEnumStrings)));
+    case 1:
+        op.code = TileAnimOp::IF_DIR;
+        op.x = conf.getEnum("dir", dirEnumStrings);
         break;
     default:
-        context = NULL;
-        break;
+        return;
     }
+    op.random = 0;
+    op.y = op.w = op.h = 0;
+    op.increment = 0;
+    op.color = op.colors = 0;
+    op.current = op.lastOffset = 0;
+    op.gateCycle = -1;
+    op.gateOpen = false;
 
-    /**
-     * Add the transforms to the context
-     */ 
-    if (context) {        
-        vector<ConfigElement> children = conf.getChildren();
+    unsigned int test = program.size();
+    program.push_back(op);
 
-        for (std::vector<ConfigElement>::iterator i = children.begin(); i != children.end(); i++) {
-            if (i->getName() == "transform") {
-                TileAnimTransform *transform = TileAnimTransform::create(*i);
-                context->add(transform);
-            }        
-        }
+    vector<ConfigElement> children = conf.getChildren();
+    for (std::vector<ConfigElement>::iterator i = children.begin(); i != children.end(); i++) {
+        if (i->getName() == "transform")
+            compileTransform(*i);
     }
-
-    return context;
+    program[test].skip = program.size() - test - 1;
 }
 
 /**
- * Adds a tile transform to the context
- */ 
-void TileAnimContext::add(TileAnimTransform* transform) {
-    animTransforms.push_back(transform);
+ * Decides whether something that happens random percent of the time
+ * happens on the current screen cycle.  The decision is kept for the
+ * rest of the cycle, so every place the tile is drawn agrees and the
+ * random number is only drawn once.
+ */
+bool TileAnim::gate(int random, int &cycle, bool &open) {
+    if (cycle != screenCurrentCycle) {
+        cycle = screenCurrentCycle;
+        open = xu4_random(100, RANDOM_COSMETIC) < random;
+    }
+    return open;
 }
 
 /**
- * A context which depends on the tile's current frame for animation
+ * Moves the animation on as drawing it would, and returns which of
+ * its pictures the tile shows this cycle: 0 for the plain tile, or,
+ * for an animation drawn from the frame cache, 1 plus the step of its
+ * scroll.  Returns -1 for an animation that runs live, which can come
+ * out differently every time it is drawn.  The tile's frame and the
+ * direction pick the strip, so together with those the result tells
+ * the pictures apart without drawing them.
  */
-TileAnimFrameContext::TileAnimFrameContext(int f) : frame(f) {}
-bool TileAnimFrameContext::isInContext(Tile *t, MapTile &mapTile, Direction dir) {
-    return (mapTile.frame == frame);
+int TileAnim::currentStep(Tile *tile, MapTile &mapTile) {
+    /* a random animation happens up to and including its percent */
+    if ((random && !gate(random + 1, gateCycle, gateOpen)) || program.empty() || mapTile.freezeAnimation)
+        return 0;
+
+    if (!cacheable)
+        return -1;
+
+    if (scrollOp == -1)
+        return 1;
+
+    TileAnimOp &op = program[scrollOp];
+    scroll(op, tile);
+    return 1 + op.current / op.increment;
+}
+
+void TileAnim::draw(Image *dest, Tile *tile, MapTile &mapTile, Direction dir) {    
+    drawStep(dest, tile, mapTile, dir, currentStep(tile, mapTile));
 }
 
 /**
- * An animation context which changes the animation based on the player's current facing direction
+ * Draws the picture currentStep returned, without moving the animation
+ * on again.
  */
-TileAnimPlayerDirContext::TileAnimPlayerDirContext(Direction d) : dir(d) {}
-bool TileAnimPlayerDirContext::isInContext(Tile *t, MapTile &mapTile, Direction d) {
-    return (d == dir);
+void TileAnim::drawStep(Image *dest, Tile *tile, MapTile &mapTile, Direction dir, int step) {
+    PROFILE_ZONE(PROF_TILE_ANIM);
+
+    /* nothing to do, draw the tile and return! */
+    if (step == 0) {
+        tile->getImage()->drawSubRectOn(dest, 0, 0, 0, mapTile.frame * tile->getHeight(), tile->getWidth(), tile->getHeight());
+        return;
+    }
+
+    if (step < 0) {
+        run(dest, tile, mapTile, dir, true);
+        return;
+    }
+
+    /* draw the current step of the animation from the frame cache */
+    int steps = 1;
+    if (scrollOp != -1) {
+        const TileAnimOp &op = program[scrollOp];
+        steps = (tile->getHeight() + op.increment - 1) / op.increment;
+    }
+
+    Image *strip = getFrames(tile, mapTile, dir, steps);
+    strip->drawSubRectOn(dest, 0, 0, 0, (step - 1) * tile->getHeight(), tile->getWidth(), tile->getHeight());
 }
 
 /**
- * TileAnimSet
- */ 
-TileAnimSet::TileAnimSet(const ConfigElement &conf) {
-    name = conf.getString("name");
+ * Runs the animation program, drawing the tile onto dest.  Unless
+ * advance is false, scrolls move on to their next step when it's time.
+ */
+void TileAnim::run(Image *dest, Tile *tile, MapTile &mapTile, Direction dir, bool advance) {
+    bool drawn = false;
 
-    vector<ConfigElement> children = conf.getChildren();
-    for (std::vector<ConfigElement>::iterator i = children.begin(); i != children.end(); i++) {
-        if (i->getName() == "tileanim") {
-            TileAnim *anim = new TileAnim(*i);
-            tileanims[anim->name] = anim;
+    TileAnimOp *op = &program[0];
+    TileAnimOp *end = op + program.size();
+    for (; op < end; op++) {
+        switch (op->code) {
+        case TileAnimOp::IF_FRAME:
+            if (mapTile.frame != op->x)
+                op += op->skip;
+            continue;
+        case TileAnimOp::IF_DIR:
+            if (dir != op->x)
+                op += op->skip;
+            continue;
+        case TileAnimOp::SCROLL:
+            if (advance)
+                scroll(*op, tile);
+            break;
+        default:
+            break;
         }
+
+        if (op->random && !gate(op->random, op->gateCycle, op->gateOpen))
+            continue;
+
+        /* the ops that only touch up the tile need it drawn first */
+        if (!drawn && op->code != TileAnimOp::SCROLL && op->code != TileAnimOp::FRAME)
+            tile->getImage()->drawSubRectOn(dest, 0, 0, 0, mapTile.frame * tile->getHeight(), tile->getWidth(), tile->getHeight());
+        perform(*op, dest, tile, mapTile);
+        drawn = true;
     }
 }
 
 /**
- * Returns the tile animation with the given name from the current set
- */ 
-TileAnim *TileAnimSet::getByName(const std::string &name) {    
-    TileAnimMap::iterator i = tileanims.find(name);
-    if (i == tileanims.end())
-        return NULL;
-    return i->second;
-}
+ * Returns the strip of pre-rendered frames for the tile, with one
+ * frame for each step of its scroll, rendering it if need be.
+ */
+Image *TileAnim::getFrames(Tile *tile, MapTile &mapTile, Direction dir, int steps) {
+    FrameKey key;
+    key.tile = tile->getId();
+    key.frame = mapTile.frame;
+    key.dir = dir;
+
+    FrameCache::iterator i = frames.find(key);
+    if (i != frames.end())
+        return i->second;
+
+    int width = tile->getWidth();
+    int height = tile->getHeight();
+    MemOwner owner(MEM_IMAGE_TILES);
+    Image *strip = Image::create(width, height * steps, false, Image::HARDWARE);
+    Image *frame = Image::create(width, height, false, Image::HARDWARE);
+
+    /* copy rather than blend, so the strip keeps the tile's transparency */
+    Image *image = tile->getImage();
+    bool alpha = image->isAlphaOn();
+    image->alphaOff();
+    frame->alphaOff();
+
+    int current = scrollOp != -1 ? program[scrollOp].current : 0;
+    for (int n = 0; n < steps; n++) {
+        if (scrollOp != -1)
+            program[scrollOp].current = n * program[scrollOp].increment;
+
+        frame->fillRect(0, 0, width, height, 0, 0, 0, IM_TRANSPARENT);
+        run(frame, tile, mapTile, dir, false);
+        frame->drawOn(strip, 0, n * height);
+    }
+    if (scrollOp != -1)
+        program[scrollOp].current = current;
 
-TileAnim::TileAnim(const ConfigElement &conf) : random(0) {
-    name = conf.getString("name");
-    if (conf.exists("random"))
-        random = conf.getInt("random");
-       
-    vector<ConfigElement> children = conf.getChildren();
-    for (std::vector<ConfigElement>::iterator i = children.begin(); i != children.end(); i++) {
-        if (i->getName() == "transform") {
-            TileAnimTransform *transform = TileAnimTransform::create(*i);            
+    if (alpha)
+        image->alphaOn();
+    delete frame;
 
-            transforms.push_back(transform);
-        }
-        else if (i->getName() == "context") {
-            TileAnimContext *context = TileAnimContext::create(*i);
+    frames[key] = strip;
+    return strip;
+}
 
-            contexts.push_back(context);
-        }
+/**
+ * Moves a scroll on to its next step, if the screen has cycled far
+ * enough since the last one.
+ */
+void TileAnim::scroll(TileAnimOp &op, Tile *tile) {
+    if (op.increment == 0)
+        op.increment = tile->getScale();
+
+    int offset = screenCurrentCycle * 4 / SCR_CYCLE_PER_SECOND * tile->getScale();
+    if (op.lastOffset != offset) {
+        op.lastOffset = offset;
+        op.current += op.increment;
+        if (op.current >= tile->getHeight())
+            op.current = 0;
     }
 }
 
-void TileAnim::draw(Image *dest, Tile *tile, MapTile &mapTile, Direction dir) {    
-    std::vector<TileAnimTransform *>::const_iterator t;
-    std::vector<TileAnimContext *>::const_iterator c;        
-    bool drawn = false;
+/**
+ * Performs a single transformation of the tile onto dest.
+ */
+void TileAnim::perform(TileAnimOp &op, Image *dest, Tile *tile, MapTile &mapTile) {
+    Image *image = tile->getImage();
+    int scale = tile->getScale();
+    int width = tile->getWidth();
+    int height = tile->getHeight();
 
-    /* nothing to do, draw the tile and return! */
-    if ((random && xu4_random(100) > random) || (!transforms.size() && !contexts.size()) || mapTile.freezeAnimation) {
-        tile->getImage()->drawSubRectOn(dest, 0, 0, 0, mapTile.frame * tile->getHeight(), tile->getWidth(), tile->getHeight());
-        return;
-    }
-    
-    /**
-     * Do global transforms
-     */ 
-    for (t = transforms.begin(); t != transforms.end(); t++) {
-        TileAnimTransform *transform = *t;
-        
-        if (!transform->random || xu4_random(100) < transform->random) {
-            if (!transform->drawsTile() && !drawn)
-                tile->getImage()->drawSubRectOn(dest, 0, 0, 0, mapTile.frame * tile->getHeight(), tile->getWidth(), tile->getHeight());
-            transform->draw(dest, tile, mapTile);
-            drawn = true;
-        }
+    switch (op.code) {
+    case TileAnimOp::INVERT:
+        image->drawSubRectInvertedOn(dest, op.x * scale, op.y * scale, op.x * scale,
+                                     (height * mapTile.frame) + (op.y * scale), op.w * scale, op.h * scale);
+        break;
+
+    case TileAnimOp::PIXEL: {
+        const RGBA &color = colors[op.color + xu4_random(op.colors, RANDOM_COSMETIC)];
+        dest->fillRect(op.x * scale, op.y * scale, scale, scale, color.r, color.g, color.b, color.a);
+        break;
     }
 
-    /**
-     * Do contextual transforms
-     */ 
-    for (c = contexts.begin(); c != contexts.end(); c++) {
-        if ((*c)->isInContext(tile, mapTile, dir)) {
-            TileAnimContext::TileAnimTransformList ctx_transforms = (*c)->getTransforms();
-            for (t = ctx_transforms.begin(); t != ctx_transforms.end(); t++) {
-                TileAnimTransform *transform = *t;
-
-                if (!transform->random || xu4_random(100) < transform->random) {
-                    if (!transform->drawsTile() && !drawn)
-                        tile->getImage()->drawSubRectOn(dest, 0, 0, 0, mapTile.frame * tile->getHeight(), tile->getWidth(), tile->getHeight());
-                    transform->draw(dest, tile, mapTile);
-                    drawn = true;
+    case TileAnimOp::SCROLL:
+        image->drawSubRectOn(dest, 0, op.current, 0, height * mapTile.frame, width, height - op.current);
+        if (op.current != 0)
+            image->drawSubRectOn(dest, 0, 0, 0, (height * mapTile.frame) + height - op.current, width, op.current);
+        break;
+
+    case TileAnimOp::FRAME:
+        if (++op.current >= tile->getFrames())
+            op.current = 0;
+        image->drawSubRectOn(dest, 0, 0, 0, op.current * height, width, height);
+        break;
+
+    case TileAnimOp::PIXEL_COLOR: {
+        const RGBA &start = colors[op.color];
+        const RGBA &end = colors[op.color + 1];
+        RandomGenerator &rng = xu4_random_stream(RANDOM_COSMETIC);
+
+        for (int j = op.y * scale; j < (op.y + op.h) * scale; j++) {
+            for (int i = op.x * scale; i < (op.x + op.w) * scale; i++) {
+                RGBA pixelAt;
+
+                image->getPixel(i, j + (mapTile.frame * height), pixelAt.r, pixelAt.g, pixelAt.b, pixelAt.a);
+                if (pixelAt.r >= start.r && pixelAt.r <= end.r &&
+                    pixelAt.g >= start.g && pixelAt.g <= end.g &&
+                    pixelAt.b >= start.b && pixelAt.b <= end.b) {
+                    dest->putPixel(i, j, start.r + rng.below(end.r - start.r), start.g + rng.below(end.g - start.g),
+                                   start.b + rng.below(end.b - start.b), pixelAt.a);
                 }
             }
         }
+        break;
+    }
+
+    default:
+        break;
     }
 }
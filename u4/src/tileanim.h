@@ -10,164 +10,102 @@
 #include <vector>
 
 #include "direction.h"
+#include "image.h"
+#include "types.h"
 
 class ConfigElement;
-class Image;
 class Tile;
-struct RGBA;
 
 /**
- * The interface for tile animation transformations.
+ * One instruction of a compiled tile animation.  The transformations
+ * and contexts of a tile animation are compiled into a flat program of
+ * these when it is loaded, so drawing an animated tile is just a walk
+ * along an array.
  */
-class  TileAnimTransform {
-public:
-    static TileAnimTransform *create(const ConfigElement &config);    
-    static RGBA *loadColorFromConf(const ConfigElement &conf);
-    
-    virtual void draw(Image *dest, Tile *tile, MapTile &mapTile) = 0;
-    virtual ~TileAnimTransform() {}
-    virtual bool drawsTile() const = 0;
-    
-    // Properties
-    int random;
-
-private:    
-    bool replaces;
-};
-
-/**
- * A tile animation transformation that turns a piece of the tile
- * upside down.  Used for animating the flags on building and ships.
- */
-class TileAnimInvertTransform : public TileAnimTransform {
-public:
-    TileAnimInvertTransform(int x, int y, int w, int h);
-    virtual void draw(Image *dest, Tile *tile, MapTile &mapTile);
-    virtual bool drawsTile() const;
-    
-private:
-    int x, y, w, h;
-};
-
-/**
- * A tile animation transformation that changes a single pixels to a
- * random color selected from a list.  Used for animating the
- * campfire in EGA mode.
- */
-class TileAnimPixelTransform : public TileAnimTransform {
-public:
-    TileAnimPixelTransform(int x, int y);
-    virtual void draw(Image *dest, Tile *tile, MapTile &mapTile);
-    virtual bool drawsTile() const;
-
-    int x, y;
-    std::vector<RGBA *> colors;
-};
-
-/**
- * A tile animation transformation that scrolls the tile's contents
- * vertically within the tile's boundaries.
- */ 
-class TileAnimScrollTransform : public TileAnimTransform {
-public:    
-    TileAnimScrollTransform(int increment);
-    virtual void draw(Image *dest, Tile *tile, MapTile &mapTile);    
-    virtual bool drawsTile() const;
-private:
-    int increment, current, lastOffset;
-};
-
-/**
- * A tile animation transformation that advances the tile's frame
- * by 1.
- */ 
-class TileAnimFrameTransform : public TileAnimTransform {
-public:
-	TileAnimFrameTransform() : currentFrame(0){}
-    virtual void draw(Image *dest, Tile *tile, MapTile &mapTile);
-    virtual bool drawsTile() const;
-protected:
-    int currentFrame;
-};
-
-/**
- * A tile animation transformation that changes pixels with colors
- * that fall in a given range to another color.  Used to animate
- * the campfire in VGA mode.
- */ 
-class TileAnimPixelColorTransform : public TileAnimTransform {
-public:
-    TileAnimPixelColorTransform(int x, int y, int w, int h);
-    virtual void draw(Image *dest, Tile *tile, MapTile &mapTile);
-    virtual bool drawsTile() const;
-
+struct TileAnimOp {
+    enum Code {
+        INVERT,         /**< turns a piece of the tile upside down, for the flags on buildings and ships */
+        PIXEL,          /**< sets a pixel to a random color from a list, for the campfire in EGA mode */
+        SCROLL,         /**< scrolls the tile's contents vertically within the tile's boundaries */
+        FRAME,          /**< advances the tile's frame by 1 */
+        PIXEL_COLOR,    /**< changes pixels within a range of colors at random, for the campfire in VGA mode */
+        IF_FRAME,       /**< skips the next skip ops unless the tile is at frame x */
+        IF_DIR          /**< skips the next skip ops unless the direction is x */
+    };
+
+    Code code;
+    int random;         /**< the percent chance the op is performed on a cycle, or 0 for always */
     int x, y, w, h;
-    RGBA *start, *end;
-};
-
-/**
- * A context in which to perform the animation
- */ 
-class TileAnimContext {    
-public:
-    typedef std::vector<TileAnimTransform *> TileAnimTransformList;
-    typedef enum {
-        FRAME,
-        DIR
-    } Type;
-
-    static TileAnimContext* create(const ConfigElement &config);
-    
-    void add(TileAnimTransform*);
-    virtual bool isInContext(Tile *t, MapTile &mapTile, Direction d) = 0;
-	TileAnimTransformList& getTransforms() {return animTransforms;}	/**< Returns a list of transformations under the context. */
-    virtual ~TileAnimContext() {}
-private:    
-    
-    TileAnimTransformList animTransforms;
-};
-
-/**
- * An animation context which changes the animation based on the tile's current frame
- */ 
-class TileAnimFrameContext : public TileAnimContext {
-public:
-    TileAnimFrameContext(int frame);    
-    virtual bool isInContext(Tile *t, MapTile &mapTile, Direction d);
-
-private:
-    int frame;
-};
-
-/**
- * An animation context which changes the animation based on the player's current facing direction
- */ 
-class TileAnimPlayerDirContext : public TileAnimContext {
-public:
-    TileAnimPlayerDirContext(Direction dir);
-    virtual bool isInContext(Tile *t, MapTile &mapTile, Direction d);
-
-private:
-    Direction dir;
+    int increment;      /**< for SCROLL */
+    int color, colors;  /**< the first of, and the number of, the op's colors in TileAnim::colors */
+    int skip;           /**< for contexts, the number of ops that belong to it */
+
+    /* state carried from one draw to the next */
+    int current;        /**< the scroll offset or frame */
+    int lastOffset;
+    int gateCycle;      /**< the screen cycle the random gate was last decided for */
+    bool gateOpen;
 };
 
 /**
  * Instructions for animating a tile.  Each tile animation is made up
  * of a list of transformations which are applied to the tile after it
- * is drawn.
+ * is drawn, some of which only apply in a context (the tile's current
+ * frame or the player's facing direction).  Random animations and
+ * transformations are decided once per screen cycle, for all the
+ * places the tile is drawn.
+ *
+ * Animations that come out the same every time (inverting and
+ * scrolling, with no random transformations) are rendered once for
+ * each tile, frame and direction into a strip holding every step of
+ * the scroll, and then drawn from there.
  */
 class TileAnim {
 public:
     TileAnim(const ConfigElement &conf);
 
     std::string name;
-    std::vector<TileAnimTransform *> transforms;
-    std::vector<TileAnimContext *> contexts;
 
     /* returns the frame to set the mapTile to (only relevent if persistent) */
     void draw(Image *dest, Tile *tile, MapTile &mapTile, Direction dir);     
+    int currentStep(Tile *tile, MapTile &mapTile);
+    void drawStep(Image *dest, Tile *tile, MapTile &mapTile, Direction dir, int step);
 
     int random;   /* true if the tile animation occurs randomely */
+
+    void clearCache();
+
+private:
+    struct FrameKey {
+        TileId tile;
+        int frame;
+        int dir;
+
+        bool operator<(const FrameKey &other) const {
+            if (tile != other.tile)
+                return tile < other.tile;
+            if (frame != other.frame)
+                return frame < other.frame;
+            return dir < other.dir;
+        }
+    };
+    typedef std::map<FrameKey, Image *> FrameCache;
+
+    void compileTransform(const ConfigElement &conf);
+    void compileContext(const ConfigElement &conf);
+    void run(Image *dest, Tile *tile, MapTile &mapTile, Direction dir, bool advance);
+    void perform(TileAnimOp &op, Image *dest, Tile *tile, MapTile &mapTile);
+    Image *getFrames(Tile *tile, MapTile &mapTile, Direction dir, int steps);
+    static void scroll(TileAnimOp &op, Tile *tile);
+    static bool gate(int random, int &cycle, bool &open);
+
+    std::vector<TileAnimOp> program;
+    std::vector<RGBA> colors;
+    int gateCycle;
+    bool gateOpen;
+    bool cacheable;     /**< whether the animation can be drawn from the frame cache */
+    int scrollOp;       /**< the index of the scroll op, or -1 */
+    FrameCache frames;
 };
 
 /**
@@ -181,6 +119,7 @@ public:
     TileAnimSet(const ConfigElement &conf);
 
     TileAnim *getByName(const std::string &name);
+    void clearCaches();
 
     std::string name;
     TileAnimMap tileanims;
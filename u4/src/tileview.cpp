@@ -7,6 +7,7 @@
 #include "debug.h"
 #include "image.h"
 #include "imagemgr.h"
+#include "memstats.h"
 #include "settings.h"
 #include "screen.h"
 #include "tile.h"
@@ -24,6 +25,7 @@ TileView::TileView(int x, int y, int columns, int rows) : View(x, y, columns * T
     this->tileWidth = TILE_WIDTH;
     this->tileHeight = TILE_HEIGHT;
     this->tileset = Tileset::get("base");
+    MemOwner owner(MEM_IMAGE_VIEW);
     animated = Image::create(SCALED(tileWidth), SCALED(tileHeight), false, Image::HARDWARE);
 }
 
@@ -33,6 +35,7 @@ TileView::TileView(int x, int y, int columns, int rows, const string &tileset) :
     this->tileWidth = TILE_WIDTH;
     this->tileHeight = TILE_HEIGHT;
     this->tileset = Tileset::get(tileset);
+    MemOwner owner(MEM_IMAGE_VIEW);
     animated = Image::create(SCALED(tileWidth), SCALED(tileHeight), false, Image::HARDWARE);
 }
 
@@ -50,6 +53,7 @@ void TileView::reinit() {
     	delete animated;
     	animated = NULL;
     }
+    MemOwner owner(MEM_IMAGE_VIEW);
     animated = Image::create(SCALED(tileWidth), SCALED(tileHeight), false, Image::HARDWARE);
 }
 
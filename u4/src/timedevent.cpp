@@ -0,0 +1,182 @@
+/*
+ * $Id$
+ */
+
+#include "vc6.h" // Fixes things if you're using VC6, does nothing if otherwise
+
+#include "event.h"
+
+unsigned int TimedEventMgr::instances = 0;
+
+/* TimedEvent functions */
+TimedEvent::TimedEvent(TimedEvent::Callback cb, int i, void *d) :
+    callback(cb),
+    data(d),
+    interval(i),
+    due(0),
+    serial(0),
+    prev(-1),
+    next(-1),
+    owner(NULL)
+{}
+
+TimedEvent::Callback TimedEvent::getCallback() const    { return callback; }
+void *TimedEvent::getData()                             { return data; }
+int TimedEvent::getInterval() const                     { return interval; }
+
+/**
+ * Adds a timed event to the event queue.  The event first fires
+ * <interval> ticks from now, and every <interval> ticks after that.
+ * Returns a handle that can later be passed to remove().
+ */
+TimedEventMgr::Handle TimedEventMgr::add(TimedEvent::Callback callback, int interval, void *data) {
+    int index;
+
+    if (freeList >= 0) {
+        index = freeList;
+        freeList = pool[index].next;
+    } else {
+        index = pool.size();
+        pool.push_back(TimedEvent());
+    }
+
+    TimedEvent &event = pool[index];
+    event.callback = callback;
+    event.data = data;
+    event.interval = interval > 0 ? interval : 1;
+    event.due = now + event.interval;
+    link(&wheel[event.due & (WHEEL_SIZE - 1)], index);
+
+    return Handle(index, event.serial);
+}
+
+/**
+ * Removes a timed event from the event queue.  Stale handles (whose
+ * event has already been removed) are ignored.
+ */
+void TimedEventMgr::remove(Handle handle) {
+    if (handle.index < 0 || handle.index >= static_cast<int>(pool.size()))
+        return;
+
+    TimedEvent &event = pool[handle.index];
+    if (event.owner == NULL || event.serial != handle.serial)
+        return;
+
+    unlink(handle.index);
+    event.serial++;
+    event.callback = NULL;
+    event.data = NULL;
+    event.next = freeList;
+    freeList = handle.index;
+}
+
+/**
+ * Removes the first timed event found with the given callback and
+ * data.  Prefer removing by handle where one is available.
+ */
+void TimedEventMgr::remove(TimedEvent::Callback callback, void *data) {
+    for (unsigned int i = 0; i < pool.size(); i++) {
+        if (pool[i].owner != NULL && pool[i].callback == callback && pool[i].data == data) {
+            remove(Handle(i, pool[i].serial));
+            break;
+        }
+    }
+}
+
+/**
+ * Advances the timer by one tick and runs the callback of each event
+ * that has come due.  Due events are first moved to a list local to
+ * this call, so callbacks may add or remove events, or even tick the
+ * timer again from a nested event loop, without disturbing dispatch.
+ */
+void TimedEventMgr::tick() {
+    TimedEventList firing;
+    TimedEventList *slot = &wheel[++now & (WHEEL_SIZE - 1)];
+    int i = slot->head;
+
+    while (i >= 0) {
+        int next = pool[i].next;
+        if (pool[i].due == now) {
+            unlink(i);
+            link(&firing, i);
+        }
+        i = next;
+    }
+
+    while (firing.head >= 0) {
+        i = firing.head;
+        TimedEvent &event = pool[i];
+        TimedEvent::Callback callback = event.callback;
+        void *data = event.data;
+
+        /* reschedule before firing so the callback may remove it */
+        unlink(i);
+        event.due = now + event.interval;
+        link(&wheel[event.due & (WHEEL_SIZE - 1)], i);
+
+        (*callback)(data);
+    }
+}
+
+/**
+ * Runs as many ticks as are due by the given time (in msecs), for
+ * loops that drive the timer from a clock instead of a timer thread.
+ * If the loop has fallen far behind (e.g. it was blocked), the missed
+ * ticks beyond MAX_CATCHUP are dropped rather than fired in a burst.
+ */
+void TimedEventMgr::tickUntil(unsigned int msecs) {
+    if (lastTickTime == 0)
+        lastTickTime = msecs;
+    if (static_cast<int>(msecs - lastTickTime) > MAX_CATCHUP * baseInterval)
+        lastTickTime = msecs - MAX_CATCHUP * baseInterval;
+
+    /* a callback may run a nested loop that advances lastTickTime past msecs */
+    while (static_cast<int>(msecs - lastTickTime) >= baseInterval) {
+        lastTickTime += baseInterval;
+        tick();
+    }
+}
+
+/**
+ * Returns true if another tick would be due at the given time (in
+ * msecs) when the timer is driven by tickUntil().
+ */
+bool TimedEventMgr::hasPendingTicks(unsigned int msecs) const {
+    return static_cast<int>(msecs - lastTickTime) >= baseInterval;
+}
+
+/**
+ * Appends the event at the given pool index to the end of a list.
+ */
+void TimedEventMgr::link(TimedEventList *list, int index) {
+    TimedEvent &event = pool[index];
+    event.owner = list;
+    event.prev = list->tail;
+    event.next = -1;
+    if (list->tail >= 0)
+        pool[list->tail].next = index;
+    else
+        list->head = index;
+    list->tail = index;
+}
+
+/**
+ * Detaches the event at the given pool index from whichever list
+ * currently holds it.
+ */
+void TimedEventMgr::unlink(int index) {
+    TimedEvent &event = pool[index];
+    TimedEventList *list = event.owner;
+
+    if (event.prev >= 0)
+        pool[event.prev].next = event.next;
+    else
+        list->head = event.next;
+    if (event.next >= 0)
+        pool[event.next].prev = event.prev;
+    else
+        list->tail = event.prev;
+
+    event.owner = NULL;
+    event.prev = event.next = -1;
+}
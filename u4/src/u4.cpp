@@ -18,9 +18,12 @@
 #include "event.h"
 #include "game.h"
 #include "intro.h"
+#include "memstats.h"
 #include "music.h"
 #include "person.h"
+#include "profile.h"
 #include "progress_bar.h"
+#include "replay.h"
 #include "screen.h"
 #include "settings.h"
 #include "sound.h"
@@ -33,6 +36,7 @@
 #endif
 
 bool verbose = false;
+bool headless = false;
 bool quit = false;
 bool useProfile = false;
 string profileName = "";
@@ -63,6 +67,9 @@ int main(int argc, char *argv[]) {
 
 	unsigned int i;
     int skipIntro = 0;
+    bool seeded = false;
+    unsigned int seed = 0;
+    string replayFile;
 
 
     /*
@@ -159,6 +166,46 @@ int main(int argc, char *argv[]) {
             settings.musicVol = 0;
             settings.soundVol = 0;
         }
+        else if (strcmp(argv[i], "-headless") == 0
+              || strcmp(argv[i], "--headless") == 0)
+        {
+            headless = true;
+            settings.framePaced = true;
+        }
+        else if (strcmp(argv[i], "-debug") == 0
+              || strcmp(argv[i], "--debug") == 0)
+        {
+            settings.debug = true;
+        }
+        else if (strcmp(argv[i], "-memcheck") == 0
+              || strcmp(argv[i], "--memcheck") == 0)
+        {
+            memstats.setStrict(true);
+        }
+        else if (strcmp(argv[i], "-seed") == 0
+              || strcmp(argv[i], "--seed") == 0)
+        {
+            if ((unsigned int)argc > i + 1)
+            {
+                seed = strtoul(argv[i+1], NULL, 0);
+                seeded = true;
+                i++;
+            }
+            else
+                errorFatal("%s is invalid alone: Requires a number for input. See --help for more detail.\n", argv[i]);
+        }
+        else if (strcmp(argv[i], "-replay") == 0
+              || strcmp(argv[i], "--replay") == 0)
+        {
+            if ((unsigned int)argc > i + 1)
+            {
+                replayFile = argv[i+1];
+                settings.framePaced = true;
+                i++;
+            }
+            else
+                errorFatal("%s is invalid alone: Requires a string for input. See --help for more detail.\n", argv[i]);
+        }
         else if (strcmp(argv[i], "-h") == 0
               || strcmp(argv[i], "-help") == 0
               || strcmp(argv[i], "--help") == 0)
@@ -170,12 +217,21 @@ int main(int argc, char *argv[]) {
             printf("-q, --quiet		Sets all audio volume to zero.\n");
             printf("-f, --fullscreen	Runs xu4 in fullscreen mode.\n");
             printf("-i, --skip-intro	Skips the intro and loads the last savegame.\n");
+            printf("--headless		Runs without a visible window or audio output.\n");
+            printf("--debug			Enables the debug commands, such as the ctrl-C\n"
+                   "			cheat menu.\n");
+            printf("--memcheck		Exits with an error if memory is left resident\n"
+                   "			after a screen re-init, or after a town is\n"
+                   "			left (towns are unloaded as they are left).\n");
 
             printf("\n-s <int>,\n");
             printf("--scale <int>		Used to specify scaling options.\n");
             printf("-p <string>,\n");
             printf("--profile <string>	Used to pass extra arguements to the program.\n");
             printf("--filter <string>	Used to specify filtering options.\n");
+            printf("--seed <int>		Seeds the random number generator.\n");
+            printf("--replay <file>		Plays the key presses in an input script and\n"
+                   "			reports frame and turn timings when it ends.\n");
 
             printf("\n-h, --help		Prints this message.\n");
 
@@ -188,7 +244,20 @@ int main(int argc, char *argv[]) {
 
     }
 
-    xu4_srandom();
+    if (settings.profiling)
+        profiler.setEnabled(true);
+
+    if (seeded)
+        xu4_srandom(seed);
+    else
+        xu4_srandom();
+
+    if (!replayFile.empty()) {
+        InputScript *script = new InputScript();
+        if (!script->load(replayFile))
+            errorFatal("unable to read input script %s", replayFile.c_str());
+        eventHandler->setInputScript(script);
+    }
 
     perf.start();
     screenInit();
@@ -204,7 +273,7 @@ int main(int argc, char *argv[]) {
 
     perf.start();
     soundInit();
-    perf.end("Misc Initialization");
+    perf.end("soundInit()");
     ++pb;
 
     perf.start();
@@ -266,6 +335,7 @@ int main(int argc, char *argv[]) {
     eventHandler->run();
     eventHandler->popController();
 
+    memstats.log();
     Tileset::unloadAll();
 
     delete musicMgr;
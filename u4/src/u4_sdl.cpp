@@ -8,7 +8,14 @@
 #include <SDL.h>
 #include "u4_sdl.h"
 
+extern bool headless;
+
 static inline int u4_SDL_Init() {
+    /* render into memory surfaces and discard audio */
+    if (headless) {
+        SDL_putenv(const_cast<char *>("SDL_VIDEODRIVER=dummy"));
+        SDL_putenv(const_cast<char *>("SDL_AUDIODRIVER=dummy"));
+    }
     return SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_AUDIO);
 }
 
@@ -1,6 +1,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "savegame.h"
 #include "names.h"
@@ -9,26 +11,59 @@ int verbose = 0;
 
 void showSaveGame(SaveGame *sg);
 void showSaveGamePlayerRecord(SaveGamePlayerRecord *rec);
+void showFields(const SaveGameLayout &layout, const void *record, const char *indent);
+void showMonsters(SaveGameMonsterRecord *monsterTable);
 char *itemsString(unsigned short items);
 
+/**
+ * Dumps a party.sav, or with -m a monsters.sav or outmonst.sav.  With
+ * -f, party.sav is dumped field by field as laid out in the file.
+ */
 int main(int argc, char *argv[]) {
     SaveGame sg;
+    SaveGameMonsterRecord monsterTable[MONSTERTABLE_SIZE];
+    std::vector<unsigned char> data;
+    unsigned char buffer[1024];
+    size_t n;
+    bool fields = false, monsters = false;
     FILE *in;
 
-    if (argc != 2) {
-        fprintf(stderr, "usage: %s party.sav\n", argv[0]);
+    if (argc == 3 && strcmp(argv[1], "-f") == 0)
+        fields = true;
+    else if (argc == 3 && strcmp(argv[1], "-m") == 0)
+        monsters = true;
+    else if (argc != 2) {
+        fprintf(stderr, "usage: %s [-f | -m] party.sav\n", argv[0]);
         exit(1);
     }
 
-    in = fopen(argv[1], "rb");
+    in = fopen(argv[argc - 1], "rb");
     if (!in) {
-        perror(argv[1]);
+        perror(argv[argc - 1]);
         exit(1);
     }
 
-    sg.read(in);
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+        data.insert(data.end(), buffer, buffer + n);
+    fclose(in);
+    data.push_back(0); /* so &data[0] is valid for an empty file */
 
-    showSaveGame(&sg);
+    if (monsters) {
+        if (!saveGameMonstersRead(monsterTable, &data[0], data.size() - 1)) {
+            fprintf(stderr, "%s: too short for a monster table\n", argv[argc - 1]);
+            exit(1);
+        }
+        showMonsters(monsterTable);
+        return 0;
+    }
+
+    if (!sg.read(&data[0], data.size() - 1))
+        fprintf(stderr, "%s: too short, missing fields read as zero\n", argv[argc - 1]);
+
+    if (fields)
+        showFields(SaveGame::layout, &sg, "");
+    else
+        showSaveGame(&sg);
 
     return 0;
 }
@@ -117,6 +152,46 @@ void showSaveGamePlayerRecord(SaveGamePlayerRecord *rec) {
            rec->sex == 11 ? "M" : "F", getClassName(rec->klass), rec->status);
 }
 
+/**
+ * Shows each field of a record, in the order they are stored in the
+ * file.
+ */
+void showFields(const SaveGameLayout &layout, const void *record, const char *indent) {
+    for (unsigned int f = 0; f < layout.nfields; f++) {
+        const SaveGameField &field = layout.fields[f];
+
+        if (field.record) {
+            for (unsigned int i = 0; i < field.count; i++) {
+                printf("%s%s[%u]:\n", indent, field.name, i);
+                showFields(*field.record, static_cast<const char *>(record) + field.offset + i * field.memSize,
+                           (std::string(indent) + "  ").c_str());
+            }
+            continue;
+        }
+
+        printf("%s%s:", indent, field.name);
+        for (unsigned int i = 0; i < field.count; i++)
+            printf(" %u", layout.getValue(record, f, i));
+        printf("\n");
+    }
+}
+
+void showMonsters(SaveGameMonsterRecord *monsterTable) {
+    const SaveGameLayout &layout = saveGameMonsterLayout;
+
+    printf("   ");
+    for (unsigned int f = 0; f < layout.nfields; f++)
+        printf(" %8s", layout.fields[f].name);
+    printf("\n");
+
+    for (int i = 0; i < MONSTERTABLE_SIZE; i++) {
+        printf("%2d:", i);
+        for (unsigned int f = 0; f < layout.nfields; f++)
+            printf(" %8u", layout.getValue(&monsterTable[i], f));
+        printf("\n");
+    }
+}
+
 char *itemsString(unsigned short items) {
     static char buffer[256];
     int first = 1;
@@ -0,0 +1,131 @@
+/*
+ * $Id$
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "object.h"
+
+/*
+ * Creature, Person and PartyMember can't be linked without the rest
+ * of the game, so these stand in for them: the same depth below
+ * Object, tagged with the same kinds.
+ */
+class BenchCreature : public Object {
+public:
+    BenchCreature(Type t = CREATURE, Kind k = KIND_CREATURE) : Object(t, k), hp(10) {}
+    virtual ~BenchCreature() {}
+    int hp;
+};
+
+class BenchPerson : public BenchCreature {
+public:
+    BenchPerson() : BenchCreature(PERSON, KIND_PERSON) {}
+    virtual ~BenchPerson() {}
+};
+
+class BenchPartyMember : public BenchCreature {
+public:
+    BenchPartyMember() : BenchCreature(CREATURE, KIND_PARTY_MEMBER) {}
+    virtual ~BenchPartyMember() {}
+};
+
+/**
+ * What a turn of Map::moveObjects and the combat rosters asks of each
+ * object: is it a creature, and if so a person or a party member.
+ * The two versions differ only in how they ask.
+ */
+static long turnDynamicCast(const std::vector<Object *> &objects) {
+    long sum = 0;
+
+    for (std::vector<Object *>::const_iterator i = objects.begin(); i != objects.end(); i++) {
+        BenchCreature *m = dynamic_cast<BenchCreature *>(*i);
+        if (!m)
+            continue;
+        sum += m->hp;
+        if (dynamic_cast<BenchPerson *>(m))
+            sum += 2;
+        else if (dynamic_cast<BenchPartyMember *>(m))
+            sum += 3;
+    }
+    return sum;
+}
+
+static long turnKindTag(const std::vector<Object *> &objects) {
+    long sum = 0;
+
+    for (std::vector<Object *>::const_iterator i = objects.begin(); i != objects.end(); i++) {
+        if (!(*i)->isCreatureKind())
+            continue;
+        BenchCreature *m = static_cast<BenchCreature *>(*i);
+        sum += m->hp;
+        if (m->getKind() == Object::KIND_PERSON)
+            sum += 2;
+        else if (m->getKind() == Object::KIND_PARTY_MEMBER)
+            sum += 3;
+    }
+    return sum;
+}
+
+static double timeTurns(long (*turn)(const std::vector<Object *> &), const std::vector<Object *> &objects, unsigned int turns, long *sum) {
+    clock_t start = clock();
+
+    *sum = 0;
+    for (unsigned int t = 0; t < turns; t++)
+        *sum += (*turn)(objects);
+    return 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Compares dispatching on objects with dynamic_cast against the kind
+ * tag, over a world map's worth of objects: mostly creatures, some
+ * people and plain objects, and the party.  Takes the number of
+ * objects and turns.
+ */
+int main(int argc, char *argv[]) {
+    unsigned int n = 500, turns = 10000;
+    std::vector<Object *> objects;
+
+    if (argc > 3) {
+        fprintf(stderr, "usage: %s [objects [turns]]\n", argv[0]);
+        exit(1);
+    }
+    if (argc > 1)
+        n = strtoul(argv[1], NULL, 0);
+    if (argc > 2)
+        turns = strtoul(argv[2], NULL, 0);
+
+    srand(1);
+    for (unsigned int i = 0; i < n; i++) {
+        int r = rand() % 10;
+        if (i < 8)
+            objects.push_back(new BenchPartyMember());
+        else if (r < 6)
+            objects.push_back(new BenchCreature());
+        else if (r < 8)
+            objects.push_back(new BenchPerson());
+        else
+            objects.push_back(new Object());
+    }
+    std::random_shuffle(objects.begin(), objects.end());
+
+    long castSum, tagSum;
+    double castMsecs = timeTurns(&turnDynamicCast, objects, turns, &castSum);
+    double tagMsecs = timeTurns(&turnKindTag, objects, turns, &tagSum);
+
+    printf("%u objects, %u turns: dynamic_cast %0.1f nsecs/object, kind tag %0.1f nsecs/object\n",
+           n, turns, 1e6 * castMsecs / (static_cast<double>(n) * turns), 1e6 * tagMsecs / (static_cast<double>(n) * turns));
+
+    for (std::vector<Object *>::iterator i = objects.begin(); i != objects.end(); i++)
+        delete *i;
+
+    if (castSum != tagSum) {
+        fprintf(stderr, "dispatch differs: %ld with dynamic_cast, %ld with kind tag\n", castSum, tagSum);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * $Id$
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <list>
+#include <vector>
+
+#include "event.h"
+
+/*
+ * The rest of TimedEventMgr (event_sdl.cpp) drives the timer from an
+ * SDL timer thread.  Here tick() is called directly, so the timer is
+ * constructed without one.
+ */
+TimedEventMgr::TimedEventMgr(int i) : id(NULL), baseInterval(i), now(0), lastTickTime(0), freeList(-1) {
+    instances++;
+}
+
+TimedEventMgr::~TimedEventMgr() {
+    instances--;
+}
+
+/**
+ * The timer as it was before the wheel: a list of heap allocated
+ * events, each of which has its counter bumped on every tick.  Kept
+ * here only to compare against.
+ */
+class ListTimer {
+public:
+    struct Event {
+        TimedEvent::Callback callback;
+        void *data;
+        int interval, current;
+    };
+
+    ~ListTimer() {
+        for (std::list<Event *>::iterator i = events.begin(); i != events.end(); i++)
+            delete *i;
+    }
+
+    void add(TimedEvent::Callback callback, int interval, void *data) {
+        Event *event = new Event;
+        event->callback = callback;
+        event->data = data;
+        event->interval = interval;
+        event->current = 0;
+        events.push_back(event);
+    }
+
+    void tick() {
+        for (std::list<Event *>::iterator i = events.begin(); i != events.end(); i++) {
+            Event *event = *i;
+            if (++event->current >= event->interval) {
+                (*event->callback)(event->data);
+                event->current = 0;
+            }
+        }
+    }
+
+private:
+    std::list<Event *> events;
+};
+
+/**
+ * A timer that removes itself when it fires and adds a new one in its
+ * place, to exercise adding and removing during dispatch.
+ */
+struct Churner {
+    TimedEventMgr *timer;
+    TimedEventMgr::Handle handle;
+    int interval;
+    unsigned long fired;
+};
+
+static unsigned long firedCount = 0;
+
+static void countFired(void *data) {
+    (*static_cast<unsigned long *>(data))++;
+    firedCount++;
+}
+
+static void churn(void *data) {
+    Churner *churner = static_cast<Churner *>(data);
+
+    churner->fired++;
+    firedCount++;
+    churner->timer->remove(churner->handle);
+    churner->interval = churner->interval % 64 + 1;
+    churner->handle = churner->timer->add(&churn, churner->interval, churner);
+}
+
+static double msecsSince(clock_t start) {
+    return 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Checks that each timer with the given interval fired exactly as
+ * often as it should have in the given number of ticks.
+ */
+static bool checkFired(const std::vector<int> &intervals, const std::vector<unsigned long> &fired, unsigned int ticks) {
+    for (unsigned int i = 0; i < intervals.size(); i++) {
+        if (fired[i] != ticks / intervals[i]) {
+            fprintf(stderr, "timer %u (interval %d) fired %lu times in %u ticks, expected %u\n",
+                    i, intervals[i], fired[i], ticks, ticks / intervals[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Times ticking the wheel and the old list timer with the given number
+ * of timers, with intervals spread over 1 to 64 ticks, and then with
+ * the same number of timers replacing themselves each time they fire.
+ * Returns false if any timer fired the wrong number of times.
+ */
+static bool bench(unsigned int n, unsigned int ticks) {
+    std::vector<int> intervals(n);
+    std::vector<unsigned long> fired(n, 0);
+    std::vector<unsigned long> listFired(n, 0);
+
+    for (unsigned int i = 0; i < n; i++)
+        intervals[i] = 1 + rand() % 64;
+
+    TimedEventMgr wheel(250);
+    for (unsigned int i = 0; i < n; i++)
+        wheel.add(&countFired, intervals[i], &fired[i]);
+
+    clock_t start = clock();
+    for (unsigned int t = 0; t < ticks; t++)
+        wheel.tick();
+    double wheelMsecs = msecsSince(start);
+
+    ListTimer list;
+    for (unsigned int i = 0; i < n; i++)
+        list.add(&countFired, intervals[i], &listFired[i]);
+
+    start = clock();
+    for (unsigned int t = 0; t < ticks; t++)
+        list.tick();
+    double listMsecs = msecsSince(start);
+
+    std::vector<Churner> churners(n);
+    TimedEventMgr churnWheel(250);
+    for (unsigned int i = 0; i < n; i++) {
+        churners[i].timer = &churnWheel;
+        churners[i].interval = intervals[i];
+        churners[i].fired = 0;
+        churners[i].handle = churnWheel.add(&churn, churners[i].interval, &churners[i]);
+    }
+
+    firedCount = 0;
+    start = clock();
+    for (unsigned int t = 0; t < ticks; t++)
+        churnWheel.tick();
+    double churnMsecs = msecsSince(start);
+
+    printf("%6u timers: wheel %8.3f, list %8.3f, churning wheel %8.3f usecs/tick (%lu churned)\n",
+           n, 1000.0 * wheelMsecs / ticks, 1000.0 * listMsecs / ticks, 1000.0 * churnMsecs / ticks, firedCount);
+
+    return checkFired(intervals, fired, ticks) && checkFired(intervals, listFired, ticks);
+}
+
+/**
+ * Stress tests the timed event manager's timer wheel with growing
+ * numbers of timers, comparing the time per tick against the list the
+ * wheel replaced.  Takes the number of ticks to run at each size, and
+ * exits non-zero if a timer fires the wrong number of times.
+ */
+int main(int argc, char *argv[]) {
+    static const unsigned int sizes[] = { 10, 100, 1000, 5000, 10000 };
+    unsigned int ticks = 20000;
+
+    if (argc > 2) {
+        fprintf(stderr, "usage: %s [ticks]\n", argv[0]);
+        exit(1);
+    }
+    if (argc > 1)
+        ticks = strtoul(argv[1], NULL, 0);
+
+    srand(1);
+    for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        if (!bench(sizes[i], ticks))
+            exit(1);
+    }
+
+    return 0;
+}
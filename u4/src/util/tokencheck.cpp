@@ -0,0 +1,127 @@
+/*
+ * $Id$
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+
+#include "dungeon.h"
+#include "settings.h"
+#include "tile.h"
+#include "tilemap.h"
+#include "tileset.h"
+#include "utils.h"
+
+/*
+ * The globals u4.cpp would otherwise provide to the rest of the game.
+ */
+bool verbose = false;
+bool headless = true;
+bool quit = false;
+bool useProfile = false;
+string profileName = "";
+Performance perf("debug/performance.txt");
+
+/**
+ * The token each dungeon tile is expected to have, written out by hand
+ * rather than taken from Dungeon::tokenForTileName.  Tiles not listed
+ * here are plain corridor.
+ */
+static const struct {
+    const char *name;
+    DungeonToken token;
+} expectedTokens[] = {
+    { "brick_floor", DUNGEON_CORRIDOR },
+    { "up_ladder", DUNGEON_LADDER_UP },
+    { "down_ladder", DUNGEON_LADDER_DOWN },
+    { "up_down_ladder", DUNGEON_LADDER_UPDOWN },
+    { "chest", DUNGEON_CHEST },
+    { "unimpl_ceiling_hole", DUNGEON_CEILING_HOLE },
+    { "unimpl_floor_hole", DUNGEON_FLOOR_HOLE },
+    { "magic_orb", DUNGEON_MAGIC_ORB },
+    { "ceiling_hole", DUNGEON_TRAP },
+    { "fountain", DUNGEON_FOUNTAIN },
+    { "poison_field", DUNGEON_FIELD },
+    { "energy_field", DUNGEON_FIELD },
+    { "fire_field", DUNGEON_FIELD },
+    { "sleep_field", DUNGEON_FIELD },
+    { "dungeon_altar", DUNGEON_ALTAR },
+    { "dungeon_door", DUNGEON_DOOR },
+    { "dungeon_room", DUNGEON_ROOM },
+    { "secret_door", DUNGEON_SECRET_DOOR },
+    { "brick_wall", DUNGEON_WALL }
+};
+
+/**
+ * Checks the token of the given tile against the expected list, and
+ * returns false (after saying why) if it is wrong.
+ */
+static bool checkTile(const Tile *tile, const std::map<string, DungeonToken> &expected) {
+    std::map<string, DungeonToken>::const_iterator i = expected.find(tile->getName());
+    DungeonToken want = i == expected.end() ? DUNGEON_CORRIDOR : i->second;
+    DungeonToken got = Dungeon::tokenForTile(MapTile(tile->getId()));
+
+    if (got != want) {
+        fprintf(stderr, "tile %s (%d) has dungeon token 0x%02x, expected 0x%02x\n",
+                tile->getName().c_str(), tile->getId(), got, want);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Loads the tilesets as the game does and checks the dungeon token
+ * table against a hand-written list: every tile a dungeon map can
+ * hold, and every listed tile that exists.  Exits non-zero if any
+ * tile has the wrong token.
+ */
+int main(int argc, char *argv[]) {
+    std::map<string, DungeonToken> expected;
+    unsigned int checked = 0;
+    bool ok = true;
+
+    if (argc > 1) {
+        fprintf(stderr, "usage: %s\n", argv[0]);
+        exit(1);
+    }
+
+    settings.init(false, "");
+    Tileset::loadAll();
+    Dungeon::initTileTokens();
+
+    for (unsigned int i = 0; i < sizeof(expectedTokens) / sizeof(expectedTokens[0]); i++)
+        expected[expectedTokens[i].name] = expectedTokens[i].token;
+
+    TileMap *tilemap = TileMap::get("dungeon");
+    if (!tilemap) {
+        fprintf(stderr, "no dungeon tilemap\n");
+        exit(1);
+    }
+
+    for (unsigned int index = 0; index < 256; index++) {
+        Tile *tile = Tileset::findTileById(tilemap->translate(index).getId());
+        if (!tile) {
+            fprintf(stderr, "dungeon tile index %u has no tile\n", index);
+            ok = false;
+            continue;
+        }
+        ok = checkTile(tile, expected) && ok;
+        checked++;
+    }
+
+    for (std::map<string, DungeonToken>::iterator i = expected.begin(); i != expected.end(); i++) {
+        Tile *tile = Tileset::findTileByName(i->first);
+        if (tile) {
+            ok = checkTile(tile, expected) && ok;
+            checked++;
+        }
+    }
+
+    printf("%u dungeon tiles checked\n", checked);
+
+    Tileset::unloadAll();
+
+    return ok ? 0 : 1;
+}
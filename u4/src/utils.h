@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "filesystem.h"
+#include "random.h"
 
 using std::string;
 
@@ -33,8 +34,6 @@ inline void AdjustValueMax(unsigned short &v, int val, int max) { v += val; if (
 inline void AdjustValueMin(unsigned short &v, int val, int min) { v += val; if (v < min) v = min; }
 inline void AdjustValue(unsigned short &v, int val, int max, int min) { v += val; if (v > max) v = max; if (v < min) v = min; }
 
-void xu4_srandom(void);
-int xu4_random(int upperval);
 string& trim(string &val, const string &chars_to_trim = "\t\013\014 \n\r");
 string& lowercase(string &val);
 string& uppercase(string &val);
@@ -320,6 +320,14 @@ SOURCE=..\src\game.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\src\glyphatlas.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\glyphatlas.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\src\image.h
 # End Source File
 # Begin Source File
@@ -416,6 +424,14 @@ SOURCE=..\src\mapmgr.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\src\memstats.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\memstats.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\src\menu.cpp
 # End Source File
 # Begin Source File
@@ -424,6 +440,14 @@ SOURCE=..\src\menu.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\src\minimap.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\minimap.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\src\moongate.cpp
 # End Source File
 # Begin Source File
@@ -464,6 +488,14 @@ SOURCE=..\src\object.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\src\objecttable.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\objecttable.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\src\observable.h
 # End Source File
 # Begin Source File
@@ -496,6 +528,14 @@ SOURCE=..\src\portal.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\src\profile.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\profile.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\src\progress_bar.cpp
 # End Source File
 # Begin Source File
@@ -504,6 +544,22 @@ SOURCE=..\src\progress_bar.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\src\random.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\random.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\replay.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\replay.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\src\rle.cpp
 # End Source File
 # Begin Source File
@@ -520,6 +576,18 @@ SOURCE=..\src\savegame.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\src\savewriter.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\savewriter.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\savewriter_sdl.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\src\scale.cpp
 # End Source File
 # Begin Source File
@@ -564,6 +632,14 @@ SOURCE=..\src\shrine.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\src\snapshot.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\src\snapshot.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\src\sound.cpp
 # End Source File
 # Begin Source File
@@ -632,6 +708,10 @@ SOURCE=..\src\tileset.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\src\timedevent.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\src\types.h
 # End Source File
 # Begin Source File